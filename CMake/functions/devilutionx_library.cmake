@@ -63,6 +63,11 @@ function(add_devilutionx_library NAME)
       endif()
     endif()
 
+    if(BUILD_FUZZERS)
+      # Coverage feedback for libFuzzer, the fuzzer runtime itself is only linked into the fuzz targets.
+      target_compile_options(${NAME} PUBLIC -fsanitize=fuzzer-no-link)
+    endif()
+
     target_compile_definitions(${NAME} PRIVATE _DVL_EXPORTING)
   endif()
 
@@ -27,6 +27,8 @@ set(SDL1_FORCE_SVID_VIDEO_MODE ON)
 set(SDL1_VIDEO_MODE_BPP 8)
 set(DEFAULT_WIDTH 800)
 set(DEFAULT_HEIGHT 480)
+#Keep the resident sound effects small, everything else is loaded again on use
+set(DEFAULT_SFX_MEMORY_BUDGET 8)
 
 #SDL Joystick axis mapping (circle-pad/C-stick)
 set(JOY_AXIS_LEFTX 0)
@@ -20,6 +20,7 @@
 #include "dx.h"
 #include "hwcursor.hpp"
 #include "palette.h"
+#include "sound.h"
 #include "utils/display.h"
 #include "utils/language.h"
 #include "utils/log.hpp"
@@ -755,6 +756,8 @@ void UiPollAndRender(std::function<bool(SDL_Event &)> eventHandler)
 		UiHandleEvents(&event);
 	}
 	HandleMenuAction(GetMenuHeldUpDownAction());
+	// The game loop isn't running, pick up the sounds the loader thread finished here
+	sound_process_loads();
 	UiRenderItems(gUiItems);
 	DrawMouse();
 	UiFadeIn();
@@ -3,6 +3,7 @@
 #include <cstring>
 
 #include "appfat.h"
+#include "codec.h"
 #include "sha.h"
 #include "utils/endian.hpp"
 #include "utils/log.hpp"
@@ -17,8 +18,8 @@ struct CodecSignature {
 	uint8_t lastChunkSize;
 };
 
-constexpr size_t BlockSizeBytes = BlockSize * sizeof(uint32_t);
-constexpr size_t SignatureSize = 8;
+constexpr size_t BlockSizeBytes = CodecDecoder::ChunkSize;
+constexpr size_t SignatureSize = CodecDecoder::SignatureSize;
 
 SHA1Context CodecInitKey(const char *pszPassword)
 {
@@ -52,7 +53,7 @@ SHA1Context CodecInitKey(const char *pszPassword)
 	return context;
 }
 
-CodecSignature GetCodecSignature(byte *src)
+CodecSignature GetCodecSignature(const byte *src)
 {
 	CodecSignature result;
 	result.checksum = LoadLE32(src);
@@ -88,42 +89,55 @@ void XorBlock(const uint32_t *shaResult, uint32_t *out)
 
 } // namespace
 
-std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPassword)
+CodecDecoder::CodecDecoder(const char *pszPassword)
+    : context_(CodecInitKey(pszPassword))
+{
+}
+
+void CodecDecoder::Decode(byte *data, size_t size)
 {
 	uint32_t buf[BlockSize];
 	uint32_t dst[SHA1HashSize];
 
-	SHA1Context context = CodecInitKey(pszPassword);
-	if (size <= SignatureSize)
-		return 0;
-	size -= SignatureSize;
-	if (size % BlockSize != 0)
-		return 0;
-	for (size_t i = 0; i < size; pbSrcDst += BlockSizeBytes, i += BlockSizeBytes) {
-		memcpy(buf, pbSrcDst, BlockSizeBytes);
+	for (size_t i = 0; i < size; data += BlockSizeBytes, i += BlockSizeBytes) {
+		memcpy(buf, data, BlockSizeBytes);
 		ByteSwapBlock(buf);
-		SHA1Result(context, dst);
+		SHA1Result(context_, dst);
 		XorBlock(dst, buf);
-		SHA1Calculate(context, buf);
+		SHA1Calculate(context_, buf);
 		ByteSwapBlock(buf);
-		memcpy(pbSrcDst, buf, BlockSizeBytes);
+		memcpy(data, buf, BlockSizeBytes);
 	}
+}
 
-	memset(buf, 0, sizeof(buf));
-	const CodecSignature sig = GetCodecSignature(pbSrcDst);
-	if (sig.error > 0) {
+size_t CodecDecoder::Finish(const byte *signature, size_t encodedSize)
+{
+	const CodecSignature sig = GetCodecSignature(signature);
+	if (sig.error > 0 || encodedSize == 0 || sig.lastChunkSize > BlockSizeBytes) {
 		return 0;
 	}
 
-	SHA1Result(context, dst);
+	uint32_t dst[SHA1HashSize];
+	SHA1Result(context_, dst);
 	if (sig.checksum != dst[0]) {
 		LogError("Checksum mismatch signature={} vs calculated={}", sig.checksum, dst[0]);
-		memset(dst, 0, sizeof(dst));
 		return 0;
 	}
 
-	size += sig.lastChunkSize - BlockSizeBytes;
-	return size;
+	return encodedSize + sig.lastChunkSize - BlockSizeBytes;
+}
+
+std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPassword)
+{
+	if (size <= SignatureSize)
+		return 0;
+	size -= SignatureSize;
+	if (size % BlockSizeBytes != 0)
+		return 0;
+
+	CodecDecoder decoder(pszPassword);
+	decoder.Decode(pbSrcDst, size);
+	return decoder.Finish(pbSrcDst + size, size);
 }
 
 std::size_t codec_get_encoded_len(std::size_t dwSrcBytes)
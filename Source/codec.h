@@ -5,10 +5,43 @@
  */
 #pragma once
 
+#include <cstdint>
+
+#include "sha.h"
 #include "utils/stdcompat/cstddef.hpp"
 
 namespace devilution {
 
+/**
+ * @brief Decodes a save file piece by piece, for callers that receive it in chunks.
+ *
+ * Produces the same result as codec_decode, but the checksum is only known once the signature
+ * at the end of the file has been passed to Finish.
+ */
+class CodecDecoder {
+public:
+	/** Size of the signature that follows the encoded data. */
+	static constexpr size_t SignatureSize = 8;
+	/** Data has to be passed to Decode in multiples of this size. */
+	static constexpr size_t ChunkSize = BlockSize * sizeof(uint32_t);
+
+	explicit CodecDecoder(const char *pszPassword);
+
+	/** @brief Decodes the next chunks of the file in place, size must be a multiple of ChunkSize. */
+	void Decode(byte *data, size_t size);
+
+	/**
+	 * @brief Checks the signature after all data has been decoded.
+	 * @param signature The last SignatureSize bytes of the file.
+	 * @param encodedSize Total size of the data passed to Decode.
+	 * @return Size of the decoded file without padding, or 0 if the file is corrupt.
+	 */
+	size_t Finish(const byte *signature, size_t encodedSize);
+
+private:
+	SHA1Context context_;
+};
+
 std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPassword);
 std::size_t codec_get_encoded_len(std::size_t dwSrcBytes);
 void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size_64, const char *pszPassword);
@@ -180,6 +180,7 @@ std::string DebugCmdGiveGoldCheat(const string_view parameter)
 
 		myPlayer._pGold += goldItem._ivalue;
 	}
+	myPlayer.MarkStatsDirty(PlayerStatsDirty::Inventory);
 	CalcPlrInv(myPlayer, true);
 
 	return "You are now rich! If only this was as easy in real life...";
@@ -48,6 +48,7 @@
 #include "missiles.h"
 #include "movie.h"
 #include "multi.h"
+#include "netprofile.h"
 #include "nthread.h"
 #include "objects.h"
 #include "options.h"
@@ -835,6 +836,9 @@ void RunGameLoop(interface_mode uMsg)
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--record <#>", _("Record a demo file").c_str());
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--demo <#>", _("Play a demo file").c_str());
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--timedemo", _("Disable all frame limiting during demo playback").c_str());
+	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--net-profile", _("Log network traffic statistics").c_str());
+	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--net-capture <#>", _("Record a network capture file").c_str());
+	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--net-replay <#>", _("Replay a network capture file in a loopback game").c_str());
 	printInConsole("%s", _(/* TRANSLATORS: Commandline Option */ "\nGame selection:\n").c_str());
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--spawn", _("Force Shareware mode").c_str());
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--diablo", _("Force Diablo mode").c_str());
@@ -858,6 +862,8 @@ void DiabloParseFlags(int argc, char **argv)
 	bool timedemo = false;
 	int demoNumber = -1;
 	int recordNumber = -1;
+	int captureNumber = -1;
+	int replayNumber = -1;
 	for (int i = 1; i < argc; i++) {
 		const string_view arg = argv[i];
 		if (arg == "-h" || arg == "--help") {
@@ -898,6 +904,20 @@ void DiabloParseFlags(int argc, char **argv)
 				diablo_quit(0);
 			}
 			recordNumber = SDL_atoi(argv[++i]);
+		} else if (arg == "--net-profile") {
+			netprofile::EnableProfiling();
+		} else if (arg == "--net-capture") {
+			if (i + 1 == argc) {
+				printInConsole("%s requires an argument\n", "--net-capture");
+				diablo_quit(0);
+			}
+			captureNumber = SDL_atoi(argv[++i]);
+		} else if (arg == "--net-replay") {
+			if (i + 1 == argc) {
+				printInConsole("%s requires an argument\n", "--net-replay");
+				diablo_quit(0);
+			}
+			replayNumber = SDL_atoi(argv[++i]);
 		} else if (arg == "-n") {
 			gbShowIntro = false;
 		} else if (arg == "-f") {
@@ -940,6 +960,10 @@ void DiabloParseFlags(int argc, char **argv)
 		demo::InitPlayBack(demoNumber, timedemo);
 	if (recordNumber != -1)
 		demo::InitRecording(recordNumber);
+	if (captureNumber != -1)
+		netprofile::InitCapture(captureNumber);
+	if (replayNumber != -1)
+		netprofile::InitReplay(replayNumber);
 }
 
 void DiabloInitScreen()
@@ -1836,6 +1860,7 @@ bool TryIconCurs()
 		else if (pcursstashitem != uint16_t(-1)) {
 			Item &item = Stash.stashList[pcursstashitem];
 			item._iIdentified = true;
+			Stash.MarkPageDirty(Stash.GetPage());
 		}
 		NewCursor(CURSOR_HAND);
 		return true;
@@ -1847,6 +1872,7 @@ bool TryIconCurs()
 		else if (pcursstashitem != uint16_t(-1)) {
 			Item &item = Stash.stashList[pcursstashitem];
 			RepairItem(item, myPlayer._pLevel);
+			Stash.MarkPageDirty(Stash.GetPage());
 		}
 		NewCursor(CURSOR_HAND);
 		return true;
@@ -1858,6 +1884,7 @@ bool TryIconCurs()
 		else if (pcursstashitem != uint16_t(-1)) {
 			Item &item = Stash.stashList[pcursstashitem];
 			RechargeItem(item, myPlayer);
+			Stash.MarkPageDirty(Stash.GetPage());
 		}
 		NewCursor(CURSOR_HAND);
 		return true;
@@ -1870,6 +1897,7 @@ bool TryIconCurs()
 		else if (pcursstashitem != uint16_t(-1)) {
 			Item &item = Stash.stashList[pcursstashitem];
 			changeCursor = ApplyOilToItem(item, myPlayer);
+			Stash.MarkPageDirty(Stash.GetPage());
 		}
 		if (changeCursor)
 			NewCursor(CURSOR_HAND);
@@ -4,12 +4,17 @@
  * Implementation of functions for updating game state from network commands.
  */
 
-#include <list>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <mutex>
 
+#include "dthread.h"
 #include "nthread.h"
+#include "utils/log.hpp"
 #include "utils/sdl_cond.h"
 #include "utils/sdl_thread.h"
+#include "utils/spsc_queue.hpp"
 
 namespace devilution {
 
@@ -18,41 +23,100 @@ struct DThreadPkt {
 	_cmd_id cmd;
 	std::unique_ptr<byte[]> data;
 	uint32_t len;
+	/** Cancellation token of the player at the time the packet was queued. */
+	uint32_t generation;
+	/** Tick count at the time the packet was queued. */
+	uint32_t queuedAt;
+
+	DThreadPkt() = default;
 
 	DThreadPkt(int pnum, _cmd_id(cmd), std::unique_ptr<byte[]> data, uint32_t len)
 	    : pnum(pnum)
 	    , cmd(cmd)
 	    , data(std::move(data))
 	    , len(len)
+	    , generation(0)
+	    , queuedAt(0)
 	{
 	}
 };
 
 namespace {
 
+/** Room for every other player joining at once (all levels, junk, end marker and player info). */
+constexpr size_t MaxQueuedPackets = MAX_PLRS * (NUMLEVELS + 4);
+
+SpscQueue<DThreadPkt, MaxQueuedPackets> InfoQueue;
+/** Bumped to drop every packet already queued for a player. */
+std::array<std::atomic<uint32_t>, MAX_PLRS> PlayerGenerations;
+std::atomic<bool> DthreadRunning;
+/** Set while the delta thread is about to sleep, so the producer only takes the mutex when needed. */
+std::atomic<bool> DthreadWaiting;
+/** Only guards the sleep/wake handshake, the queue itself is never locked. */
 std::optional<SdlMutex> DthreadMutex;
-std::list<DThreadPkt> InfoList;
-bool DthreadRunning;
 std::optional<SdlCond> WorkToDo;
 
+struct {
+	std::atomic<uint32_t> maxQueueDepth;
+	std::atomic<uint32_t> packetsSent;
+	std::atomic<uint32_t> packetsCancelled;
+	std::atomic<uint32_t> totalSendLatency;
+	std::atomic<uint32_t> maxSendLatency;
+} Stats;
+
 /* rdata */
 SdlThread Thread;
 
-void DthreadHandler()
+void StoreMax(std::atomic<uint32_t> &target, uint32_t value)
+{
+	uint32_t current = target.load(std::memory_order_relaxed);
+	while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+void WakeDthread()
 {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!DthreadWaiting.load(std::memory_order_relaxed))
+		return;
+
 	std::lock_guard<SdlMutex> lock(*DthreadMutex);
-	while (true) {
-		while (!InfoList.empty()) {
-			DThreadPkt pkt = std::move(InfoList.front());
-			InfoList.pop_front();
+	WorkToDo->signal();
+}
 
-			DthreadMutex->unlock();
-			multi_send_zero_packet(pkt.pnum, pkt.cmd, pkt.data.get(), pkt.len);
-			DthreadMutex->lock();
+void SendQueuedPackets()
+{
+	DThreadPkt pkt;
+	while (InfoQueue.try_pop(pkt)) {
+		if (!DthreadRunning.load(std::memory_order_relaxed))
+			continue;
+		if (pkt.generation != PlayerGenerations[pkt.pnum].load(std::memory_order_acquire)) {
+			Stats.packetsCancelled.fetch_add(1, std::memory_order_relaxed);
+			continue;
 		}
+
+		multi_send_zero_packet(pkt.pnum, pkt.cmd, pkt.data.get(), pkt.len);
+
+		const uint32_t latency = SDL_GetTicks() - pkt.queuedAt;
+		Stats.packetsSent.fetch_add(1, std::memory_order_relaxed);
+		Stats.totalSendLatency.fetch_add(latency, std::memory_order_relaxed);
+		StoreMax(Stats.maxSendLatency, latency);
+	}
+}
+
+void DthreadHandler()
+{
+	while (true) {
+		SendQueuedPackets();
+
+		std::lock_guard<SdlMutex> lock(*DthreadMutex);
 		if (!DthreadRunning)
 			return;
-		WorkToDo->wait(*DthreadMutex);
+		DthreadWaiting.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (InfoQueue.empty())
+			WorkToDo->wait(*DthreadMutex);
+		DthreadWaiting.store(false, std::memory_order_relaxed);
 	}
 }
 
@@ -60,10 +124,7 @@ void DthreadHandler()
 
 void dthread_remove_player(uint8_t pnum)
 {
-	std::lock_guard<SdlMutex> lock(*DthreadMutex);
-	InfoList.remove_if([&](auto &pkt) {
-		return pkt.pnum == pnum;
-	});
+	PlayerGenerations[pnum].fetch_add(1, std::memory_order_release);
 }
 
 void dthread_send_delta(int pnum, _cmd_id cmd, std::unique_ptr<byte[]> data, uint32_t len)
@@ -72,10 +133,28 @@ void dthread_send_delta(int pnum, _cmd_id cmd, std::unique_ptr<byte[]> data, uin
 		return;
 
 	DThreadPkt pkt { pnum, cmd, std::move(data), len };
+	pkt.generation = PlayerGenerations[pnum].load(std::memory_order_acquire);
+	pkt.queuedAt = SDL_GetTicks();
 
-	std::lock_guard<SdlMutex> lock(*DthreadMutex);
-	InfoList.push_back(std::move(pkt));
-	WorkToDo->signal();
+	while (!InfoQueue.try_push(pkt)) {
+		// Only happens when several players join at the same time
+		WakeDthread();
+		SDL_Delay(1);
+	}
+
+	StoreMax(Stats.maxQueueDepth, static_cast<uint32_t>(InfoQueue.size()));
+	WakeDthread();
+}
+
+DThreadStats dthread_get_stats()
+{
+	DThreadStats stats;
+	stats.maxQueueDepth = Stats.maxQueueDepth.load(std::memory_order_relaxed);
+	stats.packetsSent = Stats.packetsSent.load(std::memory_order_relaxed);
+	stats.packetsCancelled = Stats.packetsCancelled.load(std::memory_order_relaxed);
+	stats.totalSendLatency = Stats.totalSendLatency.load(std::memory_order_relaxed);
+	stats.maxSendLatency = Stats.maxSendLatency.load(std::memory_order_relaxed);
+	return stats;
 }
 
 void dthread_start()
@@ -83,7 +162,14 @@ void dthread_start()
 	if (!gbIsMultiplayer)
 		return;
 
+	Stats.maxQueueDepth = 0;
+	Stats.packetsSent = 0;
+	Stats.packetsCancelled = 0;
+	Stats.totalSendLatency = 0;
+	Stats.maxSendLatency = 0;
+
 	DthreadRunning = true;
+	DthreadWaiting = false;
 	DthreadMutex.emplace();
 	WorkToDo.emplace();
 	Thread = SdlThread { DthreadHandler };
@@ -97,11 +183,21 @@ void DThreadCleanup()
 	{
 		std::lock_guard<SdlMutex> lock(*DthreadMutex);
 		DthreadRunning = false;
-		InfoList.clear();
 		WorkToDo->signal();
 	}
 
 	Thread.join();
+
+	// The delta thread is gone, discard whatever it did not get to
+	DThreadPkt pkt;
+	while (InfoQueue.try_pop(pkt)) {
+	}
+
+	const DThreadStats stats = dthread_get_stats();
+	LogVerbose("Delta thread sent {} packets ({} cancelled), max queue depth {}, send latency avg {} ms max {} ms",
+	    stats.packetsSent, stats.packetsCancelled, stats.maxQueueDepth,
+	    stats.packetsSent != 0 ? stats.totalSendLatency / stats.packetsSent : 0, stats.maxSendLatency);
+
 	DthreadMutex = std::nullopt;
 	WorkToDo = std::nullopt;
 }
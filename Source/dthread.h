@@ -7,12 +7,28 @@
 
 #include <memory>
 
+#include "msg.h"
 #include "utils/stdcompat/cstddef.hpp"
 
 namespace devilution {
 
+struct DThreadStats {
+	/** Largest number of packets that were waiting to be sent at once. */
+	uint32_t maxQueueDepth;
+	uint32_t packetsSent;
+	/** Packets dropped because their player left before they were sent. */
+	uint32_t packetsCancelled;
+	/** Sum of the times between queuing and sending each packet, in milliseconds. */
+	uint32_t totalSendLatency;
+	uint32_t maxSendLatency;
+};
+
+/**
+ * @brief Drops all packets queued for the given player that have not been sent yet.
+ */
 void dthread_remove_player(uint8_t pnum);
 void dthread_send_delta(int pnum, _cmd_id cmd, std::unique_ptr<byte[]> data, uint32_t len);
+DThreadStats dthread_get_stats();
 void dthread_start();
 void DThreadCleanup();
 
@@ -58,6 +58,15 @@ public:
 	{
 	}
 
+	/**
+	 * @brief Retrieves the round trip latency to the slowest connected player.
+	 * @return false if the provider does not measure latency or no measurement is available yet
+	 */
+	virtual bool SNetGetLatency(uint32_t *latency, uint32_t *jitter)
+	{
+		return false;
+	}
+
 	virtual std::vector<GameInfo> get_gamelist()
 	{
 		return std::vector<GameInfo>();
@@ -4,9 +4,18 @@
 #include <cstring>
 #include <memory>
 
+#include "dvlnet/buffer_pool.h"
+
 namespace devilution {
 namespace net {
 
+namespace {
+
+/** How often to measure the round trip latency to the other players, in milliseconds. */
+constexpr timestamp_t EchoRequestInterval = 1000;
+
+} // namespace
+
 void base::setup_gameinfo(buffer_t info)
 {
 	game_init_info = std::move(info);
@@ -46,6 +55,19 @@ void base::SendEchoRequest(plr_t player)
 	send(*echo);
 }
 
+void base::SendEchoRequests()
+{
+	timestamp_t now = SDL_GetTicks();
+	if (now - lastEchoRequest_ < EchoRequestInterval)
+		return;
+	lastEchoRequest_ = now;
+
+	for (plr_t player = 0; player < MAX_PLRS; player++) {
+		if (IsConnected(player))
+			SendEchoRequest(player);
+	}
+}
+
 void base::HandleAccept(packet &pkt)
 {
 	if (plr_self != PLR_BROADCAST) {
@@ -101,8 +123,7 @@ void base::HandleDisconnect(packet &pkt)
 			DisconnectNet(newPlayer);
 			ClearMsg(newPlayer);
 			PlayerState &playerState = playerStateTable_[newPlayer];
-			playerState.isConnected = false;
-			playerState.turnQueue.clear();
+			playerState = {};
 		}
 	} else {
 		ABORT(); // we were dropped by the owner?!?
@@ -120,7 +141,18 @@ void base::HandleEchoReply(packet &pkt)
 	uint32_t now = SDL_GetTicks();
 	plr_t src = pkt.Source();
 	PlayerState &playerState = playerStateTable_[src];
-	playerState.roundTripLatency = now - pkt.Time();
+	uint32_t latency = now - pkt.Time();
+	playerState.roundTripLatency = latency;
+
+	// Same smoothing as the TCP retransmission timer (RFC 6298)
+	if (playerState.smoothedLatency == 0) {
+		playerState.smoothedLatency = latency;
+		playerState.latencyDeviation = latency / 2;
+	} else {
+		uint32_t deviation = latency > playerState.smoothedLatency ? latency - playerState.smoothedLatency : playerState.smoothedLatency - latency;
+		playerState.latencyDeviation = (3 * playerState.latencyDeviation + deviation) / 4;
+		playerState.smoothedLatency = (7 * playerState.smoothedLatency + latency) / 8;
+	}
 }
 
 void base::ClearMsg(plr_t plr)
@@ -156,7 +188,7 @@ void base::RecvLocal(packet &pkt)
 	}
 	switch (pkt.Type()) {
 	case PT_MESSAGE:
-		message_queue.emplace_back(pkt.Source(), pkt.Message());
+		message_queue.emplace_back(pkt.Source(), pkt.TakeMessage());
 		break;
 	case PT_TURN:
 		HandleTurn(pkt);
@@ -187,7 +219,8 @@ bool base::SNetReceiveMessage(int *sender, void **data, uint32_t *size)
 	poll();
 	if (message_queue.empty())
 		return false;
-	message_last = message_queue.front();
+	ReleaseBuffer(std::move(message_last.payload));
+	message_last = std::move(message_queue.front());
 	message_queue.pop_front();
 	*sender = message_last.sender;
 	*size = message_last.payload.size();
@@ -201,17 +234,23 @@ bool base::SNetSendMessage(int playerId, void *data, unsigned int size)
 	    && (playerId < 0 || playerId >= MAX_PLRS))
 		abort();
 	auto *rawMessage = reinterpret_cast<unsigned char *>(data);
-	buffer_t message(rawMessage, rawMessage + size);
-	if (playerId == plr_self || playerId == SNPLAYER_ALL)
-		message_queue.emplace_back(plr_self, message);
+	buffer_t message = AcquireBuffer();
+	message.assign(rawMessage, rawMessage + size);
+	if (playerId == plr_self || playerId == SNPLAYER_ALL) {
+		buffer_t localMessage = AcquireBuffer();
+		localMessage.assign(message.begin(), message.end());
+		message_queue.emplace_back(plr_self, std::move(localMessage));
+	}
 	plr_t dest;
 	if (playerId == SNPLAYER_ALL || playerId == SNPLAYER_OTHERS)
 		dest = PLR_BROADCAST;
 	else
 		dest = playerId;
 	if (dest != plr_self) {
-		auto pkt = pktfty->make_packet<PT_MESSAGE>(plr_self, dest, message);
+		auto pkt = pktfty->make_packet<PT_MESSAGE>(plr_self, dest, std::move(message));
 		send(*pkt);
+	} else {
+		ReleaseBuffer(std::move(message));
 	}
 	return true;
 }
@@ -236,6 +275,7 @@ bool base::AllTurnsArrived()
 bool base::SNetReceiveTurns(char **data, size_t *size, uint32_t *status)
 {
 	poll();
+	SendEchoRequests();
 
 	for (auto i = 0; i < MAX_PLRS; ++i) {
 		status[i] = 0;
@@ -441,5 +481,23 @@ bool base::SNetGetTurnsInTransit(uint32_t *turns)
 	return true;
 }
 
+bool base::SNetGetLatency(uint32_t *latency, uint32_t *jitter)
+{
+	bool measured = false;
+	*latency = 0;
+	*jitter = 0;
+	for (plr_t player = 0; player < MAX_PLRS; player++) {
+		if (player == plr_self || !IsConnected(player))
+			continue;
+		const PlayerState &playerState = playerStateTable_[player];
+		if (playerState.smoothedLatency == 0 && playerState.roundTripLatency == 0)
+			continue;
+		measured = true;
+		*latency = std::max(*latency, playerState.smoothedLatency);
+		*jitter = std::max(*jitter, playerState.latencyDeviation);
+	}
+	return measured;
+}
+
 } // namespace net
 } // namespace devilution
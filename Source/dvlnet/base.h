@@ -31,6 +31,7 @@ public:
 	virtual bool SNetDropPlayer(int playerid, uint32_t flags);
 	virtual bool SNetGetOwnerTurnsWaiting(uint32_t *turns);
 	virtual bool SNetGetTurnsInTransit(uint32_t *turns);
+	virtual bool SNetGetLatency(uint32_t *latency, uint32_t *jitter);
 
 	virtual void poll() = 0;
 	virtual void send(packet &pkt) = 0;
@@ -57,7 +58,7 @@ protected:
 		}
 		message_t(int s, buffer_t p)
 		    : sender(s)
-		    , payload(p)
+		    , payload(std::move(p))
 		{
 		}
 	};
@@ -67,6 +68,10 @@ protected:
 		std::deque<turn_t> turnQueue;
 		int32_t lastTurnValue = {};
 		uint32_t roundTripLatency = {};
+		/** Round trip latency averaged over recent echo replies, in milliseconds. */
+		uint32_t smoothedLatency = {};
+		/** Mean deviation of the round trip latency, in milliseconds. */
+		uint32_t latencyDeviation = {};
 	};
 
 	seq_t next_turn = 0;
@@ -89,6 +94,7 @@ protected:
 private:
 	std::array<PlayerState, MAX_PLRS> playerStateTable_;
 	bool awaitingSequenceNumber_ = true;
+	timestamp_t lastEchoRequest_ = 0;
 
 	plr_t GetOwner();
 	bool AllTurnsArrived();
@@ -96,6 +102,7 @@ private:
 	void SendTurnIfReady(turn_t turn);
 	void SendFirstTurnIfReady(plr_t player);
 	void ClearMsg(plr_t plr);
+	void SendEchoRequests();
 
 	void HandleAccept(packet &pkt);
 	void HandleConnect(packet &pkt);
@@ -0,0 +1,40 @@
+#include "dvlnet/buffer_pool.h"
+
+#include <utility>
+
+namespace devilution {
+namespace net {
+
+namespace {
+
+constexpr size_t MaxPooledBuffers = 64;
+/** Larger buffers are freed instead, so a single huge message doesn't stay allocated forever. */
+constexpr size_t MaxPooledCapacity = 2 * frame_queue::max_frame_size;
+
+thread_local std::vector<buffer_t> FreeBuffers;
+
+} // namespace
+
+buffer_t AcquireBuffer()
+{
+	if (FreeBuffers.empty())
+		return {};
+	buffer_t buf = std::move(FreeBuffers.back());
+	FreeBuffers.pop_back();
+	return buf;
+}
+
+void ReleaseBuffer(buffer_t &&buf)
+{
+	if (buf.capacity() == 0 || buf.capacity() > MaxPooledCapacity)
+		return;
+	if (FreeBuffers.size() >= MaxPooledBuffers)
+		return;
+	if (FreeBuffers.capacity() == 0)
+		FreeBuffers.reserve(MaxPooledBuffers);
+	buf.clear();
+	FreeBuffers.push_back(std::move(buf));
+}
+
+} // namespace net
+} // namespace devilution
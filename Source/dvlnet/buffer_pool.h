@@ -0,0 +1,21 @@
+#pragma once
+
+#include "dvlnet/frame_queue.h"
+
+namespace devilution {
+namespace net {
+
+/**
+ * @brief Returns an empty buffer, reusing the storage of a previously released buffer if possible.
+ *
+ * Buffers are pooled per thread, so a buffer may be released on a different thread than it was acquired on.
+ */
+buffer_t AcquireBuffer();
+
+/**
+ * @brief Hands the storage of a buffer that is no longer needed back to the pool.
+ */
+void ReleaseBuffer(buffer_t &&buf);
+
+} // namespace net
+} // namespace devilution
@@ -38,6 +38,7 @@ public:
 	virtual bool SNetDropPlayer(int playerid, uint32_t flags);
 	virtual bool SNetGetOwnerTurnsWaiting(uint32_t *turns);
 	virtual bool SNetGetTurnsInTransit(uint32_t *turns);
+	virtual bool SNetGetLatency(uint32_t *latency, uint32_t *jitter);
 	virtual void setup_gameinfo(buffer_t info);
 	virtual std::string make_default_gamename();
 	virtual bool send_info_request();
@@ -168,6 +169,12 @@ bool cdwrap<T>::SNetGetTurnsInTransit(uint32_t *turns)
 	return dvlnet_wrap->SNetGetTurnsInTransit(turns);
 }
 
+template <class T>
+bool cdwrap<T>::SNetGetLatency(uint32_t *latency, uint32_t *jitter)
+{
+	return dvlnet_wrap->SNetGetLatency(latency, jitter);
+}
+
 template <class T>
 std::string cdwrap<T>::make_default_gamename()
 {
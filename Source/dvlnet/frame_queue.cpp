@@ -2,6 +2,7 @@
 
 #include <cstring>
 
+#include "dvlnet/buffer_pool.h"
 #include "dvlnet/packet.h"
 
 namespace devilution {
@@ -16,13 +17,14 @@ buffer_t frame_queue::Read(framesize_t s)
 {
 	if (current_size < s)
 		throw frame_queue_exception();
-	buffer_t ret;
+	buffer_t ret = AcquireBuffer();
 	while (s > 0 && s >= buffer_deque.front().size()) {
 		s -= buffer_deque.front().size();
 		current_size -= buffer_deque.front().size();
 		ret.insert(ret.end(),
 		    buffer_deque.front().begin(),
 		    buffer_deque.front().end());
+		ReleaseBuffer(std::move(buffer_deque.front()));
 		buffer_deque.pop_front();
 	}
 	if (s > 0) {
@@ -64,7 +66,7 @@ buffer_t frame_queue::ReadPacket()
 	return ret;
 }
 
-buffer_t frame_queue::MakeFrame(buffer_t packetbuf)
+buffer_t frame_queue::MakeFrame(const buffer_t &packetbuf)
 {
 	buffer_t ret;
 	if (packetbuf.size() > max_frame_size)
@@ -37,7 +37,7 @@ public:
 	buffer_t ReadPacket();
 	void Write(buffer_t buf);
 
-	static buffer_t MakeFrame(buffer_t packetbuf);
+	static buffer_t MakeFrame(const buffer_t &packetbuf);
 };
 
 } // namespace net
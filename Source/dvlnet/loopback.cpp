@@ -1,6 +1,7 @@
 #include "dvlnet/loopback.h"
 
 #include "multi.h"
+#include "netprofile.h"
 #include "utils/language.h"
 #include "utils/stubs.h"
 
@@ -20,7 +21,7 @@ int loopback::join(std::string /*addrstr*/)
 bool loopback::SNetReceiveMessage(int *sender, void **data, uint32_t *size)
 {
 	if (message_queue.empty())
-		return false;
+		return netprofile::IsReplaying() && netprofile::FetchReplayPacket(sender, data, size);
 	message_last = message_queue.front();
 	message_queue.pop();
 	*sender = plr_single;
@@ -6,6 +6,8 @@
 #endif
 
 #include <cassert>
+#include <new>
+#include <vector>
 
 #include "dvlnet/packet.h"
 
@@ -102,6 +104,54 @@ wrong_packet_type_exception::wrong_packet_type_exception(std::initializer_list<p
 
 namespace {
 
+/** Upper bound for the size of the fixed size fields of any packet type. */
+constexpr size_t MaxFixedFieldsSize = 32;
+
+constexpr size_t MaxPooledPackets = 32;
+
+static_assert(sizeof(packet_in) == sizeof(packet), "packet_in must fit into a pooled packet");
+static_assert(sizeof(packet_out) == sizeof(packet), "packet_out must fit into a pooled packet");
+
+/**
+ * @brief Packets freed on this thread, handed out again by packet::operator new.
+ *
+ * A packet freed on another thread than the one that allocated it ends up in the freeing
+ * thread's pool. Every pool is capped at MaxPooledPackets, which bounds that drift.
+ */
+class PacketPool {
+public:
+	~PacketPool()
+	{
+		for (void *ptr : free_)
+			::operator delete(ptr);
+	}
+
+	void *Acquire()
+	{
+		if (free_.empty())
+			return nullptr;
+		void *ptr = free_.back();
+		free_.pop_back();
+		return ptr;
+	}
+
+	/** @return false if the pool is full and the caller has to free the block. */
+	bool Release(void *ptr)
+	{
+		if (free_.size() >= MaxPooledPackets)
+			return false;
+		if (free_.capacity() == 0)
+			free_.reserve(MaxPooledPackets);
+		free_.push_back(ptr);
+		return true;
+	}
+
+private:
+	std::vector<void *> free_;
+};
+
+thread_local PacketPool FreePackets;
+
 void CheckPacketTypeOneOf(std::initializer_list<packet_type> expectedTypes, std::uint8_t actualType)
 {
 	for (std::uint8_t packetType : expectedTypes)
@@ -112,6 +162,28 @@ void CheckPacketTypeOneOf(std::initializer_list<packet_type> expectedTypes, std:
 
 } // namespace
 
+packet::~packet()
+{
+	ReleaseBuffer(std::move(m_message));
+	ReleaseBuffer(std::move(m_info));
+	ReleaseBuffer(std::move(encrypted_buffer));
+	ReleaseBuffer(std::move(decrypted_buffer));
+}
+
+void *packet::operator new(size_t size)
+{
+	void *ptr = size == sizeof(packet) ? FreePackets.Acquire() : nullptr;
+	if (ptr == nullptr)
+		return ::operator new(size);
+	return ptr;
+}
+
+void packet::operator delete(void *ptr)
+{
+	if (!FreePackets.Release(ptr))
+		::operator delete(ptr);
+}
+
 const buffer_t &packet::Data()
 {
 	assert(have_encrypted || have_decrypted);
@@ -145,6 +217,13 @@ const buffer_t &packet::Message()
 	return m_message;
 }
 
+buffer_t packet::TakeMessage()
+{
+	assert(have_decrypted);
+	CheckPacketTypeOneOf({ PT_MESSAGE }, m_type);
+	return std::move(m_message);
+}
+
 turn_t packet::Turn()
 {
 	assert(have_decrypted);
@@ -193,14 +272,10 @@ void packet_in::Create(buffer_t buf)
 	if (buf.size() < sizeof(packet_type) + 2 * sizeof(plr_t))
 		throw packet_exception();
 
+	// Parsing leaves the buffer intact, so Data() still returns the original
+	// data for the TCP server implementation to forward to clients
 	decrypted_buffer = std::move(buf);
 	have_decrypted = true;
-
-	// TCP server implementation forwards the original data to clients
-	// so although we are not decrypting anything,
-	// we save a copy in encrypted_buffer anyway
-	encrypted_buffer = decrypted_buffer;
-	have_encrypted = true;
 }
 
 #ifdef PACKET_ENCRYPTION
@@ -217,6 +292,8 @@ void packet_in::Decrypt(buffer_t buf)
 	auto pktlen = (encrypted_buffer.size()
 	    - crypto_secretbox_NONCEBYTES
 	    - crypto_secretbox_MACBYTES);
+	// Not decrypted in place, the TCP server forwards the encrypted data
+	decrypted_buffer = AcquireBuffer();
 	decrypted_buffer.resize(pktlen);
 	int status = crypto_secretbox_open_easy(
 	    decrypted_buffer.data(),
@@ -231,6 +308,15 @@ void packet_in::Decrypt(buffer_t buf)
 }
 #endif
 
+void packet_out::Serialize(size_t headerSize)
+{
+	assert(have_decrypted && decrypted_buffer.empty());
+	decrypted_buffer = AcquireBuffer();
+	decrypted_buffer.reserve(headerSize + MaxFixedFieldsSize + m_message.size() + m_info.size());
+	decrypted_buffer.resize(headerSize);
+	process_data();
+}
+
 #ifdef PACKET_ENCRYPTION
 void packet_out::Encrypt()
 {
@@ -239,21 +325,23 @@ void packet_out::Encrypt()
 	if (have_encrypted)
 		return;
 
-	auto lenCleartext = decrypted_buffer.size();
-	encrypted_buffer.insert(encrypted_buffer.begin(),
-	    crypto_secretbox_NONCEBYTES, 0);
-	encrypted_buffer.insert(encrypted_buffer.end(),
-	    crypto_secretbox_MACBYTES + lenCleartext, 0);
-	randombytes_buf(encrypted_buffer.data(), crypto_secretbox_NONCEBYTES);
+	// Serialize() left room for the nonce and MAC in front of the cleartext,
+	// so the ciphertext can overwrite it in place
+	constexpr size_t HeaderSize = crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+	assert(decrypted_buffer.size() >= HeaderSize);
+	auto lenCleartext = decrypted_buffer.size() - HeaderSize;
+	randombytes_buf(decrypted_buffer.data(), crypto_secretbox_NONCEBYTES);
 	int status = crypto_secretbox_easy(
-	    encrypted_buffer.data() + crypto_secretbox_NONCEBYTES,
-	    decrypted_buffer.data(),
+	    decrypted_buffer.data() + crypto_secretbox_NONCEBYTES,
+	    decrypted_buffer.data() + HeaderSize,
 	    lenCleartext,
-	    encrypted_buffer.data(),
+	    decrypted_buffer.data(),
 	    key.data());
 	if (status != 0)
 		ABORT();
 
+	encrypted_buffer = std::move(decrypted_buffer);
+	decrypted_buffer = buffer_t {};
 	have_encrypted = true;
 }
 #endif
@@ -5,12 +5,14 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <utility>
 
 #ifdef PACKET_ENCRYPTION
 #include <sodium.h>
 #endif
 
 #include "dvlnet/abstract_net.h"
+#include "dvlnet/buffer_pool.h"
 #include "utils/stubs.h"
 
 namespace devilution {
@@ -93,10 +95,20 @@ protected:
 	bool have_decrypted = false;
 	buffer_t encrypted_buffer;
 	buffer_t decrypted_buffer;
+	/** Number of bytes of decrypted_buffer that have already been parsed. */
+	size_t read_offset = 0;
 
 public:
 	packet(const key_t &k)
 	    : key(k) {};
+	~packet();
+
+	packet(const packet &) = delete;
+	packet &operator=(const packet &) = delete;
+
+	/** Packets are recycled through a free list, as one is created for every message sent or received. */
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr);
 
 	const buffer_t &Data();
 
@@ -104,6 +116,8 @@ public:
 	plr_t Source() const;
 	plr_t Destination() const;
 	const buffer_t &Message();
+	/** Moves the message payload out of the packet, the packet must not be used afterwards. */
+	buffer_t TakeMessage();
 	turn_t Turn();
 	cookie_t Cookie();
 	plr_t NewPlayer();
@@ -136,6 +150,11 @@ public:
 	template <packet_type t, typename... Args>
 	void create(Args... args);
 
+	/**
+	 * @brief Writes the packet fields to decrypted_buffer.
+	 * @param headerSize Bytes to leave free at the start of the buffer for in-place encryption.
+	 */
+	void Serialize(size_t headerSize);
 	void process_element(buffer_t &x);
 	template <class T>
 	void process_element(T &x);
@@ -193,18 +212,18 @@ void packet_proc<P>::process_data()
 
 inline void packet_in::process_element(buffer_t &x)
 {
-	x.insert(x.begin(), decrypted_buffer.begin(), decrypted_buffer.end());
-	decrypted_buffer.resize(0);
+	x = AcquireBuffer();
+	x.assign(decrypted_buffer.begin() + read_offset, decrypted_buffer.end());
+	read_offset = decrypted_buffer.size();
 }
 
 template <class T>
 void packet_in::process_element(T &x)
 {
-	if (decrypted_buffer.size() < sizeof(T))
+	if (decrypted_buffer.size() - read_offset < sizeof(T))
 		throw packet_exception();
-	std::memcpy(&x, decrypted_buffer.data(), sizeof(T));
-	decrypted_buffer.erase(decrypted_buffer.begin(),
-	    decrypted_buffer.begin() + sizeof(T));
+	std::memcpy(&x, decrypted_buffer.data() + read_offset, sizeof(T));
+	read_offset += sizeof(T);
 }
 
 template <>
@@ -265,7 +284,7 @@ inline void packet_out::create<PT_JOIN_REQUEST>(plr_t s, plr_t d,
 	m_src = s;
 	m_dest = d;
 	m_cookie = c;
-	m_info = i;
+	m_info = std::move(i);
 }
 
 template <>
@@ -280,7 +299,7 @@ inline void packet_out::create<PT_JOIN_ACCEPT>(plr_t s, plr_t d, cookie_t c,
 	m_dest = d;
 	m_cookie = c;
 	m_newplr = n;
-	m_info = i;
+	m_info = std::move(i);
 }
 
 template <>
@@ -293,7 +312,7 @@ inline void packet_out::create<PT_CONNECT>(plr_t s, plr_t d, plr_t n, buffer_t i
 	m_src = s;
 	m_dest = d;
 	m_newplr = n;
-	m_info = i;
+	m_info = std::move(i);
 }
 
 template <>
@@ -380,7 +399,7 @@ public:
 	packet_factory(std::string pw);
 	std::unique_ptr<packet> make_packet(buffer_t buf);
 	template <packet_type t, typename... Args>
-	std::unique_ptr<packet> make_packet(Args... args);
+	std::unique_ptr<packet> make_packet(Args &&...args);
 };
 
 inline std::unique_ptr<packet> packet_factory::make_packet(buffer_t buf)
@@ -399,14 +418,19 @@ inline std::unique_ptr<packet> packet_factory::make_packet(buffer_t buf)
 }
 
 template <packet_type t, typename... Args>
-std::unique_ptr<packet> packet_factory::make_packet(Args... args)
+std::unique_ptr<packet> packet_factory::make_packet(Args &&...args)
 {
 	auto ret = std::make_unique<packet_out>(key);
-	ret->create<t>(args...);
-	ret->process_data();
+	ret->create<t>(std::forward<Args>(args)...);
 #ifdef PACKET_ENCRYPTION
-	if (secure)
+	if (secure) {
+		ret->Serialize(crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES);
 		ret->Encrypt();
+	} else {
+		ret->Serialize(0);
+	}
+#else
+	ret->Serialize(0);
 #endif
 	return ret;
 }
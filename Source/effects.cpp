@@ -7,6 +7,7 @@
 
 #include "engine/random.hpp"
 #include "init.h"
+#include "options.h"
 #include "player.h"
 #include "sound.h"
 #include "sound_defs.hpp"
@@ -1116,10 +1117,9 @@ void PlaySfxPriv(TSFX *pSFX, bool loc, Point position)
 	}
 
 	if (pSFX->pSnd == nullptr)
-		pSFX->pSnd = sound_file_load(pSFX->pszName);
+		pSFX->pSnd = sound_file_load_async(pSFX->pszName);
 
-	if (pSFX->pSnd != nullptr && pSFX->pSnd->DSB.IsLoaded())
-		snd_play_snd(pSFX->pSnd.get(), lVolume, lPan);
+	snd_play_snd(pSFX->pSnd.get(), lVolume, lPan);
 }
 
 _sfx_id RndSFX(_sfx_id psfx)
@@ -1154,12 +1154,20 @@ _sfx_id RndSFX(_sfx_id psfx)
 	return static_cast<_sfx_id>(psfx + GenerateRnd(nRand));
 }
 
+/**
+ * @brief Starts loading the sound effects matching the mask in the background.
+ *
+ * With a memory budget only the sounds that are needed right away are loaded up front, the rest is loaded on first use.
+ */
 void PrivSoundInit(BYTE bLoadMask)
 {
 	if (!gbSndInited) {
 		return;
 	}
 
+	if (*sgOptions.Audio.sfxMemoryBudget != 0)
+		bLoadMask &= ~sfx_MISC;
+
 	for (auto &sfx : sgSFX) {
 		if (sfx.pSnd != nullptr) {
 			continue;
@@ -1177,7 +1185,7 @@ void PrivSoundInit(BYTE bLoadMask)
 			continue;
 		}
 
-		sfx.pSnd = sound_file_load(sfx.pszName);
+		sfx.pSnd = sound_file_load_async(sfx.pszName);
 	}
 }
 
@@ -1215,7 +1223,7 @@ void InitMonsterSND(int monst)
 			for (int j = 0; j < 2; j++) {
 				char path[MAX_PATH];
 				sprintf(path, MonstersData[mtype].sndfile, MonstSndChar[i], j + 1);
-				LevelMonsterTypes[monst].Snds[i][j] = sound_file_load(path);
+				LevelMonsterTypes[monst].Snds[i][j] = sound_file_load_async(path);
 			}
 		}
 	}
@@ -1296,6 +1304,7 @@ void sound_update()
 	}
 
 	StreamUpdate();
+	sound_process_loads();
 }
 
 void effects_cleanup_sfx()
@@ -1350,6 +1359,9 @@ void effects_play_sound(const char *sndFile)
 		return;
 	}
 
+	// Menus don't run sound_update
+	sound_process_loads();
+
 	for (auto &sfx : sgSFX) {
 		if (strcasecmp(sfx.pszName, sndFile) == 0 && sfx.pSnd != nullptr) {
 			if (!sfx.pSnd->isPlaying())
@@ -1362,7 +1374,8 @@ void effects_play_sound(const char *sndFile)
 
 int GetSFXLength(int nSFX)
 {
-	if (sgSFX[nSFX].pSnd == nullptr)
+	// The length is needed right away, don't wait for the loader thread
+	if (sgSFX[nSFX].pSnd == nullptr || !sgSFX[nSFX].pSnd->DSB.IsLoaded())
 		sgSFX[nSFX].pSnd = sound_file_load(sgSFX[nSFX].pszName,
 		    /*stream=*/AllowStreaming && (sgSFX[nSFX].bFlags & sfx_STREAM) != 0);
 	return sgSFX[nSFX].pSnd->DSB.GetLength();
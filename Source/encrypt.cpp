@@ -103,13 +103,24 @@ uint32_t Hash(const char *s, int type)
 
 uint32_t PkwareCompress(byte *srcData, uint32_t size)
 {
-	std::unique_ptr<char[]> ptr = std::make_unique<char[]>(CMP_BUFFER_SIZE);
+	// Called for every 4 KiB sector of a save file, so the buffers are kept around for the next call
+	thread_local std::unique_ptr<char[]> workBuffer;
+	thread_local std::unique_ptr<byte[]> destData;
+	thread_local unsigned destCapacity;
+
+	if (workBuffer == nullptr)
+		workBuffer = std::make_unique<char[]>(CMP_BUFFER_SIZE);
+	else
+		memset(workBuffer.get(), 0, CMP_BUFFER_SIZE); // implode expects a zeroed work buffer
 
 	unsigned destSize = 2 * size;
 	if (destSize < 2 * 4096)
 		destSize = 2 * 4096;
 
-	std::unique_ptr<byte[]> destData { new byte[destSize] };
+	if (destSize > destCapacity) {
+		destData.reset(new byte[destSize]);
+		destCapacity = destSize;
+	}
 
 	TDataInfo param;
 	param.srcData = srcData;
@@ -120,7 +131,7 @@ uint32_t PkwareCompress(byte *srcData, uint32_t size)
 
 	unsigned type = 0;
 	unsigned dsize = 4096;
-	implode(PkwareBufferRead, PkwareBufferWrite, ptr.get(), &param, &type, &dsize);
+	implode(PkwareBufferRead, PkwareBufferWrite, workBuffer.get(), &param, &type, &dsize);
 
 	if (param.destOffset < size) {
 		memcpy(srcData, destData.get(), param.destOffset);
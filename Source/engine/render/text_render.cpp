@@ -7,8 +7,10 @@
 
 #include <array>
 #include <cstddef>
+#include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "DiabloUI/art_draw.h"
 #include "DiabloUI/diabloui.h"
@@ -321,41 +323,155 @@ int GetLineHeight(string_view fmt, DrawStringFormatArg *args, std::size_t argsLe
 	return LineHeights[fontIndex];
 }
 
-int DoDrawString(const Surface &out, string_view text, Rectangle rect, Point &characterPosition,
-    int spacing, int lineHeight, int lineWidth, int rightMargin, int bottomMargin,
-    UiFlags flags, GameFontTables size, text_color color)
+/** @brief A code point with its font and kerning already looked up. */
+struct ShapedGlyph {
+	Art *font;
+	uint8_t frame;
+	uint8_t width;
+	bool isNewline;
+	/** Byte offset in the text right after this glyph. */
+	uint32_t end;
+	/** Kerning and glyph count of the rest of the line after this glyph, see GetLineWidth. */
+	int restOfLineWidth;
+	int restOfLineCount;
+};
+
+/**
+ * @brief A string decoded once for a font size and color, so it can be redrawn without decoding or font lookups.
+ *
+ * Spacing and the output rectangle are applied when drawing, so they don't need their own layouts.
+ */
+struct TextLayout {
+	std::string text;
+	GameFontTables size;
+	text_color color;
+	/** Every glyph GetLineWidth would look at, even past a terminator. */
+	std::vector<ShapedGlyph> glyphs;
+	/** Glyphs in front of the first terminator, those are drawn. */
+	std::size_t drawableGlyphs;
+	/** Byte offset where drawing stops once all drawable glyphs are done. */
+	uint32_t drawEnd;
+	int firstLineWidth;
+	int firstLineCount;
+	bool hasSmallFontTallCodepoints;
+};
+
+/** Item labels and store lists come and go, start over rather than growing without bound. */
+constexpr std::size_t MaxTextLayouts = 1024;
+
+std::unordered_map<std::size_t, TextLayout> TextLayouts;
+
+/** @brief Applies spacing the same way GetLineWidth does. */
+int LineWidthWithSpacing(int width, int count, int spacing)
+{
+	const int lineWidth = width + count * spacing;
+	return lineWidth != 0 ? (lineWidth - spacing) : 0;
+}
+
+void ShapeText(TextLayout &layout)
 {
+	layout.glyphs.clear();
+	layout.drawableGlyphs = 0;
+	layout.hasSmallFontTallCodepoints = false;
+
+	bool terminated = false;
 	Art *font = nullptr;
 	std::array<uint8_t, 256> *kerning = nullptr;
 	uint32_t currentUnicodeRow = 0;
-
-	char32_t next;
-	string_view remaining = text;
-	while (!remaining.empty() && remaining[0] != '\0') {
-		next = ConsumeFirstUtf8CodePoint(&remaining);
+	string_view remaining = layout.text;
+	while (!remaining.empty()) {
+		if (!terminated && remaining[0] == '\0') {
+			terminated = true;
+			layout.drawableGlyphs = layout.glyphs.size();
+			layout.drawEnd = static_cast<uint32_t>(remaining.data() - layout.text.data());
+		}
+		const char32_t next = ConsumeFirstUtf8CodePoint(&remaining);
 		if (next == Utf8DecodeError)
 			break;
 		if (next == ZWSP)
 			continue;
 
 		const uint32_t unicodeRow = GetUnicodeRow(next);
-		if (unicodeRow != currentUnicodeRow || font == nullptr) {
-			kerning = LoadFontKerning(size, unicodeRow);
-			font = LoadFont(size, color, unicodeRow);
+		if (unicodeRow != currentUnicodeRow || kerning == nullptr) {
+			kerning = LoadFontKerning(layout.size, unicodeRow);
+			font = terminated ? nullptr : LoadFont(layout.size, layout.color, unicodeRow);
 			currentUnicodeRow = unicodeRow;
 		}
+		if (IsSmallFontTallRow(unicodeRow))
+			layout.hasSmallFontTallCodepoints = true;
+
+		ShapedGlyph glyph;
+		glyph.font = font;
+		glyph.frame = next & 0xFF;
+		glyph.width = (*kerning)[glyph.frame];
+		glyph.isNewline = next == U'\n';
+		glyph.end = static_cast<uint32_t>(remaining.data() - layout.text.data());
+		layout.glyphs.push_back(glyph);
+	}
+	if (!terminated) {
+		layout.drawableGlyphs = layout.glyphs.size();
+		layout.drawEnd = static_cast<uint32_t>(remaining.data() - layout.text.data());
+	}
+
+	int width = 0;
+	int count = 0;
+	for (auto glyph = layout.glyphs.rbegin(); glyph != layout.glyphs.rend(); ++glyph) {
+		glyph->restOfLineWidth = width;
+		glyph->restOfLineCount = count;
+		if (glyph->isNewline) {
+			width = 0;
+			count = 0;
+		} else {
+			width += glyph->width;
+			count++;
+		}
+	}
+	layout.firstLineWidth = width;
+	layout.firstLineCount = count;
+}
 
-		uint8_t frame = next & 0xFF;
-		if (next == '\n' || characterPosition.x > rightMargin) {
-			if (characterPosition.y + lineHeight >= bottomMargin)
+const TextLayout &GetTextLayout(string_view text, GameFontTables size, text_color color)
+{
+	const std::size_t key = std::hash<string_view> {}(text) ^ (static_cast<std::size_t>(color) << 8 | size);
+	auto it = TextLayouts.find(key);
+	if (it != TextLayouts.end()) {
+		TextLayout &layout = it->second;
+		if (layout.size == size && layout.color == color && layout.text == text)
+			return layout;
+	} else {
+		if (TextLayouts.size() >= MaxTextLayouts)
+			TextLayouts.clear();
+		it = TextLayouts.emplace(key, TextLayout {}).first;
+	}
+
+	// New or a hash collision, shape it (again)
+	TextLayout &layout = it->second;
+	layout.text = std::string(text);
+	layout.size = size;
+	layout.color = color;
+	ShapeText(layout);
+	return layout;
+}
+
+int DoDrawString(const Surface &out, const TextLayout &layout, Rectangle rect, Point &characterPosition,
+    int spacing, int lineHeight, int lineWidth, int rightMargin, int bottomMargin, UiFlags flags)
+{
+	const char *text = layout.text.data();
+	const char *remaining = text + layout.drawEnd;
+	for (std::size_t i = 0; i < layout.drawableGlyphs; i++) {
+		const ShapedGlyph &glyph = layout.glyphs[i];
+		if (glyph.isNewline || characterPosition.x > rightMargin) {
+			if (characterPosition.y + lineHeight >= bottomMargin) {
+				remaining = text + glyph.end;
 				break;
+			}
 			characterPosition.x = rect.position.x;
 			characterPosition.y += lineHeight;
 
 			if (HasAnyOf(flags, (UiFlags::AlignCenter | UiFlags::AlignRight))) {
-				lineWidth = (*kerning)[frame];
-				if (!remaining.empty())
-					lineWidth += spacing + GetLineWidth(remaining, size, spacing);
+				lineWidth = glyph.width;
+				if (glyph.end != layout.text.size())
+					lineWidth += spacing + LineWidthWithSpacing(glyph.restOfLineWidth, glyph.restOfLineCount, spacing);
 			}
 
 			if (HasAnyOf(flags, UiFlags::AlignCenter))
@@ -363,14 +479,14 @@ int DoDrawString(const Surface &out, string_view text, Rectangle rect, Point &ch
 			else if (HasAnyOf(flags, UiFlags::AlignRight))
 				characterPosition.x += rect.size.width - lineWidth;
 
-			if (next == '\n')
+			if (glyph.isNewline)
 				continue;
 		}
 
-		DrawArt(out, characterPosition, font, frame);
-		characterPosition.x += (*kerning)[frame] + spacing;
+		DrawArt(out, characterPosition, glyph.font, glyph.frame);
+		characterPosition.x += glyph.width + spacing;
 	}
-	return text.data() - remaining.data();
+	return text - remaining;
 }
 
 } // namespace
@@ -384,6 +500,9 @@ void UnloadFonts(GameFontTables size, text_color color)
 {
 	uint32_t fontStyle = (color << 24) | (size << 16);
 
+	// The layouts point into the fonts
+	TextLayouts.clear();
+
 	for (auto font = Fonts.begin(); font != Fonts.end();) {
 		if ((font->first & 0xFFFF0000) == fontStyle) {
 			font = Fonts.erase(font);
@@ -395,6 +514,7 @@ void UnloadFonts(GameFontTables size, text_color color)
 
 void UnloadFonts()
 {
+	TextLayouts.clear();
 	Fonts.clear();
 	FontKerns.clear();
 }
@@ -592,11 +712,14 @@ uint32_t DrawString(const Surface &out, string_view text, const Rectangle &rect,
 {
 	GameFontTables size = GetSizeFromFlags(flags);
 	text_color color = GetColorFromFlags(flags);
+	const TextLayout &layout = GetTextLayout(text, size, color);
 
 	int charactersInLine = 0;
 	int lineWidth = 0;
-	if (HasAnyOf(flags, (UiFlags::AlignCenter | UiFlags::AlignRight | UiFlags::KerningFitSpacing)))
-		lineWidth = GetLineWidth(text, size, spacing, &charactersInLine);
+	if (HasAnyOf(flags, (UiFlags::AlignCenter | UiFlags::AlignRight | UiFlags::KerningFitSpacing))) {
+		lineWidth = LineWidthWithSpacing(layout.firstLineWidth, layout.firstLineCount, spacing);
+		charactersInLine = layout.firstLineCount;
+	}
 
 	int maxSpacing = spacing;
 	if (HasAnyOf(flags, UiFlags::KerningFitSpacing))
@@ -611,8 +734,12 @@ uint32_t DrawString(const Surface &out, string_view text, const Rectangle &rect,
 	int rightMargin = rect.position.x + rect.size.width;
 	const int bottomMargin = rect.size.height != 0 ? std::min(rect.position.y + rect.size.height, out.h()) : out.h();
 
-	if (lineHeight == -1)
-		lineHeight = GetLineHeight(text, size);
+	if (lineHeight == -1) {
+		if (size == GameFont12 && IsSmallFontTall() && layout.hasSmallFontTallCodepoints)
+			lineHeight = SmallFontTallLineHeight;
+		else
+			lineHeight = LineHeights[size];
+	}
 
 	if (HasAnyOf(flags, UiFlags::VerticalCenter)) {
 		int textHeight = (std::count(text.cbegin(), text.cend(), '\n') + 1) * lineHeight;
@@ -621,7 +748,7 @@ uint32_t DrawString(const Surface &out, string_view text, const Rectangle &rect,
 
 	characterPosition.y += BaseLineOffset[size];
 
-	const int bytesDrawn = DoDrawString(out, text, rect, characterPosition, spacing, lineHeight, lineWidth, rightMargin, bottomMargin, flags, size, color);
+	const int bytesDrawn = DoDrawString(out, layout, rect, characterPosition, spacing, lineHeight, lineWidth, rightMargin, bottomMargin, flags);
 
 	if (HasAnyOf(flags, UiFlags::PentaCursor)) {
 		CelDrawTo(out, characterPosition + Displacement { 0, lineHeight - BaseLineOffset[size] }, *pSPentSpn2Cels, PentSpn2Spin());
@@ -680,8 +807,8 @@ void DrawStringWithColors(const Surface &out, string_view fmt, DrawStringFormatA
 		}
 		const std::optional<std::size_t> fmtArgPos = fmtArgParser(rest);
 		if (fmtArgPos) {
-			DoDrawString(out, args[*fmtArgPos].GetFormatted(), rect, characterPosition, spacing, lineHeight, lineWidth, rightMargin, bottomMargin, flags, size,
-			    GetColorFromFlags(args[*fmtArgPos].GetFlags()));
+			const TextLayout &argLayout = GetTextLayout(args[*fmtArgPos].GetFormatted(), size, GetColorFromFlags(args[*fmtArgPos].GetFlags()));
+			DoDrawString(out, argLayout, rect, characterPosition, spacing, lineHeight, lineWidth, rightMargin, bottomMargin, flags);
 			prev = U'\0';
 			font = nullptr;
 			continue;
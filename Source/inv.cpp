@@ -286,6 +286,7 @@ bool AutoEquip(int playerId, const Item &item, inv_body_loc bodyLocation, bool p
 			PlaySFX(ItemInvSnds[ItemCAnimTbl[item._iCurs]]);
 		}
 
+		player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 		CalcPlrInv(player, true);
 	}
 
@@ -573,6 +574,7 @@ void CheckInvPaste(Player &player, Point cursorPosition)
 	case ILOC_INVALID:
 		break;
 	}
+	player.MarkStatsDirty(PlayerStatsDirty::Equipment | PlayerStatsDirty::Inventory);
 	CalcPlrInv(player, true);
 	if (&player == MyPlayer) {
 		if (player.HoldItem.isEmpty() && !IsHardwareCursor())
@@ -826,6 +828,7 @@ void CheckInvCut(int pnum, Point cursorPosition, bool automaticMove, bool dropIt
 			player._pGold = CalculateGold(player);
 		}
 
+		player.MarkStatsDirty(PlayerStatsDirty::Equipment | PlayerStatsDirty::Inventory);
 		CalcPlrInv(player, true);
 		holdItem._iStatFlag = player.CanUseItem(holdItem);
 
@@ -1098,6 +1101,44 @@ int CreateGoldItemInInventorySlot(Player &player, int slotIndex, int value)
 	return value;
 }
 
+/** @brief Returns a mask with one bit per inventory cell, set if an item covers the cell. */
+uint64_t GetInventoryOccupancy(const Player &player)
+{
+	uint64_t occupancy = 0;
+	for (int i = 0; i < NUM_INV_GRID_ELEM; i++) {
+		if (player.InvGrid[i] != 0)
+			occupancy |= uint64_t { 1 } << i;
+	}
+	return occupancy;
+}
+
+/**
+ * @brief Checks if an item fits with its top left cell at the given slot.
+ * @param occupancy Mask from GetInventoryOccupancy
+ */
+bool ItemFitsInInventorySlot(uint64_t occupancy, int slotIndex, Size itemSize)
+{
+	if (slotIndex < 0)
+		slotIndex = 0;
+	if (slotIndex % 10 + itemSize.width > 10 || slotIndex / 10 + itemSize.height > NUM_INV_GRID_ELEM / 10)
+		return false;
+
+	const uint64_t rowMask = (uint64_t { 1 } << itemSize.width) - 1;
+	uint64_t itemMask = 0;
+	for (int j = 0; j < itemSize.height; j++)
+		itemMask |= rowMask << (10 * j);
+	return (occupancy & (itemMask << slotIndex)) == 0;
+}
+
+void PlaceItemInInventorySlot(Player &player, int slotIndex, const Item &item, Size itemSize)
+{
+	player.InvList[player._pNumInv] = item;
+	player._pNumInv++;
+
+	AddItemToInvGrid(player, slotIndex, player._pNumInv, itemSize);
+	player.CalcScrolls();
+}
+
 } // namespace
 
 void InvDrawSlotBack(const Surface &out, Point targetPosition, Size size)
@@ -1377,15 +1418,23 @@ bool AutoEquipEnabled(const Player &player, const Item &item)
 bool AutoPlaceItemInInventory(Player &player, const Item &item, bool persistItem)
 {
 	Size itemSize = GetInventorySize(item);
+	const uint64_t occupancy = GetInventoryOccupancy(player);
+	auto tryPlace = [&](int slotIndex) {
+		if (!ItemFitsInInventorySlot(occupancy, slotIndex, itemSize))
+			return false;
+		if (persistItem)
+			PlaceItemInInventorySlot(player, slotIndex, item, itemSize);
+		return true;
+	};
 
 	if (itemSize.height == 1) {
 		for (int i = 30; i <= 39; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 		for (int x = 9; x >= 0; x--) {
 			for (int y = 2; y >= 0; y--) {
-				if (AutoPlaceItemInInventorySlot(player, 10 * y + x, item, persistItem))
+				if (tryPlace(10 * y + x))
 					return true;
 			}
 		}
@@ -1395,14 +1444,14 @@ bool AutoPlaceItemInInventory(Player &player, const Item &item, bool persistItem
 	if (itemSize.height == 2) {
 		for (int x = 10 - itemSize.width; x >= 0; x -= itemSize.width) {
 			for (int y = 0; y < 3; y++) {
-				if (AutoPlaceItemInInventorySlot(player, 10 * y + x, item, persistItem))
+				if (tryPlace(10 * y + x))
 					return true;
 			}
 		}
 		if (itemSize.width == 2) {
 			for (int x = 7; x >= 0; x -= 2) {
 				for (int y = 0; y < 3; y++) {
-					if (AutoPlaceItemInInventorySlot(player, 10 * y + x, item, persistItem))
+					if (tryPlace(10 * y + x))
 						return true;
 				}
 			}
@@ -1412,7 +1461,7 @@ bool AutoPlaceItemInInventory(Player &player, const Item &item, bool persistItem
 
 	if (itemSize == Size { 1, 3 }) {
 		for (int i = 0; i < 20; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 		return false;
@@ -1420,12 +1469,12 @@ bool AutoPlaceItemInInventory(Player &player, const Item &item, bool persistItem
 
 	if (itemSize == Size { 2, 3 }) {
 		for (int i = 0; i < 9; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 
 		for (int i = 10; i < 19; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 		return false;
@@ -1436,30 +1485,12 @@ bool AutoPlaceItemInInventory(Player &player, const Item &item, bool persistItem
 
 bool AutoPlaceItemInInventorySlot(Player &player, int slotIndex, const Item &item, bool persistItem)
 {
-	int yy = (slotIndex > 0) ? (10 * (slotIndex / 10)) : 0;
-
 	Size itemSize = GetInventorySize(item);
-	for (int j = 0; j < itemSize.height; j++) {
-		if (yy >= NUM_INV_GRID_ELEM) {
-			return false;
-		}
-		int xx = (slotIndex > 0) ? (slotIndex % 10) : 0;
-		for (int i = 0; i < itemSize.width; i++) {
-			if (xx >= 10 || player.InvGrid[xx + yy] != 0) {
-				return false;
-			}
-			xx++;
-		}
-		yy += 10;
-	}
-
-	if (persistItem) {
-		player.InvList[player._pNumInv] = item;
-		player._pNumInv++;
+	if (!ItemFitsInInventorySlot(GetInventoryOccupancy(player), slotIndex, itemSize))
+		return false;
 
-		AddItemToInvGrid(player, slotIndex, player._pNumInv, itemSize);
-		player.CalcScrolls();
-	}
+	if (persistItem)
+		PlaceItemInInventorySlot(player, slotIndex, item, itemSize);
 
 	return true;
 }
@@ -1549,6 +1580,7 @@ void CheckInvSwap(Player &player, inv_body_loc bLoc, int idx, uint16_t wCI, int
 		player.InvBody[INVLOC_HAND_LEFT].Clear();
 	}
 
+	player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 	CalcPlrInv(player, true);
 }
 
@@ -1556,6 +1588,7 @@ void inv_update_rem_item(Player &player, inv_body_loc iv)
 {
 	player.InvBody[iv].Clear();
 
+	player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 	CalcPlrInv(player, player._pmode != PM_DEATH);
 }
 
@@ -1575,6 +1608,7 @@ void TransferItemToStash(Player &player, int location)
 
 	if (location < INVITEM_INV_FIRST) {
 		RemoveEquipment(player, static_cast<inv_body_loc>(location), false);
+		player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 		CalcPlrInv(player, true);
 	} else if (location <= INVITEM_INV_LAST)
 		player.RemoveInvItem(location - INVITEM_INV_FIRST);
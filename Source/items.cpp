@@ -9,9 +9,12 @@
 #include <bitset>
 #ifdef _DEBUG
 #include <random>
+#include <tuple>
 #endif
 #include <climits>
 #include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -507,13 +510,52 @@ void CalcPlrBookVals(Player &player)
 	for (Item &item : InventoryPlayerItemsRange { player }) {
 		processItem(player, item);
 	}
-	if (&player == MyPlayer) {
-		for (Item &item : Stash.stashList) {
-			processItem(player, item);
-		}
+	if (&player != MyPlayer)
+		return;
+
+	// The stash can hold thousands of items, only revisit them when something they depend on changed
+	if (Stash.AreItemFlagsCurrent(player)) {
+		// Skipping has to leave the stash exactly as the full pass below would
+		assert(std::all_of(Stash.stashList.begin(), Stash.stashList.end(), [&player, &processItem](const Item &item) {
+			Item recomputed = item;
+			processItem(player, recomputed);
+			return recomputed._iMinMag == item._iMinMag && item._iStatFlag == player.CanUseItem(recomputed);
+		}));
+		return;
 	}
+	for (Item &item : Stash.stashList) {
+		processItem(player, item);
+		item._iStatFlag = player.CanUseItem(item);
+	}
+	Stash.ItemFlagsRefreshed(player);
 }
 
+#ifdef _DEBUG
+/**
+ * @brief Collects everything CalcPlrInv derives from the items, buffs and level of the player
+ */
+auto GetDerivedStats(Player &player)
+{
+	std::vector<bool> statFlags;
+	for (const Item &item : EquippedPlayerItemsRange { player }) {
+		statFlags.push_back(item._iStatFlag);
+	}
+	for (const Item &item : InventoryAndBeltPlayerItemsRange { player }) {
+		statFlags.push_back(item._iStatFlag);
+	}
+
+	return std::make_tuple(
+	    statFlags,
+	    player._pStrength, player._pMagic, player._pDexterity, player._pVitality,
+	    player._pMaxHP, player._pMaxMana, player._pDamageMod, player._pLightRad,
+	    player._pMagResist, player._pFireResist, player._pLghtResist,
+	    player._pIMinDam, player._pIMaxDam, player._pIAC, player._pIBonusDam, player._pIBonusToHit, player._pIBonusAC, player._pIBonusDamMod,
+	    player._pIGetHit, player._pIFlags, player.pDamAcFlags, player._pISpells, player._pISplLvlAdd, player._pIEnAc,
+	    player._pIFMinDam, player._pIFMaxDam, player._pILMinDam, player._pILMaxDam,
+	    player._pBlockFlag, player._pgfxnum, player._pScrlSpells);
+}
+#endif
+
 bool GetItemSpace(Point position, int8_t inum)
 {
 	int xx = 0;
@@ -597,16 +639,14 @@ void CalcItemValue(Item &item)
 	item._iIvalue = std::max(v, 1);
 }
 
-void GetBookSpell(Item &item, int lvl)
+spell_id RndBookSpell(int lvl)
 {
-	int rv;
-
 	if (lvl == 0)
 		lvl = 1;
 
 	int maxSpells = gbIsHellfire ? MAX_SPELLS : 37;
 
-	rv = GenerateRnd(maxSpells) + 1;
+	int rv = GenerateRnd(maxSpells) + 1;
 
 	if (gbIsSpawn && lvl > 5)
 		lvl = 5;
@@ -631,6 +671,12 @@ void GetBookSpell(Item &item, int lvl)
 		if (s == maxSpells)
 			s = 1;
 	}
+	return bs;
+}
+
+void GetBookSpell(Item &item, int lvl)
+{
+	spell_id bs = RndBookSpell(lvl);
 	std::string spellName = pgettext("spell", spelldata[bs].sNameText);
 	CopyUtf8(item._iName, std::string(item._iName + spellName), sizeof(item._iIName));
 	CopyUtf8(item._iIName, std::string(item._iIName + spellName), sizeof(item._iIName));
@@ -1073,26 +1119,67 @@ void SaveItemAffix(Item &item, const PLStruct &affix)
 	}
 }
 
+/**
+ * @brief The affixes an item can roll, in the order the rolls pick from.
+ *
+ * Item generation rerolls until it likes the result, so the same few lists are asked for over and
+ * over. The affix tables never change, each list is collected once from the table with the filter
+ * and later rolls give the same affixes as filtering the whole table again.
+ */
+class AffixCandidates {
+public:
+	/**
+	 * @param key Identifies the filter and every argument it depends on.
+	 * @param affixes Affix table terminated by IPL_INVALID.
+	 * @param doubleChance Add affixes flagged PLDouble twice.
+	 * @param filter Called with the table index, returns true to keep the affix.
+	 */
+	template <typename Filter>
+	const std::vector<int16_t> &Get(uint64_t key, const PLStruct *affixes, bool doubleChance, Filter &&filter)
+	{
+		auto list = lists_.find(key);
+		if (list != lists_.end())
+			return list->second;
+
+		std::vector<int16_t> &candidates = lists_[key];
+		for (int j = 0; affixes[j].power.type != IPL_INVALID; j++) {
+			if (!filter(j))
+				continue;
+			candidates.push_back(static_cast<int16_t>(j));
+			if (doubleChance && affixes[j].PLDouble)
+				candidates.push_back(static_cast<int16_t>(j));
+		}
+		return candidates;
+	}
+
+private:
+	std::unordered_map<uint64_t, std::vector<int16_t>> lists_;
+};
+
+AffixCandidates StaffPrefixCandidates;
+AffixCandidates PrefixCandidates;
+AffixCandidates SuffixCandidates;
+
+uint64_t AffixKey(int minlvl, int maxlvl, AffixItemType flgs, bool onlygood, goodorevil goe = GOE_ANY)
+{
+	return static_cast<uint64_t>(static_cast<uint16_t>(minlvl)) << 32
+	    | static_cast<uint64_t>(static_cast<uint16_t>(maxlvl)) << 16
+	    | static_cast<uint64_t>(flgs) << 8
+	    | static_cast<uint64_t>(goe) << 1
+	    | (onlygood ? 1 : 0);
+}
+
 void GetStaffPower(Item &item, int lvl, int bs, bool onlygood)
 {
 	int preidx = -1;
 	if (GenerateRnd(10) == 0 || onlygood) {
-		int nl = 0;
-		int l[256];
-		for (int j = 0; ItemPrefixes[j].power.type != IPL_INVALID; j++) {
-			if (!IsPrefixValidForItemType(j, AffixItemType::Staff) || ItemPrefixes[j].PLMinLvl > lvl)
-				continue;
-			if (onlygood && !ItemPrefixes[j].PLOk)
-				continue;
-			l[nl] = j;
-			nl++;
-			if (ItemPrefixes[j].PLDouble) {
-				l[nl] = j;
-				nl++;
-			}
-		}
-		if (nl != 0) {
-			preidx = l[GenerateRnd(nl)];
+		const std::vector<int16_t> &candidates = StaffPrefixCandidates.Get(AffixKey(0, lvl, AffixItemType::Staff, onlygood), ItemPrefixes, true, [&](int j) {
+			return IsPrefixValidForItemType(j, AffixItemType::Staff)
+			    && ItemPrefixes[j].PLMinLvl <= lvl
+			    && (!onlygood || ItemPrefixes[j].PLOk);
+		});
+		if (!candidates.empty()) {
+			preidx = candidates[GenerateRnd(static_cast<int32_t>(candidates.size()))];
 			item._iMagical = ITEM_QUALITY_MAGIC;
 			SaveItemAffix(item, ItemPrefixes[preidx]);
 			item._iPrePower = ItemPrefixes[preidx].power.type;
@@ -1145,7 +1232,6 @@ std::string GenerateMagicItemName(const string_view &baseNamel, int preidx, int
 
 void GetItemPower(Item &item, int minlvl, int maxlvl, AffixItemType flgs, bool onlygood)
 {
-	int l[256];
 	goodorevil goe;
 
 	int pre = GenerateRnd(4);
@@ -1162,25 +1248,19 @@ void GetItemPower(Item &item, int minlvl, int maxlvl, AffixItemType flgs, bool o
 	if (!onlygood && GenerateRnd(3) != 0)
 		onlygood = true;
 	if (pre == 0) {
-		int nt = 0;
-		for (int j = 0; ItemPrefixes[j].power.type != IPL_INVALID; j++) {
+		const std::vector<int16_t> &candidates = PrefixCandidates.Get(AffixKey(minlvl, maxlvl, flgs, onlygood), ItemPrefixes, true, [&](int j) {
 			if (!IsPrefixValidForItemType(j, flgs))
-				continue;
+				return false;
 			if (ItemPrefixes[j].PLMinLvl < minlvl || ItemPrefixes[j].PLMinLvl > maxlvl)
-				continue;
+				return false;
 			if (onlygood && !ItemPrefixes[j].PLOk)
-				continue;
+				return false;
 			if (HasAnyOf(flgs, AffixItemType::Staff) && ItemPrefixes[j].power.type == IPL_CHARGES)
-				continue;
-			l[nt] = j;
-			nt++;
-			if (ItemPrefixes[j].PLDouble) {
-				l[nt] = j;
-				nt++;
-			}
-		}
-		if (nt != 0) {
-			preidx = l[GenerateRnd(nt)];
+				return false;
+			return true;
+		});
+		if (!candidates.empty()) {
+			preidx = candidates[GenerateRnd(static_cast<int32_t>(candidates.size()))];
 			item._iMagical = ITEM_QUALITY_MAGIC;
 			SaveItemAffix(item, ItemPrefixes[preidx]);
 			item._iPrePower = ItemPrefixes[preidx].power.type;
@@ -1188,18 +1268,14 @@ void GetItemPower(Item &item, int minlvl, int maxlvl, AffixItemType flgs, bool o
 		}
 	}
 	if (post != 0) {
-		int nl = 0;
-		for (int j = 0; ItemSuffixes[j].power.type != IPL_INVALID; j++) {
-			if (IsSuffixValidForItemType(j, flgs)
+		const std::vector<int16_t> &candidates = SuffixCandidates.Get(AffixKey(minlvl, maxlvl, flgs, onlygood, goe), ItemSuffixes, false, [&](int j) {
+			return IsSuffixValidForItemType(j, flgs)
 			    && ItemSuffixes[j].PLMinLvl >= minlvl && ItemSuffixes[j].PLMinLvl <= maxlvl
 			    && !((goe == GOE_GOOD && ItemSuffixes[j].PLGOE == GOE_EVIL) || (goe == GOE_EVIL && ItemSuffixes[j].PLGOE == GOE_GOOD))
-			    && (!onlygood || ItemSuffixes[j].PLOk)) {
-				l[nl] = j;
-				nl++;
-			}
-		}
-		if (nl != 0) {
-			sufidx = l[GenerateRnd(nl)];
+			    && (!onlygood || ItemSuffixes[j].PLOk);
+		});
+		if (!candidates.empty()) {
+			sufidx = candidates[GenerateRnd(static_cast<int32_t>(candidates.size()))];
 			item._iMagical = ITEM_QUALITY_MAGIC;
 			SaveItemAffix(item, ItemSuffixes[sufidx]);
 			item._iSufPower = ItemSuffixes[sufidx].power.type;
@@ -1865,37 +1941,77 @@ bool SmithItemOk(int i)
 	return true;
 }
 
-template <bool (*Ok)(int), bool ConsiderDropRate = false>
-int RndVendorItem(int minlvl, int maxlvl)
+/** @brief Everything besides the item data that the vendor filters look at. */
+uint32_t VendorGameMode()
 {
-	int ril[512];
+	return (gbIsHellfire ? 1 : 0) | (gbIsMultiplayer ? 2 : 0);
+}
 
-	int ri = 0;
-	for (int i = 1; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
-		if (AllItemsList[i].iRnd == IDROP_NEVER)
-			continue;
-		if (!Ok(i))
-			continue;
-		if (AllItemsList[i].iMinMLvl < minlvl || AllItemsList[i].iMinMLvl > maxlvl)
-			continue;
+/**
+ * @brief The items a vendor can roll for a level range, in the order RndVendorItem picks from.
+ *
+ * The stores roll again until an item fits, scanning all of AllItemsList for every roll adds up
+ * with the larger item list. The lists are built on first use and thrown away when the game mode
+ * changes, rolls consume the same random numbers and give the same items as a full scan.
+ */
+class VendorCandidates {
+public:
+	const std::vector<int16_t> &Get(int minlvl, int maxlvl, uint32_t gameMode, bool (*ok)(int), bool considerDropRate)
+	{
+		if (gameMode != gameMode_) {
+			lists_.clear();
+			gameMode_ = gameMode;
+		}
 
-		ril[ri] = i;
-		ri++;
-		if (ri == 512)
-			break;
+		const uint32_t key = static_cast<uint32_t>(minlvl) << 16 | static_cast<uint16_t>(maxlvl);
+		auto list = lists_.find(key);
+		if (list != lists_.end())
+			return list->second;
 
-		if (!ConsiderDropRate || AllItemsList[i].iRnd != IDROP_DOUBLE)
-			continue;
+		std::vector<int16_t> &candidates = lists_[key];
+		for (int i = 1; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
+			if (AllItemsList[i].iRnd == IDROP_NEVER)
+				continue;
+			if (!ok(i))
+				continue;
+			if (AllItemsList[i].iMinMLvl < minlvl || AllItemsList[i].iMinMLvl > maxlvl)
+				continue;
 
-		ril[ri] = i;
-		ri++;
-		if (ri == 512)
-			break;
+			candidates.push_back(static_cast<int16_t>(i));
+			if (candidates.size() == MaxCandidates)
+				break;
+
+			if (!considerDropRate || AllItemsList[i].iRnd != IDROP_DOUBLE)
+				continue;
+
+			candidates.push_back(static_cast<int16_t>(i));
+			if (candidates.size() == MaxCandidates)
+				break;
+		}
+		return candidates;
 	}
 
-	return ril[GenerateRnd(ri)] + 1;
+private:
+	/** Size of the candidate array in vanilla, the rolls depend on it. */
+	static constexpr size_t MaxCandidates = 512;
+
+	uint32_t gameMode_ = UINT32_MAX;
+	std::unordered_map<uint32_t, std::vector<int16_t>> lists_;
+};
+
+template <bool (*Ok)(int), bool ConsiderDropRate = false, uint32_t (*GameMode)() = VendorGameMode>
+int RndVendorItem(int minlvl, int maxlvl)
+{
+	static VendorCandidates Candidates;
+
+	const std::vector<int16_t> &candidates = Candidates.Get(minlvl, maxlvl, GameMode(), Ok, ConsiderDropRate);
+	const int32_t ri = GenerateRnd(static_cast<int32_t>(candidates.size()));
+	if (candidates.empty())
+		return IDI_GOLD + 1; // Vanilla read an uninitialised entry, can't happen with the item data we ship
+
+	return candidates[ri] + 1;
 }
 
 int RndSmithItem(int lvl)
@@ -2089,9 +2205,27 @@ bool HealerItemOk(int i)
 	return false;
 }
 
+/** @brief Single player Hellfire only offers elixirs for attributes the hero can still raise. */
+uint32_t HealerGameMode()
+{
+	uint32_t gameMode = VendorGameMode();
+	if (!gbIsMultiplayer && gbIsHellfire) {
+		const Player &myPlayer = Players[MyPlayerId];
+		if (myPlayer._pBaseStr < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Strength))
+			gameMode |= 1 << 2;
+		if (myPlayer._pBaseMag < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Magic))
+			gameMode |= 1 << 3;
+		if (myPlayer._pBaseDex < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Dexterity))
+			gameMode |= 1 << 4;
+		if (myPlayer._pBaseVit < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Vitality))
+			gameMode |= 1 << 5;
+	}
+	return gameMode;
+}
+
 int RndHealerItem(int lvl)
 {
-	return RndVendorItem<HealerItemOk>(0, lvl);
+	return RndVendorItem<HealerItemOk, false, HealerGameMode>(0, lvl);
 }
 
 void RecreateSmithItem(Item &item, int lvl, int iseed)
@@ -2696,21 +2830,43 @@ void CalcPlrItemVals(Player &player, bool loadgfx)
 
 void CalcPlrInv(Player &player, bool loadgfx)
 {
-	CalcPlrItemMin(player);
-	CalcSelfItems(player);
-	CalcPlrItemVals(player, loadgfx);
+	const PlayerStatsDirty dirty = player.statsDirty;
+	if (dirty == PlayerStatsDirty::None)
+		return;
+	player.statsDirty = PlayerStatsDirty::None;
+
+	// Backpack and belt items don't contribute to the stats, only their stat flags depend on them
+	const bool recalcStats = HasAnyOf(dirty, PlayerStatsDirty::Equipment | PlayerStatsDirty::Buffs | PlayerStatsDirty::Level);
+	if (recalcStats) {
+		CalcSelfItems(player);
+		CalcPlrItemVals(player, loadgfx);
+	}
 	CalcPlrItemMin(player);
 	if (&player == &Players[MyPlayerId]) {
+		// Also brings the stat flags of the stash items up to date
 		CalcPlrBookVals(player);
 		player.CalcScrolls();
-		CalcPlrStaff(player);
-		if (IsStashOpen) {
-			// If stash is open, ensure the items are displayed correctly
-			Stash.RefreshItemStatFlags();
-		}
+		if (recalcStats)
+			CalcPlrStaff(player);
 	}
 }
 
+#ifdef _DEBUG
+void VerifyPlrInvCache(Player &player)
+{
+	if (player.statsDirty != PlayerStatsDirty::None || player._pmode == PM_DEATH)
+		return;
+
+	// The infravision spell keeps overriding the flag until it runs out
+	const bool infraFlag = player._pInfraFlag;
+	const auto cached = GetDerivedStats(player);
+	player.MarkStatsDirty(PlayerStatsDirty::All);
+	CalcPlrInv(player, false);
+	assert(GetDerivedStats(player) == cached);
+	player._pInfraFlag = infraFlag;
+}
+#endif
+
 void InitializeItem(Item &item, int itemData)
 {
 	auto &pAllItem = AllItemsList[itemData];
@@ -3450,6 +3606,7 @@ void CheckIdentify(Player &player, int cii)
 		pi = &player.InvBody[cii];
 
 	pi->_iIdentified = true;
+	player.MarkStatsDirty(cii >= NUM_INVLOC ? PlayerStatsDirty::Inventory : PlayerStatsDirty::Equipment);
 	CalcPlrInv(player, true);
 }
 
@@ -3466,6 +3623,7 @@ void DoRepair(Player &player, int cii)
 	}
 
 	RepairItem(*pi, player._pLevel);
+	player.MarkStatsDirty(cii >= NUM_INVLOC ? PlayerStatsDirty::Inventory : PlayerStatsDirty::Equipment);
 	CalcPlrInv(player, true);
 }
 
@@ -3480,6 +3638,7 @@ void DoRecharge(Player &player, int cii)
 	}
 
 	RechargeItem(*pi, player);
+	player.MarkStatsDirty(cii >= NUM_INVLOC ? PlayerStatsDirty::Inventory : PlayerStatsDirty::Equipment);
 	CalcPlrInv(player, true);
 }
 
@@ -3493,6 +3652,7 @@ bool DoOil(Player &player, int cii)
 	}
 	if (!ApplyOilToItem(*pi, player))
 		return false;
+	player.MarkStatsDirty(cii >= NUM_INVLOC ? PlayerStatsDirty::Inventory : PlayerStatsDirty::Equipment);
 	CalcPlrInv(player, true);
 	return true;
 }
@@ -4320,6 +4480,39 @@ int ItemNoFlippy()
 	return r;
 }
 
+/**
+ * @brief Replays the rolls SetupAllItems makes for an onlygood spell book without building the item.
+ *
+ * CreateSpellBook throws away books until one teaches the right spell. This leaves the random
+ * state where SetupAllItems would have left it, so the books that are thrown away never have to be
+ * generated and the same seed is picked in the end.
+ * @return The spell the book teaches, SPL_INVALID if the item needs the full generation.
+ */
+spell_id RollSpellBook(int idx, int iseed, int lvl, int uper, bool onlygood)
+{
+	// Only onlygood forces the item level for books, and the unique check below depends on uper
+	if (uper != 1 || !onlygood)
+		return SPL_INVALID;
+
+	const ItemData &baseItem = AllItemsList[idx];
+	if (baseItem.itype != ItemType::Misc || baseItem.iMiscId != IMISC_BOOK)
+		return SPL_INVALID;
+
+	SetRndSeed(iseed);
+	GenerateRnd(baseItem.iMaxAC - baseItem.iMinAC + 1);
+	spell_id spell = RndBookSpell(lvl / 2);
+
+	if (GenerateRnd(100) > 10)
+		GenerateRnd(100);
+	if (GenerateRnd(100) <= uper)
+		return SPL_INVALID; // CheckUnique goes on to look for a unique book
+
+	if (baseItem.iDurability > 0 && baseItem.iDurability != DUR_INDESTRUCTIBLE)
+		GenerateRnd(baseItem.iDurability / 2);
+
+	return spell;
+}
+
 void CreateSpellBook(Point position, spell_id ispell, bool sendmsg, bool delta)
 {
 	int lvl = currlevel;
@@ -4339,8 +4532,13 @@ void CreateSpellBook(Point position, spell_id ispell, bool sendmsg, bool delta)
 	auto &item = Items[ii];
 
 	while (true) {
+		int iseed = AdvanceRndSeed();
+		spell_id spell = RollSpellBook(idx, iseed, 2 * lvl, 1, true);
+		if (spell != SPL_INVALID && spell != ispell)
+			continue;
+
 		item = {};
-		SetupAllItems(item, idx, AdvanceRndSeed(), 2 * lvl, 1, true, false, delta);
+		SetupAllItems(item, idx, iseed, 2 * lvl, 1, true, false, delta);
 		if (item._iMiscId == IMISC_BOOK && item._iSpell == ispell)
 			break;
 	}
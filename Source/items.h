@@ -438,6 +438,12 @@ void InitItemGFX();
 void InitItems();
 void CalcPlrItemVals(Player &player, bool Loadgfx);
 void CalcPlrInv(Player &player, bool Loadgfx);
+#ifdef _DEBUG
+/**
+ * @brief Recomputes all derived stats of the player and asserts that the cached ones matched
+ */
+void VerifyPlrInvCache(Player &player);
+#endif
 void InitializeItem(Item &item, int itemData);
 void GenerateNewSeed(Item &h);
 int GetGoldCursor(int value);
@@ -492,6 +498,11 @@ void SpawnBoy(int lvl);
 void SpawnHealer(int lvl);
 void MakeGoldStack(Item &goldItem, int value);
 int ItemNoFlippy();
+/**
+ * @brief Rolls the spell of a spell book without generating the item, only for onlygood books with a uper of 1.
+ * @return The spell, SPL_INVALID if only SetupAllItems can tell.
+ */
+spell_id RollSpellBook(int idx, int iseed, int lvl, int uper, bool onlygood);
 void CreateSpellBook(Point position, spell_id ispell, bool sendmsg, bool delta);
 void CreateMagicArmor(Point position, ItemType itemType, int icurs, bool sendmsg, bool delta);
 void CreateAmulet(Point position, int lvl, bool sendmsg, bool delta);
@@ -5,8 +5,10 @@
  */
 #include "loadsave.h"
 
+#include <algorithm>
 #include <climits>
 #include <cstring>
+#include <iterator>
 #include <numeric>
 #include <unordered_map>
 
@@ -77,36 +79,63 @@ T SwapBE(T in)
 
 class LoadHelper {
 	std::unique_ptr<byte[]> m_buffer_;
+	std::unique_ptr<SaveFileReader> m_reader_;
 	size_t m_cur_ = 0;
-	size_t m_size_;
+	size_t m_size_ = 0;
+
+	/** @return The next size bytes of the file, or nullptr if the file ends before that. */
+	const byte *Peek(size_t size)
+	{
+		if (m_reader_ != nullptr)
+			return m_reader_->Peek(size);
+		if (m_buffer_ == nullptr || m_size_ < m_cur_ + size)
+			return nullptr;
+		return &m_buffer_[m_cur_];
+	}
 
 	template <class T>
 	T Next()
 	{
 		const auto size = sizeof(T);
-		if (!IsValid(size))
+		const byte *src = Peek(size);
+		if (src == nullptr)
 			return 0;
 
 		T value;
-		memcpy(&value, &m_buffer_[m_cur_], size);
-		m_cur_ += size;
+		memcpy(&value, src, size);
+		Skip(size);
 
 		return value;
 	}
 
 public:
+	/** @brief Streams the file from the archive, it is decoded while it is being parsed. */
 	LoadHelper(std::optional<MpqArchive> archive, const char *szFileName)
 	{
 		if (archive)
-			m_buffer_ = ReadArchive(*archive, szFileName, &m_size_);
-		else
-			m_buffer_ = nullptr;
+			m_reader_ = std::make_unique<SaveFileReader>(std::move(*archive), szFileName);
+	}
+
+	LoadHelper(MpqArchive &archive, const char *szFileName)
+	    : m_buffer_(ReadArchive(archive, szFileName, &m_size_))
+	{
+	}
+
+	LoadHelper(std::unique_ptr<byte[]> buffer, size_t size)
+	    : m_buffer_(std::move(buffer))
+	    , m_size_(size)
+	{
 	}
 
 	bool IsValid(size_t size = 1)
 	{
-		return m_buffer_ != nullptr
-		    && m_size_ >= (m_cur_ + size);
+		return Peek(size) != nullptr;
+	}
+
+	/** @brief Checks that the whole file could be read, streamed files are only verified once their end is reached. */
+	bool Finish()
+	{
+		return m_reader_ == nullptr || m_reader_->Finish();
 	}
 
 	template <typename T>
@@ -117,16 +146,20 @@ public:
 
 	void Skip(size_t size)
 	{
-		m_cur_ += size;
+		if (m_reader_ != nullptr)
+			m_reader_->Skip(size);
+		else
+			m_cur_ += size;
 	}
 
 	void NextBytes(void *bytes, size_t size)
 	{
-		if (!IsValid(size))
+		const byte *src = Peek(size);
+		if (src == nullptr)
 			return;
 
-		memcpy(bytes, &m_buffer_[m_cur_], size);
-		m_cur_ += size;
+		memcpy(bytes, src, size);
+		Skip(size);
 	}
 
 	template <class T>
@@ -150,10 +183,58 @@ public:
 	{
 		return Next<uint32_t>() != 0;
 	}
+
+	/**
+	 * @brief Reads a grid that is stored row by row into an array indexed [x][y].
+	 * @tparam U Type of each value in the file.
+	 */
+	template <class U, class T, size_t Width, size_t Height>
+	void NextGridLE(T (&grid)[Width][Height])
+	{
+		NextGrid<U>(grid, [](U value) { return static_cast<T>(SwapLE(value)); });
+	}
+
+	template <class U, class T, size_t Width, size_t Height, typename Convert>
+	void NextGridLE(T (&grid)[Width][Height], Convert convert)
+	{
+		NextGrid<U>(grid, [&convert](U value) { return convert(SwapLE(value)); });
+	}
+
+	template <class U, class T, size_t Width, size_t Height>
+	void NextGridBE(T (&grid)[Width][Height])
+	{
+		NextGrid<U>(grid, [](U value) { return static_cast<T>(SwapBE(value)); });
+	}
+
+private:
+	template <class U, class T, size_t Width, size_t Height, typename Convert>
+	void NextGrid(T (&grid)[Width][Height], Convert convert)
+	{
+		constexpr size_t Size = sizeof(U) * Width * Height;
+		const byte *src = Peek(Size);
+		if (src == nullptr) {
+			for (auto &column : grid) {
+				for (T &value : column)
+					value = convert(U {});
+			}
+			return;
+		}
+
+		// Each column of the grid is contiguous, in the file its values are a row apart
+		for (size_t x = 0; x < Width; x++) {
+			for (size_t y = 0; y < Height; y++) {
+				U value;
+				memcpy(&value, &src[(y * Width + x) * sizeof(U)], sizeof(U));
+				grid[x][y] = convert(value);
+			}
+		}
+		Skip(Size);
+	}
 };
 
 class SaveHelper {
-	MpqWriter &m_mpqWriter;
+	MpqWriter *m_mpqWriter = nullptr;
+	SaveSnapshot *m_snapshot = nullptr;
 	const char *m_szFileName_;
 	std::unique_ptr<byte[]> m_buffer_;
 	size_t m_cur_ = 0;
@@ -161,7 +242,16 @@ class SaveHelper {
 
 public:
 	SaveHelper(MpqWriter &mpqWriter, const char *szFileName, size_t bufferLen)
-	    : m_mpqWriter(mpqWriter)
+	    : m_mpqWriter(&mpqWriter)
+	    , m_szFileName_(szFileName)
+	    , m_buffer_(new byte[codec_get_encoded_len(bufferLen)])
+	    , m_capacity_(bufferLen)
+	{
+	}
+
+	/** @brief Leaves encoding and writing the file to whoever commits the snapshot. */
+	SaveHelper(SaveSnapshot &snapshot, const char *szFileName, size_t bufferLen)
+	    : m_snapshot(&snapshot)
 	    , m_szFileName_(szFileName)
 	    , m_buffer_(new byte[codec_get_encoded_len(bufferLen)])
 	    , m_capacity_(bufferLen)
@@ -209,12 +299,58 @@ public:
 		WriteBytes(&value, sizeof(value));
 	}
 
+	/**
+	 * @brief Writes a grid indexed [x][y] row by row, the order used by the save format.
+	 * @tparam U Type of each value in the file.
+	 */
+	template <class U, class T, size_t Width, size_t Height>
+	void WriteGridLE(const T (&grid)[Width][Height])
+	{
+		WriteGrid<U>(grid, [](T value) { return SwapLE(static_cast<U>(value)); });
+	}
+
+	template <class U, class T, size_t Width, size_t Height, typename Convert>
+	void WriteGridLE(const T (&grid)[Width][Height], Convert convert)
+	{
+		WriteGrid<U>(grid, [&convert](T value) { return SwapLE(static_cast<U>(convert(value))); });
+	}
+
+	template <class U, class T, size_t Width, size_t Height>
+	void WriteGridBE(const T (&grid)[Width][Height])
+	{
+		WriteGrid<U>(grid, [](T value) { return SwapBE(static_cast<U>(value)); });
+	}
+
 	~SaveHelper()
 	{
+		if (m_snapshot != nullptr) {
+			m_snapshot->AddFile(m_szFileName_, std::move(m_buffer_), m_cur_);
+			return;
+		}
+
 		const auto encodedLen = codec_get_encoded_len(m_cur_);
 		const char *const password = pfile_get_password();
 		codec_encode(m_buffer_.get(), m_cur_, encodedLen, password);
-		m_mpqWriter.WriteFile(m_szFileName_, m_buffer_.get(), encodedLen);
+		m_mpqWriter->WriteFile(m_szFileName_, m_buffer_.get(), encodedLen);
+	}
+
+private:
+	template <class U, class T, size_t Width, size_t Height, typename Convert>
+	void WriteGrid(const T (&grid)[Width][Height], Convert convert)
+	{
+		constexpr size_t Size = sizeof(U) * Width * Height;
+		if (!IsValid(Size))
+			return;
+
+		// Each column of the grid is contiguous, in the file its values are a row apart
+		byte *dst = &m_buffer_[m_cur_];
+		for (size_t x = 0; x < Width; x++) {
+			for (size_t y = 0; y < Height; y++) {
+				const U value = convert(grid[x][y]);
+				memcpy(&dst[(y * Width + x) * sizeof(U)], &value, sizeof(U));
+			}
+		}
+		m_cur_ += Size;
 	}
 };
 
@@ -527,6 +663,8 @@ void LoadPlayer(LoadHelper &file, Player &player)
 	player.pDamAcFlags = static_cast<ItemSpecialEffectHf>(file.NextLE<uint32_t>());
 	file.Skip(20); // Available bytes
 	CalcPlrItemVals(player, false);
+	// Stat flags, scrolls and staff spells get recomputed by the next CalcPlrInv
+	player.MarkStatsDirty(PlayerStatsDirty::All);
 
 	// Omit pointer _pNData
 	// Omit pointer _pWData
@@ -763,6 +901,8 @@ void LoadObject(LoadHelper &file, Object &object)
 void LoadItem(LoadHelper &file, Item &item)
 {
 	LoadItemData(file, item);
+	if (gbSkipSync)
+		return;
 	GetItemFrm(item);
 }
 
@@ -900,9 +1040,13 @@ void LoadMatchingItems(LoadHelper &file, const int n, Item *pItem)
  * @brief Loads items on the current dungeon floor
  * @param file interface to the save file
  * @param savedItemCount how many items to read from the save file
+ * @return false if the items don't fit in the Items array or lie outside of the dungeon
  */
-void LoadDroppedItems(LoadHelper &file, size_t savedItemCount)
+bool LoadDroppedItems(LoadHelper &file, size_t savedItemCount)
 {
+	if (savedItemCount > MAXITEMS)
+		return false;
+
 	// Skip loading ActiveItems and AvailableItems, the indices are initialised below based on the number of valid items
 	file.Skip<uint8_t>(MAXITEMS * 2);
 
@@ -917,12 +1061,16 @@ void LoadDroppedItems(LoadHelper &file, size_t savedItemCount)
 		LoadItem(file, item);
 
 		if (!item.isEmpty()) {
+			if (!InDungeonBounds(item.position))
+				return false;
 			// Loaded a valid item
 			ActiveItemCount++;
 			// populate its location in the lookup table with the offset in the Items array + 1 (so 0 can be used for "no item")
 			dItem[item.position.x][item.position.y] = ActiveItemCount;
 		}
 	}
+
+	return true;
 }
 
 void SaveItem(SaveHelper &file, const Item &item)
@@ -1519,17 +1667,14 @@ std::unordered_map<uint8_t, uint8_t> SaveDroppedItems(SaveHelper &file)
  */
 void SaveDroppedItemLocations(SaveHelper &file, const std::unordered_map<uint8_t, uint8_t> &itemIndexes)
 {
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			file.WriteLE<uint8_t>(itemIndexes.at(dItem[i][j]));
-	}
+	file.WriteGridLE<uint8_t>(dItem, [&itemIndexes](int8_t itemId) { return itemIndexes.at(itemId); });
 }
 
 constexpr uint32_t VersionAdditionalMissiles = 0;
+constexpr size_t BytesWrittenBySaveMissile = 180;
 
 void SaveAdditionalMissiles()
 {
-	constexpr size_t BytesWrittenBySaveMissile = 180;
 	uint32_t missileCountAdditional = (Missiles.size() > MaxMissilesForSaveGame) ? static_cast<uint32_t>(Missiles.size() - MaxMissilesForSaveGame) : 0;
 	SaveHelper file(CurrentSaveArchive(), "additionalMissiles", sizeof(uint32_t) + sizeof(uint32_t) + (missileCountAdditional * BytesWrittenBySaveMissile));
 
@@ -1562,13 +1707,317 @@ void LoadAdditionalMissiles()
 	}
 	auto missileCountAdditional = file.NextLE<uint32_t>();
 	for (uint32_t i = 0U; i < missileCountAdditional; i++) {
+		// The count is only trusted as far as the file actually holds that many missiles
+		if (!file.IsValid(BytesWrittenBySaveMissile))
+			app_fatal("%s", _("Invalid save file").c_str());
 		LoadMissile(&file);
 	}
+	if (!file.Finish())
+		app_fatal("%s", _("Invalid save file").c_str());
 }
 
 const int DiabloItemSaveSize = 368;
 const int HellfireItemSaveSize = 372;
 
+/** Stashes written before every page got a file of its own. */
+constexpr uint8_t StashVersionSingleFile = 0;
+
+void GetStashPageFileName(unsigned page, char *szName)
+{
+	sprintf(szName, "%sstashpage%02u", gbIsMultiplayer ? "mp" : "sp", page);
+}
+
+/** @brief Reads a stash page, the items on it are appended to the stash list. */
+void LoadStashPage(MpqArchive &archive, unsigned page)
+{
+	if (page >= CountStashPages)
+		return;
+
+	char szName[MAX_PATH];
+	GetStashPageFileName(page, szName);
+	LoadHelper file(archive, szName);
+	if (!file.IsValid())
+		return;
+
+	StashStruct::StashGrid &grid = Stash.stashGrids[page];
+	for (auto &row : grid) {
+		for (uint16_t &cell : row) {
+			cell = file.NextLE<uint16_t>();
+		}
+	}
+
+	const auto itemCount = file.NextLE<uint32_t>();
+	const size_t firstItem = Stash.stashList.size();
+	Stash.stashList.resize(firstItem + itemCount);
+	for (unsigned i = 0; i < itemCount; i++) {
+		LoadItemData(file, Stash.stashList[firstItem + i]);
+	}
+
+	// The page numbers its items from 1, make the grid refer to the whole stash list instead
+	for (auto &row : grid) {
+		for (uint16_t &cell : row) {
+			if (cell > itemCount)
+				cell = 0;
+			else if (cell != 0)
+				cell = static_cast<uint16_t>(cell + firstItem);
+		}
+	}
+}
+
+/** @brief Writes a page together with the items placed on it, numbered from 1 in the order they appear on the grid. */
+void SaveStashPage(SaveSnapshot &snapshot, unsigned page)
+{
+	std::vector<uint16_t> pageItems;
+	StashStruct::StashGrid pageGrid;
+	const StashStruct::StashGrid &grid = Stash.stashGrids[page];
+	for (size_t x = 0; x < grid.size(); x++) {
+		for (size_t y = 0; y < grid[x].size(); y++) {
+			const uint16_t cell = grid[x][y];
+			if (cell == 0) {
+				pageGrid[x][y] = 0;
+				continue;
+			}
+			auto pageItem = std::find(pageItems.begin(), pageItems.end(), cell - 1);
+			if (pageItem == pageItems.end())
+				pageItem = pageItems.insert(pageItems.end(), cell - 1);
+			pageGrid[x][y] = static_cast<uint16_t>(pageItem - pageItems.begin() + 1);
+		}
+	}
+
+	char szName[MAX_PATH];
+	GetStashPageFileName(page, szName);
+	const int itemSize = (gbIsHellfire ? HellfireItemSaveSize : DiabloItemSaveSize);
+	SaveHelper file(snapshot, szName, sizeof(pageGrid) + sizeof(uint32_t) + itemSize * pageItems.size());
+
+	for (const auto &row : pageGrid) {
+		for (uint16_t cell : row) {
+			file.WriteLE<uint16_t>(cell);
+		}
+	}
+
+	file.WriteLE<uint32_t>(static_cast<uint32_t>(pageItems.size()));
+	for (uint16_t itemId : pageItems) {
+		SaveItem(file, Stash.stashList[itemId]);
+	}
+}
+
+/** @return false if the level refers to monsters, objects or items that don't exist */
+bool LoadLevelData(LoadHelper &file)
+{
+	if (leveltype != DTYPE_TOWN) {
+		file.NextGridLE<int8_t>(dCorpse);
+		SyncUniqDead();
+	}
+
+	const auto monsterCount = file.NextBE<int32_t>();
+	auto savedItemCount = file.NextBE<uint32_t>();
+	const auto objectCount = file.NextBE<int32_t>();
+	if (monsterCount < 0 || monsterCount > MAXMONSTERS || objectCount < 0 || objectCount > MAXOBJECTS)
+		return false;
+
+	ActiveMonsterCount = monsterCount;
+	ActiveObjectCount = objectCount;
+
+	if (leveltype != DTYPE_TOWN) {
+		for (int &monsterId : ActiveMonsters)
+			monsterId = file.NextBE<int32_t>();
+		if (!std::all_of(ActiveMonsters, ActiveMonsters + ActiveMonsterCount, [](int id) { return id >= 0 && id < MAXMONSTERS; })) {
+			ActiveMonsterCount = 0;
+			return false;
+		}
+		for (int i = 0; i < ActiveMonsterCount; i++)
+			LoadMonster(&file, Monsters[ActiveMonsters[i]]);
+		for (int &objectId : ActiveObjects)
+			objectId = file.NextLE<int8_t>();
+		for (int &objectId : AvailableObjects)
+			objectId = file.NextLE<int8_t>();
+		if (!std::all_of(ActiveObjects, ActiveObjects + ActiveObjectCount, [](int id) { return id >= 0 && id < MAXOBJECTS; })) {
+			ActiveObjectCount = 0;
+			return false;
+		}
+		for (int i = 0; i < ActiveObjectCount; i++)
+			LoadObject(file, Objects[ActiveObjects[i]]);
+		if (!gbSkipSync) {
+			for (int i = 0; i < ActiveObjectCount; i++)
+				SyncObjectAnim(Objects[ActiveObjects[i]]);
+		}
+	}
+
+	if (!LoadDroppedItems(file, savedItemCount))
+		return false;
+
+	file.NextGridLE<uint8_t>(dFlags, [](uint8_t flags) { return static_cast<DungeonFlag>(flags) & DungeonFlag::LoadedFlags; });
+
+	// skip dItem indexes, this gets populated in LoadDroppedItems
+	file.Skip<uint8_t>(MAXDUNX * MAXDUNY);
+
+	if (leveltype != DTYPE_TOWN) {
+		file.NextGridBE<int32_t>(dMonster);
+		file.NextGridLE<int8_t>(dObject);
+		file.NextGridLE<int8_t>(dLight);
+		file.NextGridLE<int8_t>(dPreLight);
+		file.NextGridLE<uint8_t>(AutomapView, [](uint8_t view) {
+			const auto automapView = static_cast<MapExplorationType>(view);
+			return automapView == MAP_EXP_OLD ? MAP_EXP_SELF : automapView;
+		});
+	}
+
+	return true;
+}
+
+/** The counts at the start of the game file, what they count is only read once the level is set up. */
+struct GameFileHeader {
+	Point view;
+	int monsterCount;
+	uint32_t itemCount;
+	int missileCount;
+	int objectCount;
+};
+
+/** @return false if the game is on a level that doesn't exist or has more monsters, missiles or objects than fit */
+bool LoadGameHeader(LoadHelper &file, GameFileHeader &header)
+{
+	if (gbIsHellfireSaveGame) {
+		giNumberOfLevels = 25;
+		giNumberQuests = 24;
+		giNumberOfSmithPremiumItems = 15;
+	} else {
+		// Todo initialize additional levels and quests if we are running Hellfire
+		giNumberOfLevels = 17;
+		giNumberQuests = 16;
+		giNumberOfSmithPremiumItems = 6;
+	}
+
+	setlevel = file.NextBool8();
+	setlvlnum = static_cast<_setlevels>(file.NextBE<uint32_t>());
+	currlevel = file.NextBE<uint32_t>();
+	if (currlevel >= NUMLEVELS)
+		return false;
+	leveltype = static_cast<dungeon_type>(file.NextBE<uint32_t>());
+	if (!setlevel)
+		leveltype = gnLevelTypeTbl[currlevel];
+	header.view.x = file.NextBE<int32_t>();
+	header.view.y = file.NextBE<int32_t>();
+	invflag = file.NextBool8();
+	chrflag = file.NextBool8();
+	header.monsterCount = file.NextBE<int32_t>();
+	header.itemCount = file.NextBE<uint32_t>();
+	header.missileCount = file.NextBE<int32_t>();
+	header.objectCount = file.NextBE<int32_t>();
+	if (header.monsterCount < 0 || header.monsterCount > MAXMONSTERS || header.missileCount < 0 || header.missileCount > static_cast<int>(MaxMissilesForSaveGame)
+	    || header.objectCount < 0 || header.objectCount > MAXOBJECTS)
+		return false;
+
+	for (uint8_t i = 0; i < giNumberOfLevels; i++) {
+		glSeedTbl[i] = file.NextBE<uint32_t>();
+		file.Skip(4); // Skip loading gnLevelTypeTbl
+	}
+
+	LoadPlayer(file, Players[MyPlayerId]);
+
+	for (int i = 0; i < giNumberQuests; i++)
+		LoadQuest(&file, i);
+	for (int i = 0; i < MAXPORTAL; i++)
+		LoadPortal(&file, i);
+
+	return true;
+}
+
+/** @return false if the game refers to monsters, objects, lights or items that don't exist */
+bool LoadGameState(LoadHelper &file, const GameFileHeader &header)
+{
+	ViewPosition = header.view;
+	ActiveMonsterCount = header.monsterCount;
+	ActiveObjectCount = header.objectCount;
+
+	for (int &monstkill : MonsterKillCounts)
+		monstkill = file.NextBE<int32_t>();
+
+	if (leveltype != DTYPE_TOWN) {
+		// The ids past the active count are the free slots that new monsters, objects and lights are taken from
+		for (int &monsterId : ActiveMonsters)
+			monsterId = file.NextBE<int32_t>();
+		if (!std::all_of(std::begin(ActiveMonsters), std::end(ActiveMonsters), [](int id) { return id >= 0 && id < MAXMONSTERS; }))
+			return false;
+		for (int i = 0; i < ActiveMonsterCount; i++)
+			LoadMonster(&file, Monsters[ActiveMonsters[i]]);
+		for (int i = 0; i < ActiveMonsterCount; i++)
+			SyncPackSize(Monsters[ActiveMonsters[i]]);
+		// Skip ActiveMissiles
+		file.Skip<int8_t>(MaxMissilesForSaveGame);
+		// Skip AvailableMissiles
+		file.Skip<int8_t>(MaxMissilesForSaveGame);
+		for (int i = 0; i < header.missileCount; i++)
+			LoadMissile(&file);
+		for (int &objectId : ActiveObjects)
+			objectId = file.NextLE<int8_t>();
+		for (int &objectId : AvailableObjects)
+			objectId = file.NextLE<int8_t>();
+		const auto isObjectId = [](int id) { return id >= 0 && id < MAXOBJECTS; };
+		if (!std::all_of(std::begin(ActiveObjects), std::end(ActiveObjects), isObjectId) || !std::all_of(std::begin(AvailableObjects), std::end(AvailableObjects), isObjectId))
+			return false;
+		for (int i = 0; i < ActiveObjectCount; i++)
+			LoadObject(file, Objects[ActiveObjects[i]]);
+		if (!gbSkipSync) {
+			for (int i = 0; i < ActiveObjectCount; i++)
+				SyncObjectAnim(Objects[ActiveObjects[i]]);
+		}
+
+		ActiveLightCount = file.NextBE<int32_t>();
+		if (ActiveLightCount < 0 || ActiveLightCount > MAXLIGHTS)
+			return false;
+
+		for (uint8_t &lightId : ActiveLights)
+			lightId = file.NextLE<uint8_t>();
+		if (!std::all_of(std::begin(ActiveLights), std::end(ActiveLights), [](uint8_t id) { return id < MAXLIGHTS; }))
+			return false;
+		for (int i = 0; i < ActiveLightCount; i++)
+			LoadLighting(&file, &Lights[ActiveLights[i]]);
+
+		VisionId = file.NextBE<int32_t>();
+		VisionCount = file.NextBE<int32_t>();
+		if (VisionCount < 0 || VisionCount > MAXVISION)
+			return false;
+
+		for (int i = 0; i < VisionCount; i++)
+			LoadLighting(&file, &VisionList[i]);
+	}
+
+	if (!LoadDroppedItems(file, header.itemCount))
+		return false;
+
+	for (bool &uniqueItemFlag : UniqueItemFlags)
+		uniqueItemFlag = file.NextBool8();
+
+	file.NextGridLE<int8_t>(dLight);
+	file.NextGridLE<uint8_t>(dFlags, [](uint8_t flags) { return static_cast<DungeonFlag>(flags) & DungeonFlag::LoadedFlags; });
+	file.NextGridLE<int8_t>(dPlayer);
+
+	// skip dItem indexes, this gets populated in LoadDroppedItems
+	file.Skip<uint8_t>(MAXDUNX * MAXDUNY);
+
+	if (leveltype != DTYPE_TOWN) {
+		file.NextGridBE<int32_t>(dMonster);
+		file.NextGridLE<int8_t>(dCorpse);
+		file.NextGridLE<int8_t>(dObject);
+		file.NextGridLE<int8_t>(dLight);
+		file.NextGridLE<int8_t>(dPreLight);
+		file.NextGridLE<uint8_t>(AutomapView);
+		file.Skip(MAXDUNX * MAXDUNY); // dMissile
+	}
+
+	numpremium = file.NextBE<int32_t>();
+	premiumlevel = file.NextBE<int32_t>();
+
+	for (int i = 0; i < giNumberOfSmithPremiumItems; i++)
+		LoadPremium(file, i);
+
+	AutomapActive = file.NextBool8();
+	AutoMapScale = file.NextBE<int32_t>();
+
+	return true;
+}
+
 } // namespace
 
 void RemoveInvalidItem(Item &item)
@@ -1765,11 +2214,11 @@ void LoadHotkeys()
 	myPlayer._pRSplType = static_cast<spell_type>(file.NextLE<uint8_t>());
 }
 
-void SaveHotkeys()
+void SaveHotkeys(SaveSnapshot &snapshot)
 {
 	auto &myPlayer = Players[MyPlayerId];
 
-	SaveHelper file(CurrentSaveArchive(), "hotkeys", HotkeysSize());
+	SaveHelper file(snapshot, "hotkeys", HotkeysSize());
 
 	// Write the number of spell hotkeys
 	file.WriteLE<uint8_t>(static_cast<uint8_t>(NumHotkeys));
@@ -1798,11 +2247,13 @@ void LoadHeroItems(Player &player)
 	LoadMatchingItems(file, NUM_INVLOC, player.InvBody);
 	LoadMatchingItems(file, NUM_INV_GRID_ELEM, player.InvList);
 	LoadMatchingItems(file, MAXBELTITEMS, player.SpdList);
+	if (!file.Finish())
+		app_fatal("%s", _("Invalid save file").c_str());
 
 	gbIsHellfireSaveGame = gbIsHellfire;
 }
 
-constexpr uint8_t StashVersion = 0;
+constexpr uint8_t StashVersion = 1;
 
 void LoadStash()
 {
@@ -1814,7 +2265,10 @@ void LoadStash()
 
 	Stash = {};
 
-	LoadHelper file(OpenStashArchive(), filename);
+	std::optional<MpqArchive> archive = OpenStashArchive();
+	if (!archive)
+		return;
+	LoadHelper file(*archive, filename);
 	if (!file.IsValid())
 		return;
 
@@ -1825,19 +2279,31 @@ void LoadStash()
 	Stash.gold = file.NextLE<uint32_t>();
 
 	auto pages = file.NextLE<uint32_t>();
-	for (unsigned i = 0; i < pages; i++) {
-		auto page = file.NextLE<uint32_t>();
-		for (auto &row : Stash.stashGrids[page]) {
-			for (uint16_t &cell : row) {
-				cell = file.NextLE<uint16_t>();
+	if (version == StashVersionSingleFile) {
+		for (unsigned i = 0; i < pages; i++) {
+			auto page = file.NextLE<uint32_t>();
+			if (page >= CountStashPages) {
+				file.Skip<uint16_t>(sizeof(StashStruct::StashGrid) / sizeof(uint16_t));
+				continue;
+			}
+			for (auto &row : Stash.stashGrids[page]) {
+				for (uint16_t &cell : row) {
+					cell = file.NextLE<uint16_t>();
+				}
 			}
+			// Converted to the current format with the next save
+			Stash.dirtyPages.insert(page);
 		}
-	}
 
-	auto itemCount = file.NextLE<uint32_t>();
-	Stash.stashList.resize(itemCount);
-	for (unsigned i = 0; i < itemCount; i++) {
-		LoadItemData(file, Stash.stashList[i]);
+		auto itemCount = file.NextLE<uint32_t>();
+		Stash.stashList.resize(itemCount);
+		for (unsigned i = 0; i < itemCount; i++) {
+			LoadItemData(file, Stash.stashList[i]);
+		}
+	} else {
+		for (unsigned i = 0; i < pages; i++) {
+			LoadStashPage(*archive, file.NextLE<uint32_t>());
+		}
 	}
 
 	Stash.SetPage(file.NextLE<uint32_t>());
@@ -1864,55 +2330,21 @@ void LoadGame(bool firstflag)
 	if (!IsHeaderValid(file.NextLE<uint32_t>()))
 		app_fatal("%s", _("Invalid save file").c_str());
 
-	if (gbIsHellfireSaveGame) {
-		giNumberOfLevels = 25;
-		giNumberQuests = 24;
-		giNumberOfSmithPremiumItems = 15;
-	} else {
-		// Todo initialize additional levels and quests if we are running Hellfire
-		giNumberOfLevels = 17;
-		giNumberQuests = 16;
-		giNumberOfSmithPremiumItems = 6;
-	}
-
 	pfile_remove_temp_files();
 
-	setlevel = file.NextBool8();
-	setlvlnum = static_cast<_setlevels>(file.NextBE<uint32_t>());
-	currlevel = file.NextBE<uint32_t>();
-	leveltype = static_cast<dungeon_type>(file.NextBE<uint32_t>());
-	if (!setlevel)
-		leveltype = gnLevelTypeTbl[currlevel];
-	int viewX = file.NextBE<int32_t>();
-	int viewY = file.NextBE<int32_t>();
-	invflag = file.NextBool8();
-	chrflag = file.NextBool8();
-	int tmpNummonsters = file.NextBE<int32_t>();
-	auto savedItemCount = file.NextBE<uint32_t>();
-	int tmpNummissiles = file.NextBE<int32_t>();
-	int tmpNobjects = file.NextBE<int32_t>();
+	GameFileHeader header;
+	if (!LoadGameHeader(file, header))
+		app_fatal("%s", _("Invalid save file").c_str());
 
 	if (!gbIsHellfire && currlevel > 17)
 		app_fatal("%s", _("Player is on a Hellfire only level").c_str());
 
-	for (uint8_t i = 0; i < giNumberOfLevels; i++) {
-		glSeedTbl[i] = file.NextBE<uint32_t>();
-		file.Skip(4); // Skip loading gnLevelTypeTbl
-	}
-
 	auto &myPlayer = Players[MyPlayerId];
 
-	LoadPlayer(file, myPlayer);
-
 	sgGameInitInfo.nDifficulty = myPlayer.pDifficulty;
 	if (sgGameInitInfo.nDifficulty < DIFF_NORMAL || sgGameInitInfo.nDifficulty > DIFF_HELL)
 		sgGameInitInfo.nDifficulty = DIFF_NORMAL;
 
-	for (int i = 0; i < giNumberQuests; i++)
-		LoadQuest(&file, i);
-	for (int i = 0; i < MAXPORTAL; i++)
-		LoadPortal(&file, i);
-
 	if (gbIsHellfireSaveGame != gbIsHellfire) {
 		ConvertLevels();
 		RemoveEmptyInventory(myPlayer);
@@ -1922,110 +2354,14 @@ void LoadGame(bool firstflag)
 	SyncInitPlr(MyPlayerId);
 	SyncPlrAnim(MyPlayerId);
 
-	ViewPosition = { viewX, viewY };
-	ActiveMonsterCount = tmpNummonsters;
-	ActiveObjectCount = tmpNobjects;
-
-	for (int &monstkill : MonsterKillCounts)
-		monstkill = file.NextBE<int32_t>();
-
-	if (leveltype != DTYPE_TOWN) {
-		for (int &monsterId : ActiveMonsters)
-			monsterId = file.NextBE<int32_t>();
-		for (int i = 0; i < ActiveMonsterCount; i++)
-			LoadMonster(&file, Monsters[ActiveMonsters[i]]);
-		for (int i = 0; i < ActiveMonsterCount; i++)
-			SyncPackSize(Monsters[ActiveMonsters[i]]);
-		// Skip ActiveMissiles
-		file.Skip<int8_t>(MaxMissilesForSaveGame);
-		// Skip AvailableMissiles
-		file.Skip<int8_t>(MaxMissilesForSaveGame);
-		for (int i = 0; i < tmpNummissiles; i++)
-			LoadMissile(&file);
-		for (int &objectId : ActiveObjects)
-			objectId = file.NextLE<int8_t>();
-		for (int &objectId : AvailableObjects)
-			objectId = file.NextLE<int8_t>();
-		for (int i = 0; i < ActiveObjectCount; i++)
-			LoadObject(file, Objects[ActiveObjects[i]]);
-		for (int i = 0; i < ActiveObjectCount; i++)
-			SyncObjectAnim(Objects[ActiveObjects[i]]);
-
-		ActiveLightCount = file.NextBE<int32_t>();
-
-		for (uint8_t &lightId : ActiveLights)
-			lightId = file.NextLE<uint8_t>();
-		for (int i = 0; i < ActiveLightCount; i++)
-			LoadLighting(&file, &Lights[ActiveLights[i]]);
-
-		VisionId = file.NextBE<int32_t>();
-		VisionCount = file.NextBE<int32_t>();
-
-		for (int i = 0; i < VisionCount; i++)
-			LoadLighting(&file, &VisionList[i]);
-	}
-
-	LoadDroppedItems(file, savedItemCount);
+	if (!LoadGameState(file, header) || !file.Finish())
+		app_fatal("%s", _("Invalid save file").c_str());
 
 	LoadAdditionalMissiles();
 
-	for (bool &uniqueItemFlag : UniqueItemFlags)
-		uniqueItemFlag = file.NextBool8();
-
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			dLight[i][j] = file.NextLE<int8_t>();
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			dFlags[i][j] = static_cast<DungeonFlag>(file.NextLE<uint8_t>()) & DungeonFlag::LoadedFlags;
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			dPlayer[i][j] = file.NextLE<int8_t>();
-	}
-
-	// skip dItem indexes, this gets populated in LoadDroppedItems
-	file.Skip<uint8_t>(MAXDUNX * MAXDUNY);
-
-	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dMonster[i][j] = file.NextBE<int32_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dCorpse[i][j] = file.NextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dObject[i][j] = file.NextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dLight[i][j] = file.NextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dPreLight[i][j] = file.NextLE<int8_t>();
-		}
-		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++) // NOLINT(modernize-loop-convert)
-				AutomapView[i][j] = file.NextLE<uint8_t>();
-		}
-		file.Skip(MAXDUNX * MAXDUNY); // dMissile
-	}
-
-	numpremium = file.NextBE<int32_t>();
-	premiumlevel = file.NextBE<int32_t>();
-
-	for (int i = 0; i < giNumberOfSmithPremiumItems; i++)
-		LoadPremium(file, i);
 	if (gbIsHellfire && !gbIsHellfireSaveGame)
 		SpawnPremium(MyPlayerId);
 
-	AutomapActive = file.NextBool8();
-	AutoMapScale = file.NextBE<int32_t>();
 	AutomapZoomReset();
 	ResyncQuests();
 
@@ -2036,7 +2372,7 @@ void LoadGame(bool firstflag)
 	ProcessVisionList();
 	// convert stray manashield missiles into pManaShield flag
 	for (auto &missile : Missiles) {
-		if (missile._mitype == MIS_MANASHIELD && !missile._miDelFlag) {
+		if (missile._mitype == MIS_MANASHIELD && !missile._miDelFlag && missile._misource >= 0 && missile._misource < MAX_PLRS) {
 			Players[missile._misource].pManaShield = true;
 			missile._miDelFlag = true;
 		}
@@ -2054,10 +2390,10 @@ void LoadGame(bool firstflag)
 	gbIsHellfireSaveGame = gbIsHellfire;
 }
 
-void SaveHeroItems(Player &player)
+void SaveHeroItems(SaveSnapshot &snapshot, Player &player)
 {
 	size_t itemCount = NUM_INVLOC + NUM_INV_GRID_ELEM + MAXBELTITEMS;
-	SaveHelper file(CurrentSaveArchive(), "heroitems", itemCount * (gbIsHellfire ? HellfireItemSaveSize : DiabloItemSaveSize) + sizeof(uint8_t));
+	SaveHelper file(snapshot, "heroitems", itemCount * (gbIsHellfire ? HellfireItemSaveSize : DiabloItemSaveSize) + sizeof(uint8_t));
 
 	file.WriteLE<uint8_t>(gbIsHellfire ? 1 : 0);
 
@@ -2069,7 +2405,7 @@ void SaveHeroItems(Player &player)
 		SaveItem(file, item);
 }
 
-void SaveStash()
+void SaveStash(SaveSnapshot &snapshot)
 {
 	const char *filename;
 	if (!gbIsMultiplayer)
@@ -2077,50 +2413,47 @@ void SaveStash()
 	else
 		filename = "mpstashitems";
 
-	const int itemSize = (gbIsHellfire ? HellfireItemSaveSize : DiabloItemSaveSize);
+	std::vector<unsigned> pagesToSave;
+	for (unsigned page = 0; page < CountStashPages; page++) {
+		const StashStruct::StashGrid &grid = Stash.stashGrids[page];
+		if (std::any_of(grid.cbegin(), grid.cend(), [](const auto &row) {
+			    return std::any_of(row.cbegin(), row.cend(), [](auto cell) {
+				    return cell > 0;
+			    });
+		    })) {
+			// found a page that contains at least one item
+			pagesToSave.push_back(page);
+		}
+	};
+
+	// Only the pages that changed are rewritten, the rest of the archive is left as it is
+	for (unsigned page : Stash.dirtyPages) {
+		if (std::binary_search(pagesToSave.begin(), pagesToSave.end(), page)) {
+			SaveStashPage(snapshot, page);
+		} else {
+			char szName[MAX_PATH];
+			GetStashPageFileName(page, szName);
+			snapshot.RemoveFile(szName);
+		}
+	}
 
 	SaveHelper file(
-	    StashArchive(),
+	    snapshot,
 	    filename,
 	    sizeof(uint8_t)
 	        + sizeof(uint32_t)
 	        + sizeof(uint32_t)
-	        + (sizeof(uint32_t) + 10 * 10 * sizeof(uint16_t)) * Stash.stashGrids.size()
-	        + sizeof(uint32_t)
-	        + itemSize * Stash.stashList.size()
+	        + sizeof(uint32_t) * pagesToSave.size()
 	        + sizeof(uint32_t));
 
 	file.WriteLE<uint8_t>(StashVersion);
 
 	file.WriteLE<uint32_t>(Stash.gold);
 
-	std::vector<unsigned> pagesToSave;
-	for (const auto &stashPage : Stash.stashGrids) {
-		if (std::any_of(stashPage.second.cbegin(), stashPage.second.cend(), [](const auto &row) {
-			    return std::any_of(row.cbegin(), row.cend(), [](auto cell) {
-				    return cell > 0;
-			    });
-		    })) {
-			// found a page that contains at least one item
-			pagesToSave.push_back(stashPage.first);
-		}
-	};
-
 	// Current stash size is 100 pages. Will definitely fit in a 32 bit value.
 	file.WriteLE<uint32_t>(static_cast<uint32_t>(pagesToSave.size()));
 	for (const auto &page : pagesToSave) {
 		file.WriteLE<uint32_t>(page);
-		for (const auto &row : Stash.stashGrids[page]) {
-			for (uint16_t cell : row) {
-				file.WriteLE<uint16_t>(cell);
-			}
-		}
-	}
-
-	// 100 pages of 100 items is still only 10 000, as with the page count will definitely fit in 32 bits even in the worst case.
-	file.WriteLE<uint32_t>(static_cast<uint32_t>(Stash.stashList.size()));
-	for (const Item &item : Stash.stashList) {
-		SaveItem(file, item);
 	}
 
 	file.WriteLE<uint32_t>(static_cast<uint32_t>(Stash.GetPage()));
@@ -2230,50 +2563,21 @@ void SaveGameData()
 	for (bool uniqueItemFlag : UniqueItemFlags)
 		file.WriteLE<uint8_t>(uniqueItemFlag ? 1 : 0);
 
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			file.WriteLE<int8_t>(dLight[i][j]);
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			file.WriteLE<uint8_t>(static_cast<uint8_t>(dFlags[i][j] & DungeonFlag::SavedFlags));
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			file.WriteLE<int8_t>(dPlayer[i][j]);
-	}
+	file.WriteGridLE<int8_t>(dLight);
+	file.WriteGridLE<uint8_t>(dFlags, [](DungeonFlag flags) { return flags & DungeonFlag::SavedFlags; });
+	file.WriteGridLE<int8_t>(dPlayer);
 
 	SaveDroppedItemLocations(file, itemIndexes);
 
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteBE<int32_t>(dMonster[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dCorpse[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dObject[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dLight[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dPreLight[i][j]);
-		}
-		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<uint8_t>(AutomapView[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)                                 // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(TileContainsMissile({ i, j }) ? -1 : 0); // For backwards compatability
-		}
+		file.WriteGridBE<int32_t>(dMonster);
+		file.WriteGridLE<int8_t>(dCorpse);
+		file.WriteGridLE<int8_t>(dObject);
+		file.WriteGridLE<int8_t>(dLight);
+		file.WriteGridLE<int8_t>(dPreLight);
+		file.WriteGridLE<uint8_t>(AutomapView);
+		// For backwards compatability, the missile layer of dFlags is stored as the old dMissile grid
+		file.WriteGridLE<int8_t>(dFlags, [](DungeonFlag flags) { return HasAnyOf(flags, DungeonFlag::Missile) ? -1 : 0; });
 	}
 
 	file.WriteBE<int32_t>(numpremium);
@@ -2295,10 +2599,8 @@ void SaveGame()
 	sfile_write_stash();
 }
 
-void SaveLevel()
+void SaveLevel(SaveSnapshot &snapshot)
 {
-	PFileScopedArchiveWriter scopedWriter;
-
 	auto &myPlayer = Players[MyPlayerId];
 
 	DoUnVision(myPlayer.position.tile, myPlayer._pLightRad); // fix for vision staying on the level
@@ -2308,13 +2610,10 @@ void SaveLevel()
 
 	char szName[MAX_PATH];
 	GetTempLevelNames(szName);
-	SaveHelper file(CurrentSaveArchive(), szName, 256 * 1024);
+	SaveHelper file(snapshot, szName, 256 * 1024);
 
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dCorpse[i][j]);
-		}
+		file.WriteGridLE<int8_t>(dCorpse);
 	}
 
 	file.WriteBE<int32_t>(ActiveMonsterCount);
@@ -2336,33 +2635,15 @@ void SaveLevel()
 
 	auto itemIndexes = SaveDroppedItems(file);
 
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			file.WriteLE<uint8_t>(static_cast<uint8_t>(dFlags[i][j] & DungeonFlag::SavedFlags));
-	}
+	file.WriteGridLE<uint8_t>(dFlags, [](DungeonFlag flags) { return flags & DungeonFlag::SavedFlags; });
 	SaveDroppedItemLocations(file, itemIndexes);
 
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteBE<int32_t>(dMonster[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dObject[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dLight[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dPreLight[i][j]);
-		}
-		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<uint8_t>(AutomapView[i][j]);
-		}
+		file.WriteGridBE<int32_t>(dMonster);
+		file.WriteGridLE<int8_t>(dObject);
+		file.WriteGridLE<int8_t>(dLight);
+		file.WriteGridLE<int8_t>(dPreLight);
+		file.WriteGridLE<uint8_t>(AutomapView);
 	}
 
 	if (!setlevel)
@@ -2371,77 +2652,24 @@ void SaveLevel()
 		myPlayer._pSLvlVisited[setlvlnum] = true;
 }
 
+void SaveLevel()
+{
+	SaveSnapshot snapshot;
+	SaveLevel(snapshot);
+	pfile_cache_levels(snapshot);
+}
+
 void LoadLevel()
 {
 	char szName[MAX_PATH];
 	GetPermLevelNames(szName);
-	LoadHelper file(OpenSaveArchive(gSaveNumber), szName);
+	size_t cachedSize;
+	std::unique_ptr<byte[]> cachedLevel = pfile_read_cached_level(szName, &cachedSize);
+	LoadHelper file = cachedLevel != nullptr ? LoadHelper(std::move(cachedLevel), cachedSize) : LoadHelper(OpenSaveArchive(gSaveNumber), szName);
 	if (!file.IsValid())
 		app_fatal("%s", _("Unable to open save file archive").c_str());
-
-	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dCorpse[i][j] = file.NextLE<int8_t>();
-		}
-		SyncUniqDead();
-	}
-
-	ActiveMonsterCount = file.NextBE<int32_t>();
-	auto savedItemCount = file.NextBE<uint32_t>();
-	ActiveObjectCount = file.NextBE<int32_t>();
-
-	if (leveltype != DTYPE_TOWN) {
-		for (int &monsterId : ActiveMonsters)
-			monsterId = file.NextBE<int32_t>();
-		for (int i = 0; i < ActiveMonsterCount; i++)
-			LoadMonster(&file, Monsters[ActiveMonsters[i]]);
-		for (int &objectId : ActiveObjects)
-			objectId = file.NextLE<int8_t>();
-		for (int &objectId : AvailableObjects)
-			objectId = file.NextLE<int8_t>();
-		for (int i = 0; i < ActiveObjectCount; i++)
-			LoadObject(file, Objects[ActiveObjects[i]]);
-		if (!gbSkipSync) {
-			for (int i = 0; i < ActiveObjectCount; i++)
-				SyncObjectAnim(Objects[ActiveObjects[i]]);
-		}
-	}
-
-	LoadDroppedItems(file, savedItemCount);
-
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			dFlags[i][j] = static_cast<DungeonFlag>(file.NextLE<uint8_t>()) & DungeonFlag::LoadedFlags;
-	}
-
-	// skip dItem indexes, this gets populated in LoadDroppedItems
-	file.Skip<uint8_t>(MAXDUNX * MAXDUNY);
-
-	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dMonster[i][j] = file.NextBE<int32_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dObject[i][j] = file.NextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dLight[i][j] = file.NextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dPreLight[i][j] = file.NextLE<int8_t>();
-		}
-		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++) { // NOLINT(modernize-loop-convert)
-				const auto automapView = static_cast<MapExplorationType>(file.NextLE<uint8_t>());
-				AutomapView[i][j] = automapView == MAP_EXP_OLD ? MAP_EXP_SELF : automapView;
-			}
-		}
-	}
+	if (!LoadLevelData(file) || !file.Finish())
+		app_fatal("%s", _("Invalid save file").c_str());
 
 	if (!gbSkipSync) {
 		AutomapZoomReset();
@@ -2456,4 +2684,33 @@ void LoadLevel()
 	}
 }
 
+bool LoadGameFromMemory(std::unique_ptr<byte[]> data, size_t size)
+{
+	LoadHelper file(std::move(data), size);
+	if (!file.IsValid() || !IsHeaderValid(file.NextLE<uint32_t>()))
+		return false;
+
+	GameFileHeader header;
+	bool valid = LoadGameHeader(file, header);
+	if (valid) {
+		gbSkipSync = true;
+		valid = LoadGameState(file, header);
+		gbSkipSync = false;
+	}
+	gbIsHellfireSaveGame = gbIsHellfire;
+	return valid;
+}
+
+bool LoadLevelFromMemory(std::unique_ptr<byte[]> data, size_t size)
+{
+	LoadHelper file(std::move(data), size);
+	if (!file.IsValid())
+		return false;
+
+	gbSkipSync = true;
+	const bool valid = LoadLevelData(file);
+	gbSkipSync = false;
+	return valid;
+}
+
 } // namespace devilution
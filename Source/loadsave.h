@@ -5,11 +5,15 @@
  */
 #pragma once
 
+#include <memory>
+
 #include "player.h"
 #include "utils/attributes.h"
 
 namespace devilution {
 
+class SaveSnapshot;
+
 extern DVL_API_FOR_TEST bool gbIsHellfireSaveGame;
 extern DVL_API_FOR_TEST uint8_t giNumberOfLevels;
 
@@ -32,13 +36,27 @@ void RemoveEmptyInventory(Player &player);
  * @param firstflag Can be set to false if we are simply reloading the current game
  */
 void LoadGame(bool firstflag);
-void SaveHotkeys();
-void SaveHeroItems(Player &player);
+void SaveHotkeys(SaveSnapshot &snapshot);
+void SaveHeroItems(SaveSnapshot &snapshot, Player &player);
 void SaveGameData();
 void SaveGame();
+/** @brief Serialises the current level, the file is added to the snapshot once the function returns. */
+void SaveLevel(SaveSnapshot &snapshot);
+/** @brief Moves the current level into the level cache, see pfile_cache_levels(). */
 void SaveLevel();
 void LoadLevel();
+/**
+ * @brief Parses an unencoded level file without syncing animations, so it works without the game assets.
+ * @return false if the level file is corrupted
+ */
+bool LoadLevelFromMemory(std::unique_ptr<byte[]> data, size_t size);
+/**
+ * @brief Parses an unencoded game file up to the point where the level would be set up, and the rest of it
+ * without syncing animations, so it works without the game assets.
+ * @return false if the game file is corrupted
+ */
+bool LoadGameFromMemory(std::unique_ptr<byte[]> data, size_t size);
 void LoadStash();
-void SaveStash();
+void SaveStash(SaveSnapshot &snapshot);
 
 } // namespace devilution
@@ -1189,8 +1189,10 @@ void InitMissiles()
 		for (auto &missile : Missiles) {
 			if (missile._mitype == MIS_INFRA) {
 				int src = missile._misource;
-				if (src == MyPlayerId)
-					CalcPlrItemVals(myPlayer, true);
+				if (src == MyPlayerId) {
+					myPlayer.MarkStatsDirty(PlayerStatsDirty::Buffs);
+					CalcPlrInv(myPlayer, true);
+				}
 			}
 		}
 	}
@@ -1202,7 +1204,8 @@ void InitMissiles()
 			if (missile._mitype == MIS_BLODBOIL) {
 				if (missile._misource == MyPlayerId) {
 					int missingHP = myPlayer._pMaxHP - myPlayer._pHitPoints;
-					CalcPlrItemVals(myPlayer, true);
+					myPlayer.MarkStatsDirty(PlayerStatsDirty::Buffs);
+					CalcPlrInv(myPlayer, true);
 					ApplyPlrDamage(MyPlayerId, 0, 1, missingHP + missile.var2);
 				}
 			}
@@ -1453,6 +1456,7 @@ void AddManaTrap(Missile &missile, const AddMissileParameter & /*parameter*/)
 
 		player._pMana = 0;
 		player._pManaBase = player._pMana + player._pMaxManaBase - player._pMaxMana;
+		player.MarkStatsDirty(PlayerStatsDirty::Level);
 		CalcPlrInv(player, false);
 		drawmanaflag = true;
 		PlaySfxLoc(TSFX_COW7, *trappedPlayerPosition);
@@ -2530,7 +2534,8 @@ void AddBlodboil(Missile &missile, const AddMissileParameter & /*parameter*/)
 	missile.var2 = tmp;
 	int lvl = player._pLevel * 2;
 	missile._mirange = lvl + 10 * missile._mispllvl + 245;
-	CalcPlrItemVals(player, true);
+	player.MarkStatsDirty(PlayerStatsDirty::Buffs);
+	CalcPlrInv(player, true);
 	force_redraw = 255;
 	player.Say(HeroSpeech::Aaaaargh);
 }
@@ -3776,7 +3781,8 @@ void MI_Infra(Missile &missile)
 	player._pInfraFlag = true;
 	if (missile._mirange == 0) {
 		missile._miDelFlag = true;
-		CalcPlrItemVals(player, true);
+		player.MarkStatsDirty(PlayerStatsDirty::Buffs);
+		CalcPlrInv(player, true);
 	}
 }
 
@@ -3905,7 +3911,8 @@ void MI_Blodboil(Missile &missile)
 		hpdif += missile.var2;
 	}
 
-	CalcPlrItemVals(player, true);
+	player.MarkStatsDirty(PlayerStatsDirty::Buffs);
+	CalcPlrInv(player, true);
 	ApplyPlrDamage(id, 0, 1, hpdif);
 	force_redraw = 255;
 	player.Say(HeroSpeech::HeavyBreathing);
@@ -69,6 +69,11 @@ struct MpqHashEntry {
 struct MpqBlockEntry {
 	static constexpr uint32_t FlagExists = 0x80000000;
 	static constexpr uint32_t CompressPkZip = 0x00000100;
+	/** Every sector starts with a byte telling how it was compressed, unless it is stored as is. */
+	static constexpr uint32_t CompressMulti = 0x00000200;
+
+	/** Sector compression tag for zlib deflate, used with CompressMulti. */
+	static constexpr uint8_t SectorCompressionZlib = 0x02;
 
 	// Offset to the start of this block.
 	uint32_t offset;
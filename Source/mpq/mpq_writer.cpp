@@ -1,10 +1,16 @@
 #include "mpq/mpq_writer.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <type_traits>
+#include <vector>
+
+#include <zlib.h>
 
 #include "appfat.h"
 #include "encrypt.h"
@@ -12,6 +18,9 @@
 #include "utils/endian.hpp"
 #include "utils/file_util.h"
 #include "utils/log.hpp"
+#include "utils/sdl_cond.h"
+#include "utils/sdl_mutex.h"
+#include "utils/sdl_thread.h"
 
 namespace devilution {
 
@@ -58,6 +67,97 @@ constexpr uint32_t BlockSize = 512 << BlockSizeFactor; // 4096
 // Sometimes we can end up with smaller blocks.
 constexpr uint32_t MinBlockSize = 1024;
 
+/** Files with fewer sectors are compressed on the calling thread only, starting workers isn't worth it. */
+constexpr uint32_t MinSectorsPerWorker = 8;
+
+struct DeflateStream {
+	z_stream stream {};
+	bool initialized;
+
+	DeflateStream()
+	    : initialized(deflateInit(&stream, Z_BEST_SPEED) == Z_OK)
+	{
+	}
+
+	~DeflateStream()
+	{
+		if (initialized)
+			deflateEnd(&stream);
+	}
+};
+
+/**
+ * @brief Compresses a sector in place with zlib, prefixed by its compression tag.
+ * @return The new size of the sector, or size if it was left uncompressed.
+ */
+uint32_t ZlibCompressSector(byte *sector, uint32_t size)
+{
+	// Like PkwareCompress, the compressor state is kept around for the next sector
+	thread_local DeflateStream deflater;
+	thread_local std::unique_ptr<byte[]> destData;
+
+	// The tag and the compressed data have to be smaller than the sector, otherwise it is stored as is
+	if (size <= 2 || !deflater.initialized || deflateReset(&deflater.stream) != Z_OK)
+		return size;
+	if (destData == nullptr)
+		destData.reset(new byte[BlockSize]);
+
+	z_stream &stream = deflater.stream;
+	stream.next_in = reinterpret_cast<Bytef *>(sector);
+	stream.avail_in = size;
+	stream.next_out = reinterpret_cast<Bytef *>(&destData[1]);
+	stream.avail_out = size - 2;
+	if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+		return size;
+
+	destData[0] = static_cast<byte>(MpqBlockEntry::SectorCompressionZlib);
+	const auto compressedSize = static_cast<uint32_t>(stream.total_out + 1);
+	memcpy(sector, destData.get(), compressedSize);
+	return compressedSize;
+}
+
+/** Sectors are independent of each other, so they are handed out to whichever thread is free. */
+struct SectorCompressor {
+	MpqCompression compression;
+	const byte *fileData;
+	size_t fileSize;
+	uint32_t numSectors;
+	/** numSectors * BlockSize bytes, sector i is compressed in place at i * BlockSize. */
+	byte *sectors;
+	uint32_t *compressedSizes;
+	std::atomic<uint32_t> nextSector { 0 };
+
+	void Run()
+	{
+		uint32_t sector;
+		while ((sector = nextSector.fetch_add(1, std::memory_order_relaxed)) < numSectors) {
+			const size_t offset = static_cast<size_t>(sector) * BlockSize;
+			const auto len = static_cast<uint32_t>(std::min<size_t>(fileSize - offset, BlockSize));
+			memcpy(&sectors[offset], &fileData[offset], len);
+			if (compression == MpqCompression::Zlib)
+				compressedSizes[sector] = ZlibCompressSector(&sectors[offset], len);
+			else
+				compressedSizes[sector] = PkwareCompress(&sectors[offset], len);
+		}
+	}
+
+};
+
+unsigned GetCpuCount()
+{
+#ifdef USE_SDL1
+	return 1;
+#else
+	return static_cast<unsigned>(std::max(SDL_GetCPUCount(), 1));
+#endif
+}
+
+/** @return Whether the file is large enough for the helper threads to be worth waking up. */
+bool UseSectorWorkers(uint32_t numSectors)
+{
+	return std::min(GetCpuCount(), numSectors / MinSectorsPerWorker) > 1;
+}
+
 void ByteSwapHdr(MpqFileHeader *hdr)
 {
 	hdr->signature = SDL_SwapLE32(hdr->signature);
@@ -83,6 +183,95 @@ bool IsUnallocatedBlock(const MpqBlockEntry *block)
 
 } // namespace
 
+/**
+ * Started on the first file that is large enough and parked on a condition variable between
+ * files, so that the thread local compressor buffers are reused instead of allocated per file.
+ */
+class MpqWriter::SectorWorkers {
+public:
+	explicit SectorWorkers(unsigned count)
+	{
+		threads_.reserve(count);
+		for (unsigned i = 0; i < count; i++)
+			threads_.emplace_back(Handler, this);
+	}
+
+	~SectorWorkers()
+	{
+		{
+			std::lock_guard<SdlMutex> lock(mutex_);
+			stop_ = true;
+		}
+		wake_.broadcast();
+		for (SdlThread &thread : threads_)
+			thread.join();
+	}
+
+	/** @brief Compresses the sectors on the calling thread and all workers, returns once every sector is done. */
+	void Run(SectorCompressor &job)
+	{
+		{
+			std::lock_guard<SdlMutex> lock(mutex_);
+			job_ = &job;
+			generation_++;
+			busy_ = static_cast<unsigned>(threads_.size());
+		}
+		wake_.broadcast();
+
+		job.Run();
+
+		std::lock_guard<SdlMutex> lock(mutex_);
+		while (busy_ != 0)
+			done_.wait(mutex_);
+		job_ = nullptr;
+	}
+
+private:
+	static int SDLCALL Handler(void *workers)
+	{
+		static_cast<SectorWorkers *>(workers)->Work();
+		return 0;
+	}
+
+	void Work()
+	{
+		uint32_t seenGeneration = 0;
+		std::unique_lock<SdlMutex> lock(mutex_);
+		while (true) {
+			while (!stop_ && generation_ == seenGeneration)
+				wake_.wait(mutex_);
+			if (stop_)
+				return;
+			seenGeneration = generation_;
+			SectorCompressor *job = job_;
+
+			lock.unlock();
+			job->Run();
+			lock.lock();
+
+			if (--busy_ == 0)
+				done_.signal();
+		}
+	}
+
+	SdlMutex mutex_;
+	SdlCond wake_;
+	SdlCond done_;
+	SectorCompressor *job_ = nullptr;
+	uint32_t generation_ = 0;
+	/** Workers that have not finished the current job yet. */
+	unsigned busy_ = 0;
+	bool stop_ = false;
+	std::vector<SdlThread> threads_;
+};
+
+MpqWriter::MpqWriter() = default;
+
+MpqWriter::~MpqWriter()
+{
+	Close();
+}
+
 bool MpqWriter::Open(const char *path)
 {
 	Close(/*clearTables=*/false);
@@ -376,7 +565,8 @@ bool MpqWriter::WriteFileContents(const char *filename, const byte *fileData, si
 	// `packedSize` is reduced at the end of the function if it turns out to be smaller.
 	block->packedSize = fileSize + offsetTableByteSize;
 	block->unpackedSize = fileSize;
-	block->flags = MpqBlockEntry::FlagExists | MpqBlockEntry::CompressPkZip;
+	block->flags = MpqBlockEntry::FlagExists;
+	block->flags |= compression_ == MpqCompression::Zlib ? MpqBlockEntry::CompressMulti : MpqBlockEntry::CompressPkZip;
 
 	// We populate the table of sector offsets while we write the data.
 	// We can't pre-populate it because we don't know the compressed sector sizes yet.
@@ -406,22 +596,34 @@ bool MpqWriter::WriteFileContents(const char *filename, const byte *fileData, si
 	}
 #endif
 
+	std::unique_ptr<byte[]> sectors { new byte[static_cast<size_t>(numSectors) * BlockSize] };
+	std::unique_ptr<uint32_t[]> compressedSizes { new uint32_t[numSectors] };
+	{
+		SectorCompressor compressor;
+		compressor.compression = compression_;
+		compressor.fileData = fileData;
+		compressor.fileSize = fileSize;
+		compressor.numSectors = numSectors;
+		compressor.sectors = sectors.get();
+		compressor.compressedSizes = compressedSizes.get();
+
+		if (UseSectorWorkers(numSectors)) {
+			if (sectorWorkers_ == nullptr)
+				sectorWorkers_ = std::make_unique<SectorWorkers>(GetCpuCount() - 1);
+			sectorWorkers_->Run(compressor);
+		} else {
+			compressor.Run();
+		}
+	}
+
+	// Writing stays sequential, so the archive is the same no matter which thread compressed a sector
 	uint32_t destSize = offsetTableByteSize;
-	byte mpqBuf[BlockSize];
-	size_t curSector = 0;
-	while (true) {
-		uint32_t len = std::min<uint32_t>(fileSize, BlockSize);
-		memcpy(mpqBuf, fileData, len);
-		fileData += len;
-		len = PkwareCompress(mpqBuf, len);
-		if (!stream_.Write(reinterpret_cast<const char *>(&mpqBuf[0]), len))
+	for (uint32_t curSector = 0; curSector < numSectors; curSector++) {
+		const uint32_t len = compressedSizes[curSector];
+		if (!stream_.Write(reinterpret_cast<const char *>(&sectors[static_cast<size_t>(curSector) * BlockSize]), len))
 			return false;
-		offsetTable[curSector++] = SDL_SwapLE32(destSize);
+		offsetTable[curSector] = SDL_SwapLE32(destSize);
 		destSize += len; // compressed length
-		if (fileSize <= BlockSize)
-			break;
-
-		fileSize -= BlockSize;
 	}
 
 	offsetTable[numSectors] = SDL_SwapLE32(destSize);
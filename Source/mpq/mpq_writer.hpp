@@ -6,23 +6,36 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 
 #include "mpq/mpq_common.hpp"
 #include "utils/logged_fstream.hpp"
 #include "utils/stdcompat/cstddef.hpp"
 
 namespace devilution {
+
+enum class MpqCompression : uint8_t {
+	/** PKWARE implode, readable by every version of the game. */
+	PkwareImplode,
+	/** zlib deflate at its fastest level, much quicker to write and read but unknown to the original game. */
+	Zlib,
+};
+
 class MpqWriter {
 public:
-	bool Open(const char *path);
+	MpqWriter();
+	~MpqWriter();
 
-	bool Close(bool clearTables = true);
+	bool Open(const char *path);
 
-	~MpqWriter()
+	/** @brief Sets the compression used for files written from now on, files already in the archive are left as they are. */
+	void SetCompression(MpqCompression compression)
 	{
-		Close();
+		compression_ = compression;
 	}
 
+	bool Close(bool clearTables = true);
+
 	bool HasFile(const char *name) const;
 
 	void RemoveHashEntry(const char *filename);
@@ -31,6 +44,9 @@ public:
 	void RenameFile(const char *name, const char *newName);
 
 private:
+	/** Helper threads compressing the sectors of large files, kept alive between files. */
+	class SectorWorkers;
+
 	bool IsValidMpqHeader(MpqFileHeader *hdr) const;
 	uint32_t GetHashIndex(uint32_t index, uint32_t hashA, uint32_t hashB) const;
 	uint32_t FetchHandle(const char *filename) const;
@@ -56,11 +72,13 @@ private:
 
 	LoggedFStream stream_;
 	std::string name_;
-	std::uintmax_t size_;
-	bool modified_;
-	bool exists_;
-	MpqHashEntry *hashTable_;
-	MpqBlockEntry *blockTable_;
+	std::uintmax_t size_ = 0;
+	bool modified_ = false;
+	bool exists_ = false;
+	MpqHashEntry *hashTable_ = nullptr;
+	MpqBlockEntry *blockTable_ = nullptr;
+	MpqCompression compression_ = MpqCompression::PkwareImplode;
+	std::unique_ptr<SectorWorkers> sectorWorkers_;
 
 // Amiga cannot Seekp beyond EOF.
 // See https://github.com/bebbo/libnix/issues/30
@@ -33,6 +33,7 @@
 #include "towners.h"
 #include "trigs.h"
 #include "utils/language.h"
+#include "utils/lz_codec.hpp"
 #include "utils/utf8.hpp"
 
 namespace devilution {
@@ -61,6 +62,8 @@ int sgnCurrMegaPlayer;
 DLevel sgLevels[NUMLEVELS];
 uint8_t sbLastCmd;
 byte sgRecvBuf[sizeof(DLevel) + 1];
+/** Decompressed delta chunk, so received chunks never have to be copied before decoding them */
+byte sgDeltaScratch[sizeof(DLevel)];
 _cmd_id sgbRecvCmd;
 LocalLevel sgLocals[NUMLEVELS];
 DJunk sgJunk;
@@ -290,29 +293,70 @@ void DeltaImportJunk(const byte *src)
 	}
 }
 
-uint32_t CompressData(byte *buffer, byte *end)
+/**
+ * @brief Writes the tagged encoding of an exported delta chunk to dst.
+ *
+ * Falls back to storing the data when the codec does not make it smaller.
+ *
+ * @param dst Buffer of at least size + 1 bytes
+ * @return Number of bytes written to dst
+ */
+uint32_t CompressData(const byte *src, size_t size, DeltaCompression compression, byte *dst)
 {
-	const auto size = static_cast<uint32_t>(end - buffer - 1);
-	const uint32_t pkSize = PkwareCompress(buffer + 1, size);
+	size_t compressedSize = 0;
+	switch (compression) {
+	case DeltaCompression::Pkware:
+		memcpy(dst + 1, src, size);
+		compressedSize = PkwareCompress(dst + 1, static_cast<uint32_t>(size));
+		break;
+	case DeltaCompression::Lz:
+		compressedSize = LzCompress(src, size, dst + 1, size);
+		break;
+	default:
+		break;
+	}
 
-	*buffer = size != pkSize ? byte { 1 } : byte { 0 };
+	if (compressedSize != 0 && compressedSize < size) {
+		*dst = static_cast<byte>(compression);
+		return static_cast<uint32_t>(compressedSize + 1);
+	}
 
-	return pkSize + 1;
+	*dst = static_cast<byte>(DeltaCompression::None);
+	memcpy(dst + 1, src, size);
+	return static_cast<uint32_t>(size + 1);
+}
+
+/**
+ * @brief Decodes a tagged delta chunk.
+ * @return The uncompressed data, either inside the chunk or in sgDeltaScratch
+ */
+const byte *DecompressData(_cmd_id cmd, const byte *chunk, uint32_t size)
+{
+	if (size == 0)
+		app_fatal("Invalid level delta for network message type: %i", cmd);
+
+	switch (static_cast<DeltaCompression>(chunk[0])) {
+	case DeltaCompression::None:
+		return &chunk[1];
+	case DeltaCompression::Pkware:
+		memcpy(sgDeltaScratch, &chunk[1], size - 1);
+		PkwareDecompress(sgDeltaScratch, size - 1, sizeof(sgDeltaScratch));
+		return sgDeltaScratch;
+	case DeltaCompression::Lz:
+		if (!LzDecompress(&chunk[1], size - 1, sgDeltaScratch, sizeof(sgDeltaScratch)))
+			app_fatal("Invalid level delta for network message type: %i", cmd);
+		return sgDeltaScratch;
+	default:
+		app_fatal("Unknown level delta compression: %i", static_cast<int>(chunk[0]));
+	}
 }
 
 void DeltaImportData(_cmd_id cmd, DWORD recvOffset)
 {
-	if (sgRecvBuf[0] != byte { 0 })
-		PkwareDecompress(&sgRecvBuf[1], recvOffset, sizeof(sgRecvBuf) - 1);
-
-	byte *src = &sgRecvBuf[1];
 	if (cmd == CMD_DLEVEL_JUNK) {
-		DeltaImportJunk(src);
+		DeltaImportJunk(DecompressData(cmd, sgRecvBuf, recvOffset));
 	} else if (cmd >= CMD_DLEVEL_0 && cmd <= CMD_DLEVEL_24) {
-		uint8_t i = cmd - CMD_DLEVEL_0;
-		src += DeltaImportItem(src, sgLevels[i].item);
-		src += DeltaImportObject(src, sgLevels[i].object);
-		DeltaImportMonster(src, sgLevels[i].monster);
+		DeltaImportLevel(cmd - CMD_DLEVEL_0, sgRecvBuf, recvOffset);
 	} else {
 		app_fatal("Unkown network message type: %i", cmd);
 	}
@@ -2032,23 +2076,35 @@ void run_delta_info()
 	FreePackets();
 }
 
+uint32_t DeltaExportLevel(uint8_t level, DeltaCompression compression, byte *dst)
+{
+	byte *exportedEnd = sgDeltaScratch;
+	exportedEnd = DeltaExportItem(exportedEnd, sgLevels[level].item);
+	exportedEnd = DeltaExportObject(exportedEnd, sgLevels[level].object);
+	exportedEnd = DeltaExportMonster(exportedEnd, sgLevels[level].monster);
+	return CompressData(sgDeltaScratch, exportedEnd - sgDeltaScratch, compression, dst);
+}
+
+void DeltaImportLevel(uint8_t level, const byte *chunk, uint32_t size)
+{
+	const byte *src = DecompressData(static_cast<_cmd_id>(level + CMD_DLEVEL_0), chunk, size);
+	src += DeltaImportItem(src, sgLevels[level].item);
+	src += DeltaImportObject(src, sgLevels[level].object);
+	DeltaImportMonster(src, sgLevels[level].monster);
+}
+
 void DeltaExportData(int pnum)
 {
 	if (sgbDeltaChanged) {
 		for (int i = 0; i < NUMLEVELS; i++) {
 			std::unique_ptr<byte[]> dst { new byte[sizeof(DLevel) + 1] };
-			byte *dstEnd = &dst.get()[1];
-			dstEnd = DeltaExportItem(dstEnd, sgLevels[i].item);
-			dstEnd = DeltaExportObject(dstEnd, sgLevels[i].object);
-			dstEnd = DeltaExportMonster(dstEnd, sgLevels[i].monster);
-			uint32_t size = CompressData(dst.get(), dstEnd);
+			uint32_t size = DeltaExportLevel(i, DeltaCompression::Lz, dst.get());
 			dthread_send_delta(pnum, static_cast<_cmd_id>(i + CMD_DLEVEL_0), std::move(dst), size);
 		}
 
+		byte *exportedEnd = DeltaExportJunk(sgDeltaScratch);
 		std::unique_ptr<byte[]> dst { new byte[sizeof(DJunk) + 1] };
-		byte *dstEnd = &dst.get()[1];
-		dstEnd = DeltaExportJunk(dstEnd);
-		uint32_t size = CompressData(dst.get(), dstEnd);
+		uint32_t size = CompressData(sgDeltaScratch, exportedEnd - sgDeltaScratch, DeltaCompression::Lz, dst.get());
 		dthread_send_delta(pnum, CMD_DLEVEL_JUNK, std::move(dst), size);
 	}
 
@@ -779,6 +779,17 @@ struct TBuffer {
 	byte bData[4096];
 };
 
+/**
+ * @brief Encoding of a level delta chunk, stored in its first byte.
+ *
+ * Peers must run the same game version to join, so every tag is understood by the receiver.
+ */
+enum class DeltaCompression : uint8_t {
+	None = 0,
+	Pkware = 1,
+	Lz = 2,
+};
+
 extern bool deltaload;
 extern uint8_t gbBufferMsgs;
 extern int dwRecCount;
@@ -786,6 +797,16 @@ extern int dwRecCount;
 void msg_send_drop_pkt(int pnum, int reason);
 bool msg_wait_resync();
 void run_delta_info();
+/**
+ * @brief Serialises and compresses the delta of a dungeon level the way it is sent to joining players.
+ * @param dst Buffer of at least sizeof(DLevel) + 1 bytes
+ * @return Size of the chunk written to dst
+ */
+uint32_t DeltaExportLevel(uint8_t level, DeltaCompression compression, byte *dst);
+/**
+ * @brief Replaces the delta of a dungeon level with a chunk written by DeltaExportLevel.
+ */
+void DeltaImportLevel(uint8_t level, const byte *chunk, uint32_t size);
 void DeltaExportData(int pnum);
 void DeltaSyncJunk();
 void delta_init();
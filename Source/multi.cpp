@@ -15,6 +15,7 @@
 #include "engine/point.hpp"
 #include "engine/random.hpp"
 #include "menu.h"
+#include "netprofile.h"
 #include "nthread.h"
 #include "options.h"
 #include "pfile.h"
@@ -140,6 +141,7 @@ void SendPacket(int playerId, const byte *packet, size_t size)
 	NetReceivePlayerData(&pkt);
 	pkt.hdr.wLen = static_cast<uint16_t>(size + sizeof(pkt.hdr));
 	memcpy(pkt.body, packet, size);
+	netprofile::RecordSentPacket(playerId, reinterpret_cast<const byte *>(&pkt), pkt.hdr.wLen);
 	if (!SNetSendMessage(playerId, &pkt.hdr, pkt.hdr.wLen))
 		nthread_terminate_game("SNetSendMessage0");
 }
@@ -267,6 +269,8 @@ void HandleAllPackets(int pnum, const byte *data, size_t size)
 		if (messageSize == 0) {
 			break;
 		}
+		if (pnum != MyPlayerId)
+			netprofile::RecordReceivedCommand(&data[offset], messageSize);
 		offset += messageSize;
 	}
 }
@@ -450,6 +454,7 @@ void InitGameInfo()
 void NetSendLoPri(int playerId, const byte *data, size_t size)
 {
 	if (data != nullptr && size != 0) {
+		netprofile::RecordSentCommand(data, size);
 		CopyPacket(&sgLoPriBuf, data, size);
 		SendPacket(playerId, data, size);
 	}
@@ -458,6 +463,7 @@ void NetSendLoPri(int playerId, const byte *data, size_t size)
 void NetSendHiPri(int playerId, const byte *data, size_t size)
 {
 	if (data != nullptr && size != 0) {
+		netprofile::RecordSentCommand(data, size);
 		CopyPacket(&sgHiPriBuf, data, size);
 		SendPacket(playerId, data, size);
 	}
@@ -471,6 +477,7 @@ void NetSendHiPri(int playerId, const byte *data, size_t size)
 		msgSize = sync_all_monsters(lowpriBody, msgSize);
 		size_t len = gdwNormalMsgSize - msgSize;
 		pkt.hdr.wLen = static_cast<uint16_t>(len);
+		netprofile::RecordSentPacket(SNPLAYER_OTHERS, reinterpret_cast<const byte *>(&pkt), len);
 		if (!SNetSendMessage(SNPLAYER_OTHERS, &pkt.hdr, static_cast<unsigned>(len)))
 			nthread_terminate_game("SNetSendMessage");
 	}
@@ -483,6 +490,7 @@ void multi_send_msg_packet(uint32_t pmask, const byte *data, size_t size)
 	size_t len = size + sizeof(pkt.hdr);
 	pkt.hdr.wLen = static_cast<uint16_t>(len);
 	memcpy(pkt.body, data, size);
+	netprofile::RecordSentCommand(data, size);
 	size_t playerID = 0;
 	for (size_t v = 1; playerID < MAX_PLRS; playerID++, v <<= 1) {
 		if ((v & pmask) != 0) {
@@ -490,6 +498,7 @@ void multi_send_msg_packet(uint32_t pmask, const byte *data, size_t size)
 				nthread_terminate_game("SNetSendMessage");
 				return;
 			}
+			netprofile::RecordSentPacket(static_cast<int>(playerID), reinterpret_cast<const byte *>(&pkt), len);
 		}
 	}
 }
@@ -573,6 +582,7 @@ void multi_process_network_packets()
 			continue;
 		if (pkt->wLen != dwMsgSize)
 			continue;
+		netprofile::RecordReceivedPacket(dwID, reinterpret_cast<const byte *>(pkt), dwMsgSize);
 		auto &player = Players[dwID];
 		Point syncPosition = { pkt->px, pkt->py };
 		player.position.last = syncPosition;
@@ -659,8 +669,10 @@ void NetClose()
 	}
 
 	sgbNetInited = false;
+	netprofile::Stop();
 	nthread_cleanup();
 	DThreadCleanup();
+	pfile_wait_for_save();
 	tmsg_cleanup();
 	EventHandler(false);
 	SNetLeaveGame(3);
@@ -698,6 +710,7 @@ bool NetInit(bool bSinglePlayer)
 		BufferInit(&sgLoPriBuf);
 		gbShouldValidatePackage = false;
 		sync_init();
+		netprofile::Start();
 		nthread_start(sgbPlayerTurnBitTbl[MyPlayerId]);
 		dthread_start();
 		tmsg_start();
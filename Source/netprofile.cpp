@@ -0,0 +1,344 @@
+/**
+ * @file netprofile.cpp
+ *
+ * Implementation of the network traffic profiler and packet capture.
+ *
+ * A capture file starts with the magic "DNCP", a version byte and the player number of the
+ * recording player, followed by one record per packet: the time since the start of the game in
+ * milliseconds (LE32), the direction (0 received, 1 sent), the remote player, the packet size
+ * (LE16) and the packet itself. Version 0 files lack the recording player.
+ */
+#include "netprofile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "diablo.h"
+#include "nthread.h"
+#include "player.h"
+#include "storm/storm_net.hpp"
+#include "utils/endian.hpp"
+#include "utils/log.hpp"
+#include "utils/paths.h"
+
+namespace devilution {
+
+namespace {
+
+constexpr char CaptureMagic[4] = { 'D', 'N', 'C', 'P' };
+constexpr uint8_t CaptureVersion = 1;
+constexpr size_t CaptureRecordHeaderSize = 8;
+
+enum class CaptureDirection : uint8_t {
+	Received = 0,
+	Sent = 1,
+};
+
+struct CapturedPacket {
+	uint32_t time;
+	int sender;
+	std::vector<byte> data;
+};
+
+/** Traffic of the current one second window, used to find the peak rate. */
+struct TrafficWindow {
+	uint32_t start;
+	uint32_t sentBytes;
+	uint32_t receivedBytes;
+};
+
+bool Profiling = false;
+int CaptureNumber = -1;
+int ReplayNumber = -1;
+
+netprofile::TrafficStats Stats;
+TrafficWindow Window;
+uint32_t StartTime;
+
+std::ofstream Capture;
+
+std::vector<CapturedPacket> ReplayPackets;
+/** Player number of whoever recorded the capture, or -1 if the capture does not say. */
+int ReplayRecorder;
+size_t NextReplayPacket;
+uint32_t ReplayStartTime;
+bool ReplayStarted;
+
+std::string CapturePath(int number)
+{
+	char filename[32];
+	snprintf(filename, sizeof(filename), "netcapture_%d.ncp", number);
+	return paths::PrefPath() + filename;
+}
+
+void WriteLE16(byte *out, uint16_t value)
+{
+	out[0] = static_cast<byte>(value);
+	out[1] = static_cast<byte>(value >> 8);
+}
+
+void WriteLE32(byte *out, uint32_t value)
+{
+	WriteLE16(out, static_cast<uint16_t>(value));
+	WriteLE16(out + 2, static_cast<uint16_t>(value >> 16));
+}
+
+void CapturePacket(CaptureDirection direction, int player, const byte *data, size_t size)
+{
+	if (!Capture.is_open())
+		return;
+
+	byte header[CaptureRecordHeaderSize];
+	WriteLE32(header, SDL_GetTicks() - StartTime);
+	header[4] = static_cast<byte>(direction);
+	header[5] = static_cast<byte>(player);
+	WriteLE16(&header[6], static_cast<uint16_t>(size));
+	Capture.write(reinterpret_cast<const char *>(header), sizeof(header));
+	Capture.write(reinterpret_cast<const char *>(data), size);
+}
+
+void UpdateWindow(uint32_t sentBytes, uint32_t receivedBytes)
+{
+	const uint32_t now = SDL_GetTicks();
+	if (now - Window.start >= 1000) {
+		Window = {};
+		Window.start = now;
+	}
+	Window.sentBytes += sentBytes;
+	Window.receivedBytes += receivedBytes;
+	Stats.peakSentBytesPerSecond = std::max(Stats.peakSentBytesPerSecond, Window.sentBytes);
+	Stats.peakReceivedBytesPerSecond = std::max(Stats.peakReceivedBytesPerSecond, Window.receivedBytes);
+}
+
+void AddTraffic(netprofile::CommandTraffic &traffic, size_t size)
+{
+	traffic.count++;
+	traffic.bytes += static_cast<uint32_t>(size);
+}
+
+bool LoadCapture(int number)
+{
+	std::ifstream file(CapturePath(number), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	char magic[sizeof(CaptureMagic) + 1];
+	if (!file.read(magic, sizeof(magic)) || memcmp(magic, CaptureMagic, sizeof(CaptureMagic)) != 0 || magic[4] > CaptureVersion)
+		return false;
+
+	ReplayRecorder = -1;
+	if (magic[4] >= 1) {
+		char recorder;
+		if (!file.read(&recorder, 1))
+			return false;
+		ReplayRecorder = static_cast<uint8_t>(recorder);
+		if (ReplayRecorder >= MAX_PLRS)
+			return false;
+	}
+
+	byte header[CaptureRecordHeaderSize];
+	while (file.read(reinterpret_cast<char *>(header), sizeof(header))) {
+		CapturedPacket packet;
+		packet.time = LoadLE32(header);
+		packet.sender = static_cast<uint8_t>(header[5]);
+		packet.data.resize(LoadLE16(&header[6]));
+		if (!file.read(reinterpret_cast<char *>(packet.data.data()), packet.data.size()))
+			return false;
+		if (static_cast<CaptureDirection>(header[4]) != CaptureDirection::Received || packet.sender >= MAX_PLRS)
+			continue;
+		ReplayPackets.push_back(std::move(packet));
+	}
+
+	return true;
+}
+
+void LogCommandTraffic(const char *direction, const std::array<netprofile::CommandTraffic, 256> &commands)
+{
+	for (size_t cmd = 0; cmd < commands.size(); cmd++) {
+		const netprofile::CommandTraffic &traffic = commands[cmd];
+		if (traffic.count != 0)
+			Log("Net profile: {} cmd {}: {} messages, {} bytes", direction, cmd, traffic.count, traffic.bytes);
+	}
+}
+
+} // namespace
+
+namespace netprofile {
+
+void EnableProfiling()
+{
+	Profiling = true;
+}
+
+void InitCapture(int captureNumber)
+{
+	Profiling = true;
+	CaptureNumber = captureNumber;
+}
+
+void InitReplay(int replayNumber)
+{
+	ReplayNumber = replayNumber;
+	ReplayPackets.clear();
+	NextReplayPacket = 0;
+	ReplayStarted = false;
+	if (!LoadCapture(replayNumber)) {
+		SDL_Log("Unable to load network capture file");
+		diablo_quit(1);
+	}
+}
+
+bool IsProfiling()
+{
+	return Profiling;
+}
+
+bool IsReplaying()
+{
+	return ReplayNumber != -1;
+}
+
+void Start()
+{
+	if (!Profiling)
+		return;
+
+	Stats = {};
+	StartTime = SDL_GetTicks();
+	Window = {};
+	Window.start = StartTime;
+
+	if (CaptureNumber != -1) {
+		Capture.open(CapturePath(CaptureNumber), std::ios::binary | std::ios::trunc);
+		if (!Capture.is_open()) {
+			LogError("Unable to create network capture file");
+			return;
+		}
+		Capture.write(CaptureMagic, sizeof(CaptureMagic));
+		Capture.put(static_cast<char>(CaptureVersion));
+		Capture.put(static_cast<char>(MyPlayerId));
+	}
+}
+
+void Stop()
+{
+	if (!Profiling)
+		return;
+
+	if (Capture.is_open())
+		Capture.close();
+
+	LogCommandTraffic("sent", Stats.sentCommands);
+	LogCommandTraffic("received", Stats.receivedCommands);
+	for (int i = 0; i < MAX_PLRS; i++) {
+		if (Stats.sentPackets[i].count == 0 && Stats.receivedPackets[i].count == 0)
+			continue;
+		Log("Net profile: player {}: sent {} packets ({} bytes), received {} packets ({} bytes)", i,
+		    Stats.sentPackets[i].count, Stats.sentPackets[i].bytes, Stats.receivedPackets[i].count, Stats.receivedPackets[i].bytes);
+	}
+	Log("Net profile: peak {} bytes/s sent, {} bytes/s received", Stats.peakSentBytesPerSecond, Stats.peakReceivedBytesPerSecond);
+	for (size_t i = 0; i < FillBuckets; i++)
+		Log("Net profile: packets {}-{}% full: {}", i * 100 / FillBuckets, (i + 1) * 100 / FillBuckets, Stats.packetFill[i]);
+}
+
+void RecordSentCommand(const byte *data, size_t size)
+{
+	if (!Profiling || size == 0)
+		return;
+
+	AddTraffic(Stats.sentCommands[static_cast<uint8_t>(data[0])], size);
+}
+
+void RecordReceivedCommand(const byte *data, size_t size)
+{
+	if (!Profiling || size == 0)
+		return;
+
+	AddTraffic(Stats.receivedCommands[static_cast<uint8_t>(data[0])], size);
+}
+
+void RecordSentPacket(int playerId, const byte *data, size_t size)
+{
+	if (!Profiling)
+		return;
+
+	const bool broadcast = playerId == SNPLAYER_ALL || playerId == SNPLAYER_OTHERS;
+	uint32_t totalBytes = 0;
+	for (int i = 0; i < MAX_PLRS; i++) {
+		if (i == MyPlayerId)
+			continue;
+		if ((broadcast && Players[i].plractive) || playerId == i) {
+			AddTraffic(Stats.sentPackets[i], size);
+			totalBytes += static_cast<uint32_t>(size);
+		}
+	}
+	if (totalBytes == 0)
+		return;
+
+	UpdateWindow(totalBytes, 0);
+	if (gdwNormalMsgSize != 0) {
+		const size_t bucket = size * FillBuckets / gdwNormalMsgSize;
+		Stats.packetFill[std::min(bucket, FillBuckets - 1)]++;
+	}
+	CapturePacket(CaptureDirection::Sent, broadcast ? 0xFF : playerId, data, size);
+}
+
+void RecordReceivedPacket(int pnum, const byte *data, size_t size)
+{
+	if (!Profiling || pnum == MyPlayerId)
+		return;
+
+	AddTraffic(Stats.receivedPackets[pnum], size);
+	UpdateWindow(0, static_cast<uint32_t>(size));
+	CapturePacket(CaptureDirection::Received, pnum, data, size);
+}
+
+bool FetchReplayPacket(int *sender, void **data, uint32_t *size)
+{
+	if (NextReplayPacket >= ReplayPackets.size())
+		return false;
+
+	if (!ReplayStarted) {
+		ReplayStarted = true;
+		ReplayStartTime = SDL_GetTicks();
+	}
+
+	while (NextReplayPacket < ReplayPackets.size()) {
+		CapturedPacket &packet = ReplayPackets[NextReplayPacket];
+		if (SDL_GetTicks() - ReplayStartTime < packet.time)
+			return false;
+		NextReplayPacket++;
+
+		// A live provider never hands us another player's packet under our own player number. The
+		// recording player's number is free during the replay, so whoever sat in ours moves there.
+		int packetSender = packet.sender;
+		if (packetSender == ReplayRecorder)
+			continue;
+		if (packetSender == MyPlayerId) {
+			if (ReplayRecorder == -1)
+				continue;
+			packetSender = ReplayRecorder;
+		}
+
+		*sender = packetSender;
+		*data = packet.data.data();
+		*size = static_cast<uint32_t>(packet.data.size());
+		return true;
+	}
+
+	return false;
+}
+
+const TrafficStats &GetStats()
+{
+	return Stats;
+}
+
+} // namespace netprofile
+
+} // namespace devilution
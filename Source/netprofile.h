@@ -0,0 +1,74 @@
+/**
+ * @file netprofile.h
+ *
+ * Interface of the network traffic profiler and packet capture.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "multi.h"
+
+namespace devilution {
+
+namespace netprofile {
+
+/** Number of buckets of the packet fill level histogram, each covering 10%. */
+constexpr size_t FillBuckets = 10;
+
+struct CommandTraffic {
+	uint32_t count;
+	uint32_t bytes;
+};
+
+struct TrafficStats {
+	/** Game commands by _cmd_id. */
+	std::array<CommandTraffic, 256> sentCommands;
+	std::array<CommandTraffic, 256> receivedCommands;
+	/** Packets by remote player, broadcasts count towards every active player. */
+	std::array<CommandTraffic, MAX_PLRS> sentPackets;
+	std::array<CommandTraffic, MAX_PLRS> receivedPackets;
+	/** Sent packets by how full they were compared to the normal message size. */
+	std::array<uint32_t, FillBuckets> packetFill;
+	uint32_t peakSentBytesPerSecond;
+	uint32_t peakReceivedBytesPerSecond;
+};
+
+void EnableProfiling();
+void InitCapture(int captureNumber);
+void InitReplay(int replayNumber);
+
+bool IsProfiling();
+bool IsReplaying();
+
+/** @brief Resets the counters and opens the capture file, called when joining a game. */
+void Start();
+/** @brief Logs a summary of the game's traffic and closes the capture file. */
+void Stop();
+
+/** @brief Records a game command queued for sending to other players. */
+void RecordSentCommand(const byte *data, size_t size);
+/** @brief Records a game command received from a player. */
+void RecordReceivedCommand(const byte *data, size_t size);
+/** @brief Records a packet handed to the network provider. */
+void RecordSentPacket(int playerId, const byte *data, size_t size);
+/** @brief Records a packet received from the network provider. */
+void RecordReceivedPacket(int pnum, const byte *data, size_t size);
+
+/**
+ * @brief Fetches the next captured packet that is due for replay.
+ *
+ * Packets from the player that had our player number in the captured game are handed out
+ * under the recording player's number instead.
+ *
+ * @return false if no packet is due yet, or the capture is exhausted.
+ */
+bool FetchReplayPacket(int *sender, void **data, uint32_t *size);
+
+const TrafficStats &GetStats();
+
+} // namespace netprofile
+
+} // namespace devilution
@@ -25,6 +25,11 @@ float gfProgressToNextGameTick = 0.0;
 
 namespace {
 
+/** Number of network updates between receiving turns. */
+constexpr char SyncInterval = 4;
+/** Length of the window the stall frequency is measured over, in milliseconds. */
+constexpr uint32_t StallWindow = 10000;
+
 SdlMutex MemCrit;
 DWORD gdwDeltaBytesSec;
 bool nthread_should_run;
@@ -34,6 +39,57 @@ bool sgbTicsOutOfSync;
 char sgbPacketCountdown;
 bool sgbThreadIsRunning;
 SdlThread Thread;
+bool sgbStalled;
+uint32_t sgdwStallWindowStart;
+uint32_t sgdwStallsInWindow;
+NetTurnStats TurnStats;
+
+/**
+ * @brief Time between two received turns in milliseconds.
+ */
+uint32_t TurnInterval()
+{
+	return gnTickDelay * sgbNetUpdateRate * SyncInterval;
+}
+
+void UpdateStallRate()
+{
+	uint32_t now = SDL_GetTicks();
+	uint32_t elapsed = now - sgdwStallWindowStart;
+	if (elapsed < StallWindow)
+		return;
+	TurnStats.stallsPerMinute = sgdwStallsInWindow * 60000 / elapsed;
+	sgdwStallWindowStart = now;
+	sgdwStallsInWindow = 0;
+}
+
+void RecordStall()
+{
+	if (sgbStalled)
+		return;
+	sgbStalled = true;
+	sgdwStallsInWindow++;
+	UpdateStallRate();
+}
+
+/**
+ * @brief Updates the latency statistics shown with the FPS counter.
+ *
+ * The number of turns in transit stays at the provider default: every queued turn carries the same
+ * sequence number, and all players would have to agree on a different count.
+ */
+void UpdateTurnStats()
+{
+	sgbStalled = false;
+	UpdateStallRate();
+
+	uint32_t latency;
+	uint32_t jitter;
+	if (SNetGetLatency(&latency, &jitter)) {
+		TurnStats.latency = latency;
+		TurnStats.jitter = jitter;
+	}
+}
 
 void NthreadHandler()
 {
@@ -119,6 +175,7 @@ bool nthread_recv_turns(bool *pfSendAsync)
 	if (!SNetReceiveTurns(MAX_PLRS, (char **)glpMsgTbl, gdwMsgLenTbl, &player_state[0])) {
 		if (SErrGetLastError() != STORM_ERROR_NO_MESSAGES_WAITING)
 			nthread_terminate_game("SNetReceiveTurns");
+		RecordStall();
 		sgbTicsOutOfSync = false;
 		sgbSyncCountdown = 1;
 		sgbPacketCountdown = 1;
@@ -128,7 +185,8 @@ bool nthread_recv_turns(bool *pfSendAsync)
 		sgbTicsOutOfSync = true;
 		last_tick = SDL_GetTicks();
 	}
-	sgbSyncCountdown = 4;
+	sgbSyncCountdown = SyncInterval;
+	UpdateTurnStats();
 	multi_msg_countdown();
 	if (pfSendAsync != nullptr)
 		*pfSendAsync = true;
@@ -178,6 +236,12 @@ void nthread_start(bool setTurnUpperBit)
 	}
 	if (gdwNormalMsgSize > largestMsgSize)
 		gdwNormalMsgSize = largestMsgSize;
+	sgbStalled = false;
+	sgdwStallWindowStart = SDL_GetTicks();
+	sgdwStallsInWindow = 0;
+	TurnStats = {};
+	TurnStats.turnsInTransit = gdwTurnsInTransit;
+	TurnStats.inputLatency = gdwTurnsInTransit * TurnInterval();
 	if (gbIsMultiplayer) {
 		sgbThreadIsRunning = false;
 		MemCrit.lock();
@@ -211,6 +275,11 @@ void nthread_ignore_mutex(bool bStart)
 	sgbThreadIsRunning = bStart;
 }
 
+NetTurnStats nthread_get_turn_stats()
+{
+	return TurnStats;
+}
+
 bool nthread_has_500ms_passed()
 {
 	int currentTickCount = SDL_GetTicks();
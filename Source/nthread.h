@@ -10,12 +10,24 @@
 
 namespace devilution {
 
+struct NetTurnStats {
+	/** Smoothed round trip latency to the slowest player, in milliseconds. */
+	uint32_t latency;
+	/** Mean deviation of the round trip latency, in milliseconds. */
+	uint32_t jitter;
+	uint32_t turnsInTransit;
+	/** Time from sending a turn until it is executed, in milliseconds. */
+	uint32_t inputLatency;
+	/** Turns that did not arrive in time, per minute. */
+	uint32_t stallsPerMinute;
+};
+
 extern BYTE sgbNetUpdateRate;
 extern size_t gdwMsgLenTbl[MAX_PLRS];
 extern uint32_t gdwTurnsInTransit;
 extern uintptr_t glpMsgTbl[MAX_PLRS];
 extern uint32_t gdwLargestMsgSize;
-extern uint32_t gdwNormalMsgSize;
+extern DVL_API_FOR_TEST uint32_t gdwNormalMsgSize;
 extern DVL_API_FOR_TEST float gfProgressToNextGameTick; // the progress as a fraction (0.0f to 1.0f) in time to the next game tick
 extern int last_tick;
 
@@ -26,6 +38,7 @@ void nthread_set_turn_upper_bit();
 void nthread_start(bool setTurnUpperBit);
 void nthread_cleanup();
 void nthread_ignore_mutex(bool bStart);
+NetTurnStats nthread_get_turn_stats();
 
 /**
  * @brief Checks if it's time for the logic to advance
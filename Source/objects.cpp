@@ -3675,6 +3675,7 @@ void OperateShrine(int pnum, int i, _sfx_id sType)
 		break;
 	}
 
+	Players[pnum].MarkStatsDirty(PlayerStatsDirty::All);
 	CalcPlrInv(Players[pnum], true);
 	force_redraw = 255;
 
@@ -58,6 +58,9 @@ namespace devilution {
 #ifndef DEFAULT_AUDIO_RESAMPLING_QUALITY
 #define DEFAULT_AUDIO_RESAMPLING_QUALITY 3
 #endif
+#ifndef DEFAULT_SFX_MEMORY_BUDGET
+#define DEFAULT_SFX_MEMORY_BUDGET 0
+#endif
 
 namespace {
 
@@ -629,6 +632,7 @@ AudioOptions::AudioOptions()
               OptionEntryFlags::None,
 #endif
           N_("Resampling Quality"), N_("Quality of the resampler, from 0 (lowest) to 10 (highest)."), DEFAULT_AUDIO_RESAMPLING_QUALITY, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 })
+    , sfxMemoryBudget("SFX Memory Budget", OptionEntryFlags::Invisible, "SFX Memory Budget", "Memory for sound effects kept in memory (MiB), 0 means no limit.", DEFAULT_SFX_MEMORY_BUDGET)
 {
 	sampleRate.SetValueChangedCallback(OptionAudioChanged);
 	channels.SetValueChangedCallback(OptionAudioChanged);
@@ -647,6 +651,7 @@ std::vector<OptionEntryBase *> AudioOptions::GetEntries()
 		&channels,
 		&bufferSize,
 		&resamplingQuality,
+		&sfxMemoryBudget,
 	};
 }
 
@@ -849,6 +854,7 @@ GameplayOptions::GameplayOptions()
     , autoRefillBelt("Auto Refill Belt", OptionEntryFlags::None, N_("Auto Refill Belt"), N_("Refill belt from inventory when belt item is consumed."), false)
     , disableCripplingShrines("Disable Crippling Shrines", OptionEntryFlags::None, N_("Disable Crippling Shrines"), N_("When enabled Cauldrons, Fascinating Shrines, Goat Shrines, Ornate Shrines and Sacred Shrines are not able to be clicked on and labeled as disabled."), false)
     , quickCast("Quick Cast", OptionEntryFlags::None, N_("Quick Cast"), N_("Spell hotkeys instantly cast the spell, rather than switching the readied spell."), false)
+    , fastSaveCompression("Fast Save Compression", OptionEntryFlags::None, N_("Fast Save Compression"), N_("Saves are written and loaded faster. Such saves can't be loaded by the original game or older versions of DevilutionX."), false)
     , numHealPotionPickup("Heal Potion Pickup", OptionEntryFlags::None, N_("Heal Potion Pickup"), N_("Number of Healing potions to pick up automatically."), 0, { 0, 1, 2, 4, 8, 16 })
     , numFullHealPotionPickup("Full Heal Potion Pickup", OptionEntryFlags::None, N_("Full Heal Potion Pickup"), N_("Number of Full Healing potions to pick up automatically."), 0, { 0, 1, 2, 4, 8, 16 })
     , numManaPotionPickup("Mana Potion Pickup", OptionEntryFlags::None, N_("Mana Potion Pickup"), N_("Number of Mana potions to pick up automatically."), 0, { 0, 1, 2, 4, 8, 16 })
@@ -879,6 +885,7 @@ std::vector<OptionEntryBase *> GameplayOptions::GetEntries()
 		&showItemLabels,
 		&disableCripplingShrines,
 		&quickCast,
+		&fastSaveCompression,
 		&autoRefillBelt,
 		&autoPickupInTown,
 		&autoGoldPickup,
@@ -374,6 +374,8 @@ struct AudioOptions : OptionCategoryBase {
 	OptionEntryInt<std::uint32_t> bufferSize;
 	/** @brief Quality of the resampler, from 0 (lowest) to 10 (highest) */
 	OptionEntryInt<std::uint8_t> resamplingQuality;
+	/** @brief Memory for sound effects kept in memory (MiB), 0 means no limit */
+	OptionEntryInt<std::uint32_t> sfxMemoryBudget;
 };
 
 struct GraphicsOptions : OptionCategoryBase {
@@ -475,6 +477,8 @@ struct GameplayOptions : OptionCategoryBase {
 	OptionEntryBoolean disableCripplingShrines;
 	/** @brief Spell hotkeys instantly cast the spell. */
 	OptionEntryBoolean quickCast;
+	/** @brief Compress new saves with zlib instead of PKWARE implode. */
+	OptionEntryBoolean fastSaveCompression;
 	/** @brief Number of Healing potions to pick up automatically */
 	OptionEntryInt<int> numHealPotionPickup;
 	/** @brief Number of Full Healing potions to pick up automatically */
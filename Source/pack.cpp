@@ -282,6 +282,7 @@ bool UnPackPlayer(const PlayerPack *pPack, Player &player, bool netSync)
 		UnPackItem(packedItem, player.SpdList[i], isHellfire);
 	}
 
+	player.MarkStatsDirty(PlayerStatsDirty::All);
 	CalcPlrInv(player, false);
 	player.wReflections = SDL_SwapLE16(pPack->wReflections);
 	player.wEtherealize = SDL_SwapLE16(pPack->wEtherealize);
@@ -5,6 +5,12 @@
  */
 #include "pfile.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <set>
 #include <string>
 
 #include "codec.h"
@@ -13,12 +19,16 @@
 #include "loadsave.h"
 #include "menu.h"
 #include "mpq/mpq_reader.hpp"
+#include "options.h"
 #include "pack.h"
 #include "qol/stash.h"
 #include "utils/endian.hpp"
 #include "utils/file_util.h"
 #include "utils/language.h"
+#include "utils/log.hpp"
+#include "utils/lz_codec.hpp"
 #include "utils/paths.h"
+#include "utils/sdl_thread.h"
 #include "utils/utf8.hpp"
 
 namespace devilution {
@@ -35,6 +45,67 @@ namespace {
 MpqWriter SaveWriter;
 MpqWriter StashWriter;
 
+/** A save that is written to an archive on the save thread. */
+struct SaveJob {
+	MpqWriter *archive;
+	std::string path;
+	SaveSnapshot snapshot;
+	const char *password;
+	/** Refreshes the hero index entry of this save number once the archive is written. */
+	std::optional<_uiheroinfo> heroInfo;
+	uint32_t saveNum;
+	/** Stash pages in the snapshot, they are marked dirty again if the archive can't be written. */
+	std::set<unsigned> stashPages = {};
+	bool written = false;
+};
+
+/** Owned by the save thread while it is running, the results are handled on the main thread. */
+std::vector<SaveJob> SaveJobs;
+SdlThread SaveThread;
+std::atomic<bool> SaveInFlight;
+std::atomic<uint32_t> LastWriteTime;
+uint32_t LastSnapshotTime;
+
+/** A level the player left, kept compressed until it is visited again or the game is saved. */
+struct CachedLevel {
+	std::string name;
+	std::unique_ptr<byte[]> data;
+	size_t compressedSize;
+	size_t size;
+	/** The save archive doesn't have this version of the level yet. */
+	bool dirty;
+};
+
+constexpr size_t MaxCachedLevels = 8;
+constexpr size_t MaxLevelCacheSize = 2 * 1024 * 1024;
+
+/** Least recently visited first. */
+std::vector<CachedLevel> LevelCache;
+std::vector<byte> LevelCompressBuffer;
+
+/** What the character selection screen shows for a hero, valid as long as the save archive is unchanged. */
+struct HeroIndexEntry {
+	_uiheroinfo info;
+	std::uintmax_t archiveSize;
+	std::int64_t archiveTime;
+	bool valid;
+};
+
+constexpr char HeroIndexMagic[4] = { 'D', 'H', 'I', 'X' };
+constexpr uint8_t HeroIndexVersion = 2;
+/** Save number, name, class, level, rank, has saved game, 4 stats, archive size and time. */
+constexpr size_t HeroIndexRecordSize = 1 + sizeof(_uiheroinfo::name) + 4 + 4 * 2 + 8 + 8;
+
+/** Only used on the main thread, the save thread leaves refreshing it to FinishSaveJobs. */
+std::array<HeroIndexEntry, MAX_CHARACTERS> HeroIndex;
+/** Single and multiplayer heroes have separate indexes. */
+std::string LoadedHeroIndexPath;
+
+uint32_t MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
 /** List of character names for the character selection screen. */
 char hero_names[MAX_CHARACTERS][PLR_NAME_LEN];
 
@@ -66,6 +137,18 @@ std::string GetSavePath(uint32_t saveNum)
 	return path;
 }
 
+std::string GetHeroIndexPath()
+{
+	std::string path = paths::PrefPath();
+	if (gbIsSpawn) {
+		path.append(gbIsMultiplayer ? "share_" : "spawn_");
+	} else {
+		path.append(gbIsMultiplayer ? "multi_" : "single_");
+	}
+	path.append(gbIsHellfire ? "heroes.hidx" : "heroes.idx");
+	return path;
+}
+
 std::string GetStashSavePath()
 {
 	std::string path = paths::PrefPath();
@@ -114,6 +197,116 @@ bool GetTempSaveNames(uint8_t dwIndex, char *szTemp)
 	return true;
 }
 
+void AppendLE(std::vector<uint8_t> &out, uint64_t value, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+uint64_t ReadLE(const uint8_t *&in, size_t size)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < size; i++)
+		value |= static_cast<uint64_t>(*in++) << (8 * i);
+	return value;
+}
+
+/** @brief Reads the hero index of the current game variant once, a missing or outdated index is simply empty. */
+void LoadHeroIndex()
+{
+	std::string path = GetHeroIndexPath();
+	if (path == LoadedHeroIndexPath)
+		return;
+	LoadedHeroIndexPath = path;
+	HeroIndex = {};
+
+	std::uintmax_t fileSize;
+	if (!GetFileSize(path.c_str(), &fileSize) || fileSize < sizeof(HeroIndexMagic) + 1)
+		return;
+	FILE *file = FOpen(path.c_str(), "rb");
+	if (file == nullptr)
+		return;
+	std::vector<uint8_t> data(fileSize);
+	const bool read = std::fread(data.data(), data.size(), 1, file) == 1;
+	std::fclose(file);
+	if (!read || memcmp(data.data(), HeroIndexMagic, sizeof(HeroIndexMagic)) != 0 || data[sizeof(HeroIndexMagic)] != HeroIndexVersion)
+		return;
+
+	const uint8_t *in = &data[sizeof(HeroIndexMagic) + 1];
+	const uint8_t *const end = data.data() + data.size();
+	while (end - in >= static_cast<std::ptrdiff_t>(HeroIndexRecordSize)) {
+		const uint8_t saveNum = *in++;
+		if (saveNum >= MAX_CHARACTERS) {
+			in += HeroIndexRecordSize - 1;
+			continue;
+		}
+		HeroIndexEntry &entry = HeroIndex[saveNum];
+		entry.info = {};
+		entry.info.saveNumber = saveNum;
+		memcpy(entry.info.name, in, sizeof(entry.info.name));
+		entry.info.name[sizeof(entry.info.name) - 1] = '\0';
+		in += sizeof(entry.info.name);
+		entry.info.heroclass = static_cast<HeroClass>(*in++);
+		entry.info.level = *in++;
+		entry.info.herorank = *in++;
+		entry.info.hassaved = *in++ != 0;
+		entry.info.strength = static_cast<uint16_t>(ReadLE(in, 2));
+		entry.info.magic = static_cast<uint16_t>(ReadLE(in, 2));
+		entry.info.dexterity = static_cast<uint16_t>(ReadLE(in, 2));
+		entry.info.vitality = static_cast<uint16_t>(ReadLE(in, 2));
+		entry.archiveSize = static_cast<std::uintmax_t>(ReadLE(in, 8));
+		entry.archiveTime = static_cast<std::int64_t>(ReadLE(in, 8));
+		entry.valid = true;
+	}
+}
+
+void SaveHeroIndex()
+{
+	std::vector<uint8_t> data(HeroIndexMagic, HeroIndexMagic + sizeof(HeroIndexMagic));
+	data.push_back(HeroIndexVersion);
+	for (const HeroIndexEntry &entry : HeroIndex) {
+		if (!entry.valid)
+			continue;
+		data.push_back(static_cast<uint8_t>(entry.info.saveNumber));
+		data.insert(data.end(), entry.info.name, entry.info.name + sizeof(entry.info.name));
+		data.push_back(static_cast<uint8_t>(entry.info.heroclass));
+		data.push_back(entry.info.level);
+		data.push_back(entry.info.herorank);
+		data.push_back(entry.info.hassaved ? 1 : 0);
+		AppendLE(data, entry.info.strength, 2);
+		AppendLE(data, entry.info.magic, 2);
+		AppendLE(data, entry.info.dexterity, 2);
+		AppendLE(data, entry.info.vitality, 2);
+		AppendLE(data, entry.archiveSize, 8);
+		AppendLE(data, static_cast<uint64_t>(entry.archiveTime), 8);
+	}
+
+	// Written to a copy first, so that a crash can't leave a half written index that still looks valid
+	const std::string path = GetHeroIndexPath();
+	const std::string tempPath = path + ".tmp";
+	FILE *file = FOpen(tempPath.c_str(), "wb");
+	if (file == nullptr)
+		return;
+	bool result = std::fwrite(data.data(), data.size(), 1, file) == 1;
+	result = std::fclose(file) == 0 && result;
+	if (!result || !RenameFile(tempPath.c_str(), path.c_str())) {
+		LogError("Failed to write {}", path);
+		RemoveFile(tempPath);
+	}
+}
+
+/** @brief Remembers what the character selection screen shows for the save archive as it is now. */
+void UpdateHeroIndex(uint32_t saveNum, const _uiheroinfo &info)
+{
+	LoadHeroIndex();
+	HeroIndexEntry &entry = HeroIndex[saveNum];
+	const std::string path = GetSavePath(saveNum);
+	entry.info = info;
+	entry.info.saveNumber = saveNum;
+	entry.valid = GetFileSize(path.c_str(), &entry.archiveSize) && GetFileModificationTime(path.c_str(), &entry.archiveTime);
+	SaveHeroIndex();
+}
+
 void RenameTempToPerm()
 {
 	char szTemp[MAX_PATH];
@@ -150,21 +343,100 @@ bool ReadHero(MpqArchive &archive, PlayerPack *pPack)
 	return ret;
 }
 
-void EncodeHero(const PlayerPack *pack)
+void AddHero(SaveSnapshot &snapshot, const PlayerPack *pack)
 {
-	size_t packedLen = codec_get_encoded_len(sizeof(*pack));
-	std::unique_ptr<byte[]> packed { new byte[packedLen] };
-
+	std::unique_ptr<byte[]> packed { new byte[codec_get_encoded_len(sizeof(*pack))] };
 	memcpy(packed.get(), pack, sizeof(*pack));
-	codec_encode(packed.get(), sizeof(*pack), packedLen, pfile_get_password());
-	SaveWriter.WriteFile("hero", packed.get(), packedLen);
+	snapshot.AddFile("hero", std::move(packed), sizeof(*pack));
+}
+
+SaveSnapshot SnapshotHero(Player &player)
+{
+	SaveSnapshot snapshot;
+	PlayerPack pkplr;
+	PackPlayer(&pkplr, player, !gbIsMultiplayer, false);
+	AddHero(snapshot, &pkplr);
+	if (!gbVanilla) {
+		SaveHotkeys(snapshot);
+		SaveHeroItems(snapshot, player);
+	}
+	return snapshot;
+}
+
+/** @brief Applies the compression option to the archives, must not be called while the save thread is running. */
+void UpdateSaveCompression()
+{
+	const MpqCompression compression = *sgOptions.Gameplay.fastSaveCompression ? MpqCompression::Zlib : MpqCompression::PkwareImplode;
+	SaveWriter.SetCompression(compression);
+	StashWriter.SetCompression(compression);
 }
 
 bool OpenArchive(uint32_t saveNum)
 {
+	pfile_wait_for_save();
+	UpdateSaveCompression();
 	return SaveWriter.Open(GetSavePath(saveNum).c_str());
 }
 
+/**
+ * @brief Writes a save to a copy of the archive that then replaces the original,
+ * so that a crash halfway through can't leave a broken save behind.
+ */
+bool WriteSaveJob(SaveJob &job)
+{
+	const std::string tempPath = job.path + ".tmp";
+	if (FileExists(job.path.c_str())) {
+		if (!CopyFileOverwrite(job.path.c_str(), tempPath.c_str()))
+			return false;
+	} else if (FileExists(tempPath.c_str())) {
+		RemoveFile(tempPath);
+	}
+
+	if (!job.archive->Open(tempPath.c_str()))
+		return false;
+	bool result = job.snapshot.WriteTo(*job.archive, job.password);
+	// The cached tables describe the temporary file, which might not replace the original
+	result = job.archive->Close(/*clearTables=*/true) && result;
+	// Otherwise a power loss right after the rename can leave an empty or partial archive behind
+	if (result)
+		result = SyncFile(tempPath.c_str());
+	if (result)
+		result = RenameFile(tempPath.c_str(), job.path.c_str());
+	if (result)
+		SyncFileDirectory(job.path.c_str());
+	else
+		RemoveFile(tempPath);
+	return result;
+}
+
+void SaveThreadHandler()
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (SaveJob &job : SaveJobs)
+		job.written = WriteSaveJob(job);
+	LastWriteTime = MicrosecondsSince(start);
+	SaveInFlight = false;
+}
+
+/** @brief Handles the results of the save thread once it is done, on the main thread. */
+void FinishSaveJobs()
+{
+	for (const SaveJob &job : SaveJobs) {
+		if (job.written) {
+			if (job.heroInfo)
+				UpdateHeroIndex(job.saveNum, *job.heroInfo);
+			continue;
+		}
+		LogError("Failed to write {}", job.path);
+		// The hero is part of every save, but the stash is only written again once it is marked dirty
+		if (job.archive == &StashWriter) {
+			Stash.dirty = true;
+			Stash.dirtyPages.insert(job.stashPages.begin(), job.stashPages.end());
+		}
+	}
+	SaveJobs.clear();
+}
+
 void Game2UiPlayer(const Player &player, _uiheroinfo *heroinfo, bool bHasSaveFile)
 {
 	CopyUtf8(heroinfo->name, player._pName, sizeof(heroinfo->name));
@@ -204,6 +476,59 @@ bool GetFileName(uint8_t lvl, char *dst)
 	return true;
 }
 
+std::vector<CachedLevel>::iterator FindCachedLevel(const char *name)
+{
+	return std::find_if(LevelCache.begin(), LevelCache.end(), [name](const CachedLevel &level) { return level.name == name; });
+}
+
+std::unique_ptr<byte[]> DecompressCachedLevel(const CachedLevel &level)
+{
+	std::unique_ptr<byte[]> data { new byte[codec_get_encoded_len(level.size)] };
+	if (LzDecompress(level.data.get(), level.compressedSize, data.get(), level.size) != level.size)
+		app_fatal("Corrupt level cache entry %s", level.name.c_str());
+	return data;
+}
+
+/** @brief Writes every cached level that isn't in the save archive to it. The archive has to be open. */
+void WriteDirtyCachedLevels()
+{
+	SaveSnapshot snapshot;
+	for (CachedLevel &level : LevelCache) {
+		if (!level.dirty)
+			continue;
+		snapshot.AddFile(level.name.c_str(), DecompressCachedLevel(level), level.size);
+		level.dirty = false;
+	}
+	snapshot.WriteTo(SaveWriter, pfile_get_password());
+}
+
+/** @brief Drops the least recently visited levels once the cache is full, writing them to the archive first. */
+void TrimLevelCache()
+{
+	size_t cacheSize = 0;
+	for (const CachedLevel &level : LevelCache)
+		cacheSize += level.compressedSize;
+
+	SaveSnapshot evicted;
+	bool hasEvictedFiles = false;
+	auto evictEnd = LevelCache.begin();
+	// The level that was just cached is always kept
+	while (evictEnd + 1 < LevelCache.end() && (static_cast<size_t>(LevelCache.end() - evictEnd) > MaxCachedLevels || cacheSize > MaxLevelCacheSize)) {
+		cacheSize -= evictEnd->compressedSize;
+		if (evictEnd->dirty) {
+			evicted.AddFile(evictEnd->name.c_str(), DecompressCachedLevel(*evictEnd), evictEnd->size);
+			hasEvictedFiles = true;
+		}
+		++evictEnd;
+	}
+	LevelCache.erase(LevelCache.begin(), evictEnd);
+
+	if (hasEvictedFiles) {
+		PFileScopedArchiveWriter scopedWriter;
+		evicted.WriteTo(SaveWriter, pfile_get_password());
+	}
+}
+
 bool ArchiveContainsGame(MpqArchive &hsArchive)
 {
 	if (gbIsMultiplayer)
@@ -220,14 +545,42 @@ bool ArchiveContainsGame(MpqArchive &hsArchive)
 
 } // namespace
 
+void SaveSnapshot::AddFile(const char *name, std::unique_ptr<byte[]> data, size_t size)
+{
+	files_.push_back({ name, std::move(data), size });
+}
+
+void SaveSnapshot::RemoveFile(const char *name)
+{
+	removedFiles_.emplace_back(name);
+}
+
+bool SaveSnapshot::WriteTo(MpqWriter &archive, const char *password)
+{
+	for (const std::string &name : removedFiles_)
+		archive.RemoveHashEntry(name.c_str());
+	removedFiles_.clear();
+
+	bool result = true;
+	for (File &file : files_) {
+		const size_t encodedLen = codec_get_encoded_len(file.size);
+		codec_encode(file.data.get(), file.size, encodedLen, password);
+		result = archive.WriteFile(file.name.c_str(), file.data.get(), encodedLen) && result;
+	}
+	files_.clear();
+	return result;
+}
+
 std::optional<MpqArchive> OpenSaveArchive(uint32_t saveNum)
 {
+	pfile_wait_for_save();
 	std::int32_t error;
 	return MpqArchive::Open(GetSavePath(saveNum).c_str(), error);
 }
 
 std::optional<MpqArchive> OpenStashArchive()
 {
+	pfile_wait_for_save();
 	std::int32_t error;
 	return MpqArchive::Open(GetStashSavePath().c_str(), error);
 }
@@ -251,6 +604,110 @@ std::unique_ptr<byte[]> ReadArchive(MpqArchive &archive, const char *pszName, si
 	return result;
 }
 
+SaveFileReader::SaveFileReader(MpqArchive archive, const char *pszName)
+    : archive_(std::move(archive))
+    , decoder_(pfile_get_password())
+{
+	failed_ = true;
+	if (!archive_.GetFileNumber(MpqArchive::CalculateFileHash(pszName), fileNumber_))
+		return;
+	if (archive_.OpenBlockOffsetTable(fileNumber_, pszName) != 0)
+		return;
+	offsetTableOpen_ = true;
+
+	int32_t error;
+	fileSize_ = archive_.GetUnpackedFileSize(fileNumber_, error);
+	if (error != 0)
+		return;
+	numSectors_ = archive_.GetNumBlocks(fileNumber_, error);
+	if (error != 0 || numSectors_ == 0)
+		return;
+	sectorSize_ = archive_.GetBlockSize(fileNumber_, 0, error);
+	if (error != 0)
+		return;
+
+	// Sectors have to hold whole chunks for them to be decoded one at a time
+	if (fileSize_ <= CodecDecoder::SignatureSize || (fileSize_ - CodecDecoder::SignatureSize) % CodecDecoder::ChunkSize != 0)
+		return;
+	if (numSectors_ > 1 && sectorSize_ % CodecDecoder::ChunkSize != 0)
+		return;
+
+	failed_ = false;
+}
+
+SaveFileReader::~SaveFileReader()
+{
+	if (offsetTableOpen_)
+		archive_.CloseBlockOffsetTable(fileNumber_);
+}
+
+bool SaveFileReader::ReadNextSector()
+{
+	if (failed_ || nextSector_ >= numSectors_)
+		return false;
+
+	// Drop what has been consumed, the loaders never go back
+	window_.erase(window_.begin(), window_.begin() + windowPos_);
+	windowStart_ += windowPos_;
+	windowPos_ = 0;
+
+	const size_t sectorStart = static_cast<size_t>(nextSector_) * sectorSize_;
+	const size_t sectorSize = nextSector_ + 1 == numSectors_ ? fileSize_ - sectorStart : sectorSize_;
+	const size_t oldSize = window_.size();
+	window_.resize(oldSize + sectorSize);
+	if (archive_.ReadBlock(fileNumber_, nextSector_, reinterpret_cast<uint8_t *>(&window_[oldSize]), sectorSize) != 0) {
+		failed_ = true;
+		return false;
+	}
+	nextSector_++;
+	readSize_ += sectorSize;
+
+	const size_t encodedSize = fileSize_ - CodecDecoder::SignatureSize;
+	const size_t encodedInSector = std::min(sectorSize, encodedSize - std::min(sectorStart, encodedSize));
+	decoder_.Decode(&window_[oldSize], encodedInSector);
+
+	if (readSize_ < fileSize_)
+		return true;
+
+	// The signature is always part of the last sector as the encoded data fills whole chunks
+	const size_t decodedSize = decoder_.Finish(&window_[window_.size() - CodecDecoder::SignatureSize], encodedSize);
+	if (decodedSize == 0 || decodedSize < windowStart_) {
+		failed_ = true;
+		return false;
+	}
+	window_.resize(std::min(window_.size(), decodedSize - windowStart_));
+	finished_ = true;
+	return true;
+}
+
+const byte *SaveFileReader::Peek(size_t size)
+{
+	// The padding at the end of the last chunk is only known once the signature has been read
+	while (!finished_ && (window_.size() - windowPos_ < size || windowStart_ + windowPos_ + size + CodecDecoder::ChunkSize + CodecDecoder::SignatureSize > fileSize_)) {
+		if (!ReadNextSector())
+			return nullptr;
+	}
+	if (failed_ || window_.size() - windowPos_ < size)
+		return nullptr;
+	return &window_[windowPos_];
+}
+
+void SaveFileReader::Skip(size_t size)
+{
+	if (Peek(size) == nullptr) {
+		windowPos_ = window_.size();
+		return;
+	}
+	windowPos_ += size;
+}
+
+bool SaveFileReader::Finish()
+{
+	while (!finished_ && ReadNextSector()) {
+	}
+	return finished_ && !failed_;
+}
+
 const char *pfile_get_password()
 {
 	if (gbIsSpawn)
@@ -276,27 +733,24 @@ MpqWriter &CurrentSaveArchive()
 	return SaveWriter;
 }
 
-MpqWriter &StashArchive()
-{
-	return StashWriter;
-}
-
 void pfile_write_hero(bool writeGameData, bool clearTables)
 {
-	PFileScopedArchiveWriter scopedWriter(clearTables);
-	if (writeGameData) {
-		SaveGameData();
-		RenameTempToPerm();
-	}
-	PlayerPack pkplr;
-	auto &myPlayer = Players[MyPlayerId];
+	Player &myPlayer = Players[MyPlayerId];
+	SaveSnapshot snapshot = SnapshotHero(myPlayer);
 
-	PackPlayer(&pkplr, myPlayer, !gbIsMultiplayer, false);
-	EncodeHero(&pkplr);
-	if (!gbVanilla) {
-		SaveHotkeys();
-		SaveHeroItems(myPlayer);
+	{
+		PFileScopedArchiveWriter scopedWriter(clearTables);
+		if (writeGameData) {
+			SaveGameData();
+			WriteDirtyCachedLevels();
+			RenameTempToPerm();
+		}
+		snapshot.WriteTo(SaveWriter, pfile_get_password());
 	}
+
+	_uiheroinfo heroInfo;
+	Game2UiPlayer(myPlayer, &heroInfo, gbValidSaveFile);
+	UpdateHeroIndex(gSaveNumber, heroInfo);
 }
 
 void sfile_write_stash()
@@ -304,21 +758,52 @@ void sfile_write_stash()
 	if (!Stash.dirty)
 		return;
 
+	SaveSnapshot snapshot;
+	SaveStash(snapshot);
+
+	pfile_wait_for_save();
+	UpdateSaveCompression();
 	if (!StashWriter.Open(GetStashSavePath().c_str()))
 		app_fatal("%s", _("Failed to open stash archive for writing.").c_str());
 
-	SaveStash();
+	snapshot.WriteTo(StashWriter, pfile_get_password());
 
 	StashWriter.Close();
 
 	Stash.dirty = false;
+	Stash.dirtyPages.clear();
 }
 
 bool pfile_ui_set_hero_infos(bool (*uiAddHeroInfo)(_uiheroinfo *))
 {
 	memset(hero_names, 0, sizeof(hero_names));
 
+	pfile_wait_for_save();
+	LoadHeroIndex();
+	bool indexChanged = false;
+
 	for (uint32_t i = 0; i < MAX_CHARACTERS; i++) {
+		HeroIndexEntry &entry = HeroIndex[i];
+		const std::string path = GetSavePath(i);
+		std::uintmax_t archiveSize;
+		std::int64_t archiveTime;
+		if (!GetFileSize(path.c_str(), &archiveSize) || !GetFileModificationTime(path.c_str(), &archiveTime)) {
+			indexChanged = indexChanged || entry.valid;
+			entry.valid = false;
+			continue;
+		}
+
+		if (entry.valid && entry.archiveSize == archiveSize && entry.archiveTime == archiveTime) {
+			_uiheroinfo uihero = entry.info;
+			uihero.spawned = gbIsSpawn;
+			CopyUtf8(hero_names[i], uihero.name, sizeof(hero_names[i]));
+			uiAddHeroInfo(&uihero);
+			continue;
+		}
+
+		// The archive changed since the index entry was written, decode the hero the slow way
+		indexChanged = indexChanged || entry.valid;
+		entry.valid = false;
 		std::optional<MpqArchive> archive = OpenSaveArchive(i);
 		if (archive) {
 			PlayerPack pkplr;
@@ -337,15 +822,22 @@ bool pfile_ui_set_hero_infos(bool (*uiAddHeroInfo)(_uiheroinfo *))
 				if (UnPackPlayer(&pkplr, player, false)) {
 					LoadHeroItems(player);
 					RemoveEmptyInventory(player);
+					player.MarkStatsDirty(PlayerStatsDirty::All);
 					CalcPlrInv(player, false);
 
 					Game2UiPlayer(player, &uihero, hasSaveGame);
 					uiAddHeroInfo(&uihero);
+
+					entry = { uihero, archiveSize, archiveTime, true };
+					indexChanged = true;
 				}
 			}
 		}
 	}
 
+	if (indexChanged)
+		SaveHeroIndex();
+
 	return true;
 }
 
@@ -387,14 +879,17 @@ bool pfile_ui_save_create(_uiheroinfo *heroinfo)
 	CreatePlayer(0, heroinfo->heroclass);
 	CopyUtf8(player._pName, heroinfo->name, PLR_NAME_LEN);
 	PackPlayer(&pkplr, player, true, false);
-	EncodeHero(&pkplr);
+	SaveSnapshot snapshot;
+	AddHero(snapshot, &pkplr);
 	Game2UiPlayer(player, heroinfo, false);
 	if (!gbVanilla) {
-		SaveHotkeys();
-		SaveHeroItems(player);
+		SaveHotkeys(snapshot);
+		SaveHeroItems(snapshot, player);
 	}
 
+	snapshot.WriteTo(SaveWriter, pfile_get_password());
 	SaveWriter.Close();
+	UpdateHeroIndex(saveNum, *heroinfo);
 	return true;
 }
 
@@ -403,7 +898,13 @@ bool pfile_delete_save(_uiheroinfo *heroInfo)
 	uint32_t saveNum = heroInfo->saveNumber;
 	if (saveNum < MAX_CHARACTERS) {
 		hero_names[saveNum][0] = '\0';
+		pfile_wait_for_save();
 		RemoveFile(GetSavePath(saveNum));
+		LoadHeroIndex();
+		if (HeroIndex[saveNum].valid) {
+			HeroIndex[saveNum].valid = false;
+			SaveHeroIndex();
+		}
 	}
 	return true;
 }
@@ -431,6 +932,7 @@ void pfile_read_player_from_save(uint32_t saveNum, Player &player)
 
 	LoadHeroItems(player);
 	RemoveEmptyInventory(player);
+	player.MarkStatsDirty(PlayerStatsDirty::All);
 	CalcPlrInv(player, false);
 }
 
@@ -439,6 +941,8 @@ bool LevelFileExists()
 	char szName[MAX_PATH];
 
 	GetPermLevelNames(szName);
+	if (FindCachedLevel(szName) != LevelCache.end())
+		return true;
 
 	uint32_t saveNum = gSaveNumber;
 	if (!OpenArchive(saveNum))
@@ -461,6 +965,9 @@ void GetPermLevelNames(char *szPerm)
 {
 	uint32_t saveNum = gSaveNumber;
 	GetTempLevelNames(szPerm);
+	if (FindCachedLevel(szPerm) != LevelCache.end())
+		return;
+
 	if (!OpenArchive(saveNum))
 		app_fatal("%s", _("Unable to read to save file archive").c_str());
 
@@ -476,6 +983,8 @@ void GetPermLevelNames(char *szPerm)
 
 void pfile_remove_temp_files()
 {
+	LevelCache.clear();
+
 	if (gbIsMultiplayer)
 		return;
 
@@ -486,6 +995,40 @@ void pfile_remove_temp_files()
 	SaveWriter.Close();
 }
 
+void pfile_cache_levels(SaveSnapshot &snapshot)
+{
+	for (SaveSnapshot::File &file : snapshot.TakeFiles()) {
+		LevelCompressBuffer.resize(LzCompressBound(file.size));
+		CachedLevel level;
+		level.name = std::move(file.name);
+		level.size = file.size;
+		level.compressedSize = LzCompress(file.data.get(), file.size, LevelCompressBuffer.data(), LevelCompressBuffer.size());
+		level.data.reset(new byte[level.compressedSize]);
+		memcpy(level.data.get(), LevelCompressBuffer.data(), level.compressedSize);
+		level.dirty = true;
+
+		auto oldLevel = FindCachedLevel(level.name.c_str());
+		if (oldLevel != LevelCache.end())
+			LevelCache.erase(oldLevel);
+		LevelCache.push_back(std::move(level));
+	}
+
+	TrimLevelCache();
+}
+
+std::unique_ptr<byte[]> pfile_read_cached_level(const char *pszName, size_t *pdwLen)
+{
+	auto level = FindCachedLevel(pszName);
+	if (level == LevelCache.end())
+		return nullptr;
+
+	// Keep the level around for as long as possible once the player leaves it again
+	std::rotate(level, level + 1, LevelCache.end());
+	const CachedLevel &mostRecent = LevelCache.back();
+	*pdwLen = mostRecent.size;
+	return DecompressCachedLevel(mostRecent);
+}
+
 void pfile_update(bool forceSave)
 {
 	static Uint32 prevTick;
@@ -493,13 +1036,56 @@ void pfile_update(bool forceSave)
 	if (!gbIsMultiplayer)
 		return;
 
+	if (!SaveInFlight && SaveThread.joinable())
+		pfile_wait_for_save();
+
 	Uint32 tick = SDL_GetTicks();
 	if (!forceSave && tick - prevTick <= 60000)
 		return;
 
+	// Rather than stalling the game loop, try again next frame
+	if (!forceSave && SaveInFlight)
+		return;
+
 	prevTick = tick;
-	pfile_write_hero();
-	sfile_write_stash();
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<SaveJob> jobs;
+	Player &myPlayer = Players[MyPlayerId];
+	_uiheroinfo heroInfo;
+	Game2UiPlayer(myPlayer, &heroInfo, gbValidSaveFile);
+	jobs.push_back({ &SaveWriter, GetSavePath(gSaveNumber), SnapshotHero(myPlayer), pfile_get_password(), heroInfo, gSaveNumber });
+	if (Stash.dirty) {
+		SaveSnapshot stash;
+		SaveStash(stash);
+		jobs.push_back({ &StashWriter, GetStashSavePath(), std::move(stash), pfile_get_password(), std::nullopt, 0 });
+		jobs.back().stashPages.swap(Stash.dirtyPages);
+		Stash.dirty = false;
+	}
+	LastSnapshotTime = MicrosecondsSince(start);
+
+	pfile_wait_for_save();
+	UpdateSaveCompression();
+	SaveJobs = std::move(jobs);
+	SaveInFlight = true;
+	SaveThread = SdlThread { SaveThreadHandler };
+}
+
+void pfile_wait_for_save()
+{
+	if (!SaveThread.joinable())
+		return;
+	SaveThread.join();
+	FinishSaveJobs();
+}
+
+SaveStats pfile_get_save_stats()
+{
+	SaveStats stats;
+	stats.snapshotTime = LastSnapshotTime;
+	stats.writeTime = LastWriteTime;
+	stats.inFlight = SaveInFlight;
+	return stats;
 }
 
 } // namespace devilution
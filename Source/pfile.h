@@ -5,7 +5,13 @@
  */
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "DiabloUI/diabloui.h"
+#include "codec.h"
+#include "mpq/mpq_reader.hpp"
 #include "mpq/mpq_writer.hpp"
 #include "player.h"
 
@@ -15,6 +21,51 @@ namespace devilution {
 
 extern bool gbValidSaveFile;
 
+/**
+ * @brief Serialised save files that still have to be encoded and written to an archive.
+ *
+ * Taking a snapshot only copies game state, so it is cheap enough for the main thread,
+ * while the encoding and archive writes can be left to the save thread.
+ */
+class SaveSnapshot {
+public:
+	/**
+	 * @brief Takes ownership of an unencoded file.
+	 * @param data Must have room for codec_get_encoded_len(size) bytes, the file is encoded in place.
+	 */
+	void AddFile(const char *name, std::unique_ptr<byte[]> data, size_t size);
+
+	/** @brief Removes a file from the archive the snapshot is written to. */
+	void RemoveFile(const char *name);
+
+	/** @brief Encodes all files and writes them to the archive. */
+	bool WriteTo(MpqWriter &archive, const char *password);
+
+	struct File {
+		std::string name;
+		std::unique_ptr<byte[]> data;
+		size_t size;
+	};
+
+	/** @brief Moves the unencoded files out of the snapshot. */
+	std::vector<File> TakeFiles()
+	{
+		return std::move(files_);
+	}
+
+private:
+	std::vector<File> files_;
+	std::vector<std::string> removedFiles_;
+};
+
+struct SaveStats {
+	/** Time spent serialising the last background save on the main thread, in microseconds. */
+	uint32_t snapshotTime;
+	/** Time the save thread took to encode and write the last save, in microseconds. */
+	uint32_t writeTime;
+	bool inFlight;
+};
+
 class PFileScopedArchiveWriter {
 public:
 	// Opens the player save file for writing
@@ -28,8 +79,53 @@ private:
 	bool clear_tables_;
 };
 
+/**
+ * @brief Reads a save file from an archive one sector at a time and decodes it on the fly.
+ *
+ * Parsing can start as soon as the first sector is in, and only the part of the file that has
+ * not been consumed yet is kept in memory. The file is only known to be intact once Finish
+ * has checked its signature.
+ */
+class SaveFileReader {
+public:
+	SaveFileReader(MpqArchive archive, const char *pszName);
+	~SaveFileReader();
+
+	SaveFileReader(const SaveFileReader &) = delete;
+	SaveFileReader &operator=(const SaveFileReader &) = delete;
+
+	/** @return The next size bytes of the file, or nullptr if the file ends before that or can't be read. */
+	const byte *Peek(size_t size);
+
+	/** @brief Moves past the next size bytes, skipping past the end makes all further reads fail. */
+	void Skip(size_t size);
+
+	/** @brief Reads the rest of the file and checks its signature. */
+	bool Finish();
+
+private:
+	bool ReadNextSector();
+
+	MpqArchive archive_;
+	uint32_t fileNumber_ = 0;
+	bool offsetTableOpen_ = false;
+	uint32_t numSectors_ = 0;
+	uint32_t nextSector_ = 0;
+	size_t sectorSize_ = 0;
+	/** Size of the file in the archive, including the signature. */
+	size_t fileSize_ = 0;
+	/** Bytes of the file read from the archive so far. */
+	size_t readSize_ = 0;
+	CodecDecoder decoder_;
+	/** Decoded data that has been read but not consumed yet, starts at windowStart_ + windowPos_ in the file. */
+	std::vector<byte> window_;
+	size_t windowStart_ = 0;
+	size_t windowPos_ = 0;
+	bool finished_ = false;
+	bool failed_ = false;
+};
+
 MpqWriter &CurrentSaveArchive();
-MpqWriter &StashArchive();
 std::optional<MpqArchive> OpenSaveArchive(uint32_t saveNum);
 std::optional<MpqArchive> OpenStashArchive();
 const char *pfile_get_password();
@@ -46,7 +142,24 @@ bool LevelFileExists();
 void GetTempLevelNames(char *szTemp);
 void GetPermLevelNames(char *szPerm);
 void pfile_remove_temp_files();
+/**
+ * @brief Keeps the levels the player left in memory instead of writing them to the save archive.
+ *
+ * The most recently visited levels stay in the cache, older ones are written to the archive
+ * as temporary level files, just like the real save writes every level that is still cached.
+ */
+void pfile_cache_levels(SaveSnapshot &snapshot);
+/** @brief Returns the unencoded level file, or nullptr if the level isn't cached. */
+std::unique_ptr<byte[]> pfile_read_cached_level(const char *pszName, size_t *pdwLen);
 std::unique_ptr<byte[]> pfile_read(const char *pszName, size_t *pdwLen);
+/**
+ * @brief Saves the hero and stash in multiplayer games, at most once a minute unless forced.
+ *
+ * The files are written by the save thread, use pfile_wait_for_save() before touching the save files.
+ */
 void pfile_update(bool forceSave);
+/** @brief Blocks until the save thread has written every queued save. */
+void pfile_wait_for_save();
+SaveStats pfile_get_save_stats();
 
 } // namespace devilution
@@ -736,9 +736,11 @@ bool WeaponDecay(Player &player, int ii)
 		player.InvBody[ii]._iPLDam -= 5;
 		if (player.InvBody[ii]._iPLDam <= -100) {
 			RemoveEquipment(player, static_cast<inv_body_loc>(ii), true);
+			player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 			CalcPlrInv(player, true);
 			return true;
 		}
+		player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 		CalcPlrInv(player, true);
 	}
 	return false;
@@ -772,6 +774,7 @@ bool DamageWeapon(int pnum, int durrnd)
 		player.InvBody[INVLOC_HAND_LEFT]._iDurability--;
 		if (player.InvBody[INVLOC_HAND_LEFT]._iDurability <= 0) {
 			RemoveEquipment(player, INVLOC_HAND_LEFT, true);
+			player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 			CalcPlrInv(player, true);
 			return true;
 		}
@@ -785,6 +788,7 @@ bool DamageWeapon(int pnum, int durrnd)
 		player.InvBody[INVLOC_HAND_RIGHT]._iDurability--;
 		if (player.InvBody[INVLOC_HAND_RIGHT]._iDurability == 0) {
 			RemoveEquipment(player, INVLOC_HAND_RIGHT, true);
+			player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 			CalcPlrInv(player, true);
 			return true;
 		}
@@ -798,6 +802,7 @@ bool DamageWeapon(int pnum, int durrnd)
 		player.InvBody[INVLOC_HAND_RIGHT]._iDurability--;
 		if (player.InvBody[INVLOC_HAND_RIGHT]._iDurability == 0) {
 			RemoveEquipment(player, INVLOC_HAND_RIGHT, true);
+			player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 			CalcPlrInv(player, true);
 			return true;
 		}
@@ -811,6 +816,7 @@ bool DamageWeapon(int pnum, int durrnd)
 		player.InvBody[INVLOC_HAND_LEFT]._iDurability--;
 		if (player.InvBody[INVLOC_HAND_LEFT]._iDurability == 0) {
 			RemoveEquipment(player, INVLOC_HAND_LEFT, true);
+			player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 			CalcPlrInv(player, true);
 			return true;
 		}
@@ -1300,6 +1306,7 @@ void DamageParryItem(int pnum)
 		player.InvBody[INVLOC_HAND_LEFT]._iDurability--;
 		if (player.InvBody[INVLOC_HAND_LEFT]._iDurability == 0) {
 			RemoveEquipment(player, INVLOC_HAND_LEFT, true);
+			player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 			CalcPlrInv(player, true);
 		}
 	}
@@ -1309,6 +1316,7 @@ void DamageParryItem(int pnum)
 			player.InvBody[INVLOC_HAND_RIGHT]._iDurability--;
 			if (player.InvBody[INVLOC_HAND_RIGHT]._iDurability == 0) {
 				RemoveEquipment(player, INVLOC_HAND_RIGHT, true);
+				player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 				CalcPlrInv(player, true);
 			}
 		}
@@ -1380,6 +1388,7 @@ void DamageArmor(int pnum)
 	} else {
 		RemoveEquipment(player, INVLOC_HEAD, true);
 	}
+	player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 	CalcPlrInv(player, true);
 }
 
@@ -1818,8 +1827,10 @@ void ValidatePlayer()
 	}
 	auto &myPlayer = Players[MyPlayerId];
 
-	if (myPlayer._pLevel > MAXCHARLEVEL)
+	if (myPlayer._pLevel > MAXCHARLEVEL) {
 		myPlayer._pLevel = MAXCHARLEVEL;
+		myPlayer.MarkStatsDirty(PlayerStatsDirty::Level);
+	}
 	if (myPlayer._pExperience > myPlayer._pNextExper) {
 		myPlayer._pExperience = myPlayer._pNextExper;
 		if (*sgOptions.Gameplay.experienceBar) {
@@ -1845,27 +1856,34 @@ void ValidatePlayer()
 
 	if (myPlayer._pBaseStr > myPlayer.GetMaximumAttributeValue(CharacterAttribute::Strength)) {
 		myPlayer._pBaseStr = myPlayer.GetMaximumAttributeValue(CharacterAttribute::Strength);
+		myPlayer.MarkStatsDirty(PlayerStatsDirty::Level);
 	}
 	if (myPlayer._pBaseMag > myPlayer.GetMaximumAttributeValue(CharacterAttribute::Magic)) {
 		myPlayer._pBaseMag = myPlayer.GetMaximumAttributeValue(CharacterAttribute::Magic);
+		myPlayer.MarkStatsDirty(PlayerStatsDirty::Level);
 	}
 	if (myPlayer._pBaseDex > myPlayer.GetMaximumAttributeValue(CharacterAttribute::Dexterity)) {
 		myPlayer._pBaseDex = myPlayer.GetMaximumAttributeValue(CharacterAttribute::Dexterity);
+		myPlayer.MarkStatsDirty(PlayerStatsDirty::Level);
 	}
 	if (myPlayer._pBaseVit > myPlayer.GetMaximumAttributeValue(CharacterAttribute::Vitality)) {
 		myPlayer._pBaseVit = myPlayer.GetMaximumAttributeValue(CharacterAttribute::Vitality);
+		myPlayer.MarkStatsDirty(PlayerStatsDirty::Level);
 	}
 
 	uint64_t msk = 0;
 	for (int b = SPL_FIREBOLT; b < MAX_SPELLS; b++) {
 		if (GetSpellBookLevel((spell_id)b) != -1) {
 			msk |= GetSpellBitmask(b);
-			if (myPlayer._pSplLvl[b] > MAX_SPELL_LEVEL)
+			if (myPlayer._pSplLvl[b] > MAX_SPELL_LEVEL) {
 				myPlayer._pSplLvl[b] = MAX_SPELL_LEVEL;
+				myPlayer.MarkStatsDirty(PlayerStatsDirty::Level);
+			}
 		}
 	}
 
 	myPlayer._pMemSpells &= msk;
+	CalcPlrInv(myPlayer, true);
 }
 
 void CheckCheatStats(Player &player)
@@ -2695,6 +2713,7 @@ void NextPlrLevel(int pnum)
 	player._pLevel++;
 	player._pMaxLvl++;
 
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 
 	if (CalcStatDiff(player) < 5) {
@@ -2737,6 +2756,7 @@ void NextPlrLevel(int pnum)
 	if (ControlMode != ControlTypes::KeyboardAndMouse)
 		FocusOnCharInfo();
 
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 }
 
@@ -3137,6 +3157,7 @@ StartPlayerKill(int pnum, int earflag)
 		for (auto &item : player.InvBody) {
 			item.Clear();
 		}
+		player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 		CalcPlrInv(player, false);
 	}
 
@@ -3191,6 +3212,7 @@ StartPlayerKill(int pnum, int earflag)
 							item.Clear();
 						}
 
+						player.MarkStatsDirty(PlayerStatsDirty::Equipment);
 						CalcPlrInv(player, false);
 					}
 				}
@@ -3360,6 +3382,7 @@ void RestartTownLvl(int pnum)
 	player._pMana = 0;
 	player._pManaBase = player._pMana - (player._pMaxMana - player._pMaxManaBase);
 
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, false);
 
 	if (pnum == MyPlayerId) {
@@ -3425,6 +3448,9 @@ void ProcessPlayers()
 	}
 
 	ValidatePlayer();
+#ifdef _DEBUG
+	VerifyPlrInvCache(myPlayer);
+#endif
 
 	for (int pnum = 0; pnum < MAX_PLRS; pnum++) {
 		auto &player = Players[pnum];
@@ -3790,6 +3816,7 @@ void ModifyPlrStr(int p, int l)
 	player._pStrength += l;
 	player._pBaseStr += l;
 
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 
 	if (p == MyPlayerId) {
@@ -3823,6 +3850,7 @@ void ModifyPlrMag(int p, int l)
 		player._pMana += ms;
 	}
 
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 
 	if (p == MyPlayerId) {
@@ -3841,6 +3869,7 @@ void ModifyPlrDex(int p, int l)
 
 	player._pDexterity += l;
 	player._pBaseDex += l;
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 
 	if (p == MyPlayerId) {
@@ -3870,6 +3899,7 @@ void ModifyPlrVit(int p, int l)
 	player._pHitPoints += ms;
 	player._pMaxHP += ms;
 
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 
 	if (p == MyPlayerId) {
@@ -3890,6 +3920,7 @@ void SetPlayerHitPoints(Player &player, int val)
 void SetPlrStr(Player &player, int v)
 {
 	player._pBaseStr = v;
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 }
 
@@ -3906,12 +3937,14 @@ void SetPlrMag(Player &player, int v)
 
 	player._pMaxManaBase = m;
 	player._pMaxMana = m;
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 }
 
 void SetPlrDex(Player &player, int v)
 {
 	player._pBaseDex = v;
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 }
 
@@ -3926,6 +3959,7 @@ void SetPlrVit(Player &player, int v)
 
 	player._pHPBase = hp;
 	player._pMaxHPBase = hp;
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(player, true);
 }
 
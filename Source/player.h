@@ -160,6 +160,19 @@ enum class SpellFlag : uint8_t {
 };
 use_enum_as_flags(SpellFlag);
 
+/** Inputs of the derived player stats that changed since CalcPlrInv last ran */
+enum class PlayerStatsDirty : uint8_t {
+	// clang-format off
+	None      = 0,
+	Equipment = 1 << 0, // items worn in InvBody
+	Buffs     = 1 << 1, // spell effects such as rage
+	Level     = 1 << 2, // character level, base attributes and spell levels
+	Inventory = 1 << 3, // items carried in the inventory or the belt
+	All       = Equipment | Buffs | Level | Inventory,
+	// clang-format on
+};
+use_enum_as_flags(PlayerStatsDirty);
+
 /** Maps from armor animation to letter used in graphic files. */
 constexpr std::array<char, 4> ArmourChar = {
 	'L', // light
@@ -348,9 +361,19 @@ struct Player {
 	uint8_t pDiabloKillLevel;
 	_difficulty pDifficulty;
 	ItemSpecialEffectHf pDamAcFlags;
+	/** Parts of the derived stats that CalcPlrInv has to recompute */
+	PlayerStatsDirty statsDirty = PlayerStatsDirty::All;
 
 	void CalcScrolls();
 
+	/**
+	 * @brief Invalidates the derived stats depending on the given inputs, the next CalcPlrInv recomputes them
+	 */
+	void MarkStatsDirty(PlayerStatsDirty inputs)
+	{
+		statsDirty |= inputs;
+	}
+
 	bool CanUseItem(const Item &item) const
 	{
 		return _pStrength >= item._iMinStr
@@ -1,6 +1,7 @@
 #include "qol/stash.h"
 
 #include "utils/stdcompat/algorithm.hpp"
+#include <bitset>
 #include <fmt/format.h>
 #include <utility>
 
@@ -28,7 +29,6 @@ int WithdrawGoldValue;
 
 namespace {
 
-constexpr unsigned CountStashPages = 100;
 constexpr unsigned LastStashPage = CountStashPages - 1;
 
 int InitialWithdrawGoldValue;
@@ -58,6 +58,19 @@ void AddItemToStashGrid(unsigned page, Point position, uint16_t stashListIndex,
 	}
 }
 
+/** One bit per cell of a stash page, bit x + 10 * y stands for the cell at x, y. */
+using StashOccupancy = std::bitset<100>;
+
+StashOccupancy GetPageOccupancy(const StashStruct::StashGrid &grid)
+{
+	StashOccupancy occupancy;
+	for (auto point : PointsInRectangleRange({ { 0, 0 }, { 10, 10 } })) {
+		if (grid[point.x][point.y] != 0)
+			occupancy.set(point.x + 10 * point.y);
+	}
+	return occupancy;
+}
+
 Point FindSlotUnderCursor(Point cursorPosition)
 {
 	for (auto point : PointsInRectangleRange({ { 0, 0 }, { 10, 10 } })) {
@@ -144,7 +157,7 @@ void CheckStashPaste(Point cursorPosition)
 
 	AddItemToStashGrid(Stash.GetPage(), firstSlot, stashIndex, itemSize);
 
-	Stash.dirty = true;
+	Stash.MarkPageDirty(Stash.GetPage());
 
 	if (player.HoldItem.isEmpty() && !IsHardwareCursor()) {
 		// To make software cursors behave like hardware cursors we need to adjust the hand cursor position manually
@@ -204,6 +217,7 @@ void CheckStashCut(Point cursorPosition, bool automaticMove)
 	}
 
 	if (!holdItem.isEmpty()) {
+		player.MarkStatsDirty(PlayerStatsDirty::Inventory);
 		CalcPlrInv(player, true);
 		holdItem._iStatFlag = player.CanUseItem(holdItem);
 		if (automaticallyEquipped) {
@@ -518,8 +532,7 @@ void StashStruct::RemoveStashItem(StashStruct::StashCell iv)
 	if (lastItemIndex != iv) {
 		stashList[iv] = stashList[lastItemIndex];
 
-		for (auto &pair : Stash.stashGrids) {
-			auto &grid = pair.second;
+		for (auto &grid : Stash.stashGrids) {
 			for (auto &row : grid) {
 				for (StashStruct::StashCell &itemId : row) {
 					if (itemId == lastItemIndex + 1) {
@@ -530,7 +543,7 @@ void StashStruct::RemoveStashItem(StashStruct::StashCell iv)
 		}
 	}
 	stashList.pop_back();
-	Stash.dirty = true;
+	MarkPageDirty(GetPage());
 }
 
 void StashStruct::SetPage(unsigned newPage)
@@ -566,6 +579,34 @@ void StashStruct::RefreshItemStatFlags()
 	}
 }
 
+StashStruct::ItemFlagInputs StashStruct::GetItemFlagInputs(const Player &player)
+{
+	ItemFlagInputs inputs;
+	inputs.strength = player._pStrength;
+	inputs.magic = player._pMagic;
+	inputs.dexterity = player._pDexterity;
+	std::copy(std::begin(player._pSplLvl), std::end(player._pSplLvl), inputs.spellLevels.begin());
+	return inputs;
+}
+
+bool StashStruct::AreItemFlagsCurrent(const Player &player) const
+{
+	if (!itemFlagsValid)
+		return false;
+
+	const ItemFlagInputs inputs = GetItemFlagInputs(player);
+	return inputs.strength == itemFlagInputs.strength
+	    && inputs.magic == itemFlagInputs.magic
+	    && inputs.dexterity == itemFlagInputs.dexterity
+	    && inputs.spellLevels == itemFlagInputs.spellLevels;
+}
+
+void StashStruct::ItemFlagsRefreshed(const Player &player)
+{
+	itemFlagInputs = GetItemFlagInputs(player);
+	itemFlagsValid = true;
+}
+
 void StartGoldWithdraw()
 {
 	CloseGoldDrop();
@@ -667,6 +708,10 @@ bool AutoPlaceItemInStash(Player &player, const Item &item, bool persistItem)
 	}
 
 	Size itemSize = GetInventorySize(item);
+	StashOccupancy itemMask;
+	for (auto itemPoint : PointsInRectangleRange({ { 0, 0 }, itemSize })) {
+		itemMask.set(itemPoint.x + 10 * itemPoint.y);
+	}
 
 	// Try to add the item to the current active page and if it's not possible move forward
 	for (unsigned pageCounter = 0; pageCounter < CountStashPages; pageCounter++) {
@@ -674,25 +719,20 @@ bool AutoPlaceItemInStash(Player &player, const Item &item, bool persistItem)
 		// Wrap around if needed
 		if (pageIndex >= CountStashPages)
 			pageIndex -= CountStashPages;
+		const StashOccupancy occupancy = GetPageOccupancy(Stash.stashGrids[pageIndex]);
+		if (occupancy.size() - occupancy.count() < itemMask.count())
+			continue;
 		// Search all possible position in stash grid
 		for (auto stashPosition : PointsInRectangleRange({ { 0, 0 }, { 10 - (itemSize.width - 1), 10 - (itemSize.height - 1) } })) {
 			// Check that all needed slots are free
-			bool isSpaceFree = true;
-			for (auto itemPoint : PointsInRectangleRange({ stashPosition, itemSize })) {
-				uint16_t iv = Stash.stashGrids[pageIndex][itemPoint.x][itemPoint.y];
-				if (iv != 0) {
-					isSpaceFree = false;
-					break;
-				}
-			}
-			if (!isSpaceFree)
+			if ((occupancy & (itemMask << (stashPosition.x + 10 * stashPosition.y))).any())
 				continue;
 			if (persistItem) {
 				Stash.stashList.push_back(item);
 				uint16_t stashIndex = static_cast<uint16_t>(Stash.stashList.size() - 1);
 				Stash.stashList[stashIndex].position = stashPosition + Displacement { 0, itemSize.height - 1 };
 				AddItemToStashGrid(pageIndex, stashPosition, stashIndex, itemSize);
-				Stash.dirty = true;
+				Stash.MarkPageDirty(pageIndex);
 			}
 			return true;
 		}
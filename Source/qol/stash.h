@@ -5,15 +5,19 @@
  */
 #pragma once
 
+#include <array>
 #include <cstdint>
-#include <map>
+#include <set>
 #include <vector>
 
 #include "engine/point.hpp"
 #include "items.h"
+#include "player.h"
 
 namespace devilution {
 
+constexpr unsigned CountStashPages = 100;
+
 class StashStruct {
 public:
 	using StashCell = uint16_t;
@@ -21,10 +25,20 @@ public:
 	static constexpr StashCell EmptyCell = -1;
 
 	void RemoveStashItem(StashCell iv);
-	std::map<unsigned, StashGrid> stashGrids;
+	std::array<StashGrid, CountStashPages> stashGrids;
 	std::vector<Item> stashList;
 	int gold;
 	bool dirty = false;
+	/** Pages whose grid or items changed since the stash was last written. */
+	std::set<unsigned> dirtyPages;
+
+	/** @brief Marks a page to be rewritten by the next stash save, gold and the current page are always written. */
+	void MarkPageDirty(unsigned pageIndex)
+	{
+		dirtyPages.insert(pageIndex);
+		dirty = true;
+		itemFlagsValid = false;
+	}
 
 	unsigned GetPage() const
 	{
@@ -59,9 +73,31 @@ public:
 	/** @brief Updates _iStatFlag for all stash items. */
 	void RefreshItemStatFlags();
 
+	/**
+	 * @brief Checks if the book requirements and _iStatFlag of the stash items are up to date for the player.
+	 *
+	 * They only depend on the stash contents and the player's attributes and spell levels, any
+	 * MarkPageDirty call counts as a change of the contents.
+	 */
+	bool AreItemFlagsCurrent(const Player &player) const;
+
+	/** @brief Remembers what the stash item flags were computed from, see AreItemFlagsCurrent. */
+	void ItemFlagsRefreshed(const Player &player);
+
 private:
+	struct ItemFlagInputs {
+		int strength;
+		int magic;
+		int dexterity;
+		std::array<int8_t, sizeof(Player::_pSplLvl)> spellLevels;
+	};
+
+	static ItemFlagInputs GetItemFlagInputs(const Player &player);
+
 	/** Current Page */
 	unsigned page;
+	bool itemFlagsValid = false;
+	ItemFlagInputs itemFlagInputs;
 };
 
 constexpr Point InvalidStashPoint { -1, -1 };
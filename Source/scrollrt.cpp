@@ -28,6 +28,7 @@
 #include "missiles.h"
 #include "nthread.h"
 #include "panels/charpanel.hpp"
+#include "pfile.h"
 #include "plrmsg.h"
 #include "qol/chatlog.h"
 #include "qol/itemlabels.h"
@@ -1347,6 +1348,32 @@ void DrawFPS(const Surface &out)
 	DrawString(out, string, Point { 8, 68 }, UiFlags::ColorRed);
 }
 
+/**
+ * @brief Display the network latency, input latency and stall frequency below the FPS
+ */
+void DrawNetStats(const Surface &out)
+{
+	if (!frameflag || !gbActive || !gbIsMultiplayer)
+		return;
+
+	NetTurnStats stats = nthread_get_turn_stats();
+	std::string string = fmt::format("{} ms RTT (+/- {}), {} turns / {} ms input, {} stalls/min", stats.latency, stats.jitter, stats.turnsInTransit, stats.inputLatency, stats.stallsPerMinute);
+	DrawString(out, string, Point { 8, 86 }, UiFlags::ColorRed);
+}
+
+/**
+ * @brief Display how long the last background save took on the main thread and on the save thread
+ */
+void DrawSaveStats(const Surface &out)
+{
+	if (!frameflag || !gbActive || !gbIsMultiplayer)
+		return;
+
+	SaveStats stats = pfile_get_save_stats();
+	std::string string = fmt::format("Save: {} us snapshot, {} us write{}", stats.snapshotTime, stats.writeTime, stats.inFlight ? " (writing)" : "");
+	DrawString(out, string, Point { 8, 104 }, UiFlags::ColorRed);
+}
+
 /**
  * @brief Update part of the screen from the back buffer
  * @param dwX Back buffer coordinate
@@ -1751,6 +1778,8 @@ void DrawAndBlit()
 	}
 
 	DrawFPS(out);
+	DrawNetStats(out);
+	DrawSaveStats(out);
 
 	DrawMain(hgt, ddsdesc, drawhpflag, drawmanaflag, drawsbarflag, drawbtnflag);
 
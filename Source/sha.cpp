@@ -3,6 +3,11 @@
 #include <cstdint>
 #include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEVILUTIONX_SHA1_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace devilution {
 
 // NOTE: Diablo's "SHA1" is different from actual SHA1 in that it uses arithmetic
@@ -17,9 +22,63 @@ uint32_t SHA1CircularShift(uint32_t word, size_t bits)
 {
 	// The SHA-like algorithm as originally implemented treated word as a signed value and used arithmetic right shifts
 	//  (sign-extending). This results in the high 32-`bits` bits being set to 1.
-	if ((word & (1 << 31)) != 0)
-		return (0xFFFFFFFF << bits) | (word >> (32 - bits));
-	return (word << bits) | (word >> (32 - bits));
+	const uint32_t signExtension = 0U - (word >> 31);
+	return (word << bits) | (word >> (32 - bits)) | (signExtension << bits);
+}
+
+/** @brief Expands the 16 words of a block into the 80 words used by the rounds. */
+void SHA1ExpandMessage(uint32_t w[80])
+{
+#ifdef DEVILUTIONX_SHA1_SSE2
+	for (int i = 16; i < 80; i += 4) {
+		__m128i next = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&w[i - 16])), _mm_loadu_si128(reinterpret_cast<const __m128i *>(&w[i - 14])));
+		next = _mm_xor_si128(next, _mm_loadu_si128(reinterpret_cast<const __m128i *>(&w[i - 8])));
+		// w[i - 3], w[i - 2], w[i - 1] and a zero, as w[i] is not known yet
+		next = _mm_xor_si128(next, _mm_srli_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&w[i - 4])), 4));
+		// Unlike real SHA1 there is no rotation, so the missing w[i] is simply the first lane xored into the last one
+		next = _mm_xor_si128(next, _mm_slli_si128(next, 12));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&w[i]), next);
+	}
+#else
+	for (int i = 16; i < 80; i++) {
+		w[i] = w[i - 16] ^ w[i - 14] ^ w[i - 8] ^ w[i - 3];
+	}
+#endif
+}
+
+uint32_t SHA1Choose(uint32_t b, uint32_t c, uint32_t d)
+{
+	return d ^ (b & (c ^ d));
+}
+
+uint32_t SHA1Parity(uint32_t b, uint32_t c, uint32_t d)
+{
+	return b ^ c ^ d;
+}
+
+uint32_t SHA1Majority(uint32_t b, uint32_t c, uint32_t d)
+{
+	return (b & c) | (d & (b | c));
+}
+
+/**
+ * @brief Runs 20 rounds, five at a time so the variables are rotated by renaming instead of moving them around.
+ */
+template <uint32_t (*Function)(uint32_t, uint32_t, uint32_t), uint32_t Constant>
+void SHA1Rounds(uint32_t &a, uint32_t &b, uint32_t &c, uint32_t &d, uint32_t &e, const uint32_t *w)
+{
+	for (int i = 0; i < 20; i += 5) {
+		e += SHA1CircularShift(a, 5) + Function(b, c, d) + w[i] + Constant;
+		b = SHA1CircularShift(b, 30);
+		d += SHA1CircularShift(e, 5) + Function(a, b, c) + w[i + 1] + Constant;
+		a = SHA1CircularShift(a, 30);
+		c += SHA1CircularShift(d, 5) + Function(e, a, b) + w[i + 2] + Constant;
+		e = SHA1CircularShift(e, 30);
+		b += SHA1CircularShift(c, 5) + Function(d, e, a) + w[i + 3] + Constant;
+		d = SHA1CircularShift(d, 30);
+		a += SHA1CircularShift(b, 5) + Function(c, d, e) + w[i + 4] + Constant;
+		c = SHA1CircularShift(c, 30);
+	}
 }
 
 void SHA1ProcessMessageBlock(SHA1Context *context)
@@ -27,9 +86,7 @@ void SHA1ProcessMessageBlock(SHA1Context *context)
 	std::uint32_t w[80];
 
 	memcpy(w, context->buffer, BlockSize * sizeof(uint32_t));
-	for (int i = 16; i < 80; i++) {
-		w[i] = w[i - 16] ^ w[i - 14] ^ w[i - 8] ^ w[i - 3];
-	}
+	SHA1ExpandMessage(w);
 
 	std::uint32_t a = context->state[0];
 	std::uint32_t b = context->state[1];
@@ -37,41 +94,10 @@ void SHA1ProcessMessageBlock(SHA1Context *context)
 	std::uint32_t d = context->state[3];
 	std::uint32_t e = context->state[4];
 
-	for (int i = 0; i < 20; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + ((b & c) | ((~b) & d)) + e + w[i] + 0x5A827999;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
-
-	for (int i = 20; i < 40; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + (b ^ c ^ d) + e + w[i] + 0x6ED9EBA1;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
-
-	for (int i = 40; i < 60; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + ((b & c) | (b & d) | (c & d)) + e + w[i] + 0x8F1BBCDC;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
-
-	for (int i = 60; i < 80; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + (b ^ c ^ d) + e + w[i] + 0xCA62C1D6;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
+	SHA1Rounds<SHA1Choose, 0x5A827999>(a, b, c, d, e, &w[0]);
+	SHA1Rounds<SHA1Parity, 0x6ED9EBA1>(a, b, c, d, e, &w[20]);
+	SHA1Rounds<SHA1Majority, 0x8F1BBCDC>(a, b, c, d, e, &w[40]);
+	SHA1Rounds<SHA1Parity, 0xCA62C1D6>(a, b, c, d, e, &w[60]);
 
 	context->state[0] += a;
 	context->state[1] += b;
@@ -5,10 +5,14 @@
  */
 #include "sound.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <SDL.h>
 
@@ -17,7 +21,10 @@
 #include "options.h"
 #include "utils/log.hpp"
 #include "utils/math.h"
+#include "utils/sdl_cond.h"
 #include "utils/sdl_mutex.h"
+#include "utils/sdl_thread.h"
+#include "utils/spsc_queue.hpp"
 #include "utils/stdcompat/algorithm.hpp"
 #include "utils/stdcompat/optional.hpp"
 #include "utils/stdcompat/shared_ptr_array.hpp"
@@ -45,7 +52,42 @@ std::string GetMp3Path(const char *path)
 	return mp3Path;
 }
 
-bool LoadAudioFile(const char *path, bool stream, bool errorDialog, SoundSample &result)
+#ifndef STREAM_ALL_AUDIO
+struct AudioFileData {
+	ArraySharedPtr<std::uint8_t> data;
+	std::size_t size = 0;
+	bool isMp3 = false;
+};
+
+/**
+ * @brief Reads a whole sound file into memory, preferring the MP3 version of it.
+ * @return nullptr on success, otherwise a description of what failed
+ */
+const char *ReadAudioFile(const char *path, bool threadsafe, AudioFileData &result)
+{
+	result.isMp3 = true;
+	SDL_RWops *file = OpenAsset(GetMp3Path(path).c_str(), threadsafe);
+	if (file == nullptr) {
+		SDL_ClearError();
+		result.isMp3 = false;
+		file = OpenAsset(path, threadsafe);
+		if (file == nullptr)
+			return "OpenAsset failed";
+	}
+	result.size = SDL_RWsize(file);
+	result.data = MakeArraySharedPtr<std::uint8_t>(result.size);
+	const bool read = SDL_RWread(file, result.data.get(), result.size, 1) != 0;
+	SDL_RWclose(file);
+	if (!read)
+		return "Failed to read file";
+	return nullptr;
+}
+#endif
+
+/**
+ * @param decode Also decode the file to PCM for overlapping plays, ignored when streaming
+ */
+bool LoadAudioFile(const char *path, bool stream, [[maybe_unused]] bool decode, bool errorDialog, SoundSample &result)
 {
 #ifndef STREAM_ALL_AUDIO
 	if (stream) {
@@ -60,28 +102,17 @@ bool LoadAudioFile(const char *path, bool stream, bool errorDialog, SoundSample
 		}
 #ifndef STREAM_ALL_AUDIO
 	} else {
-		bool isMp3 = true;
-		SDL_RWops *file = OpenAsset(GetMp3Path(path).c_str());
-		if (file == nullptr) {
-			SDL_ClearError();
-			isMp3 = false;
-			file = OpenAsset(path);
-			if (file == nullptr) {
-				if (errorDialog)
-					ErrDlg("OpenAsset failed", path, __FILE__, __LINE__);
-				return false;
-			}
-		}
-		size_t dwBytes = SDL_RWsize(file);
-		auto waveFile = MakeArraySharedPtr<std::uint8_t>(dwBytes);
-		if (SDL_RWread(file, waveFile.get(), dwBytes, 1) == 0) {
+		AudioFileData file;
+		const char *readError = ReadAudioFile(path, /*threadsafe=*/false, file);
+		if (readError != nullptr) {
 			if (errorDialog)
-				ErrDlg("Failed to read file", fmt::format("{}: {}", path, SDL_GetError()), __FILE__, __LINE__);
+				ErrDlg(readError, fmt::format("{}: {}", path, SDL_GetError()), __FILE__, __LINE__);
 			return false;
 		}
-		int error = result.SetChunk(waveFile, dwBytes, isMp3);
-		SDL_RWclose(file);
-		if (error != 0) {
+		std::shared_ptr<const DecodedSound> decoded;
+		if (decode)
+			decoded = DecodeSound(file.data.get(), file.size, file.isMp3);
+		if (result.SetChunk(std::move(file.data), file.size, file.isMp3, std::move(decoded)) != 0) {
 			if (errorDialog)
 				ErrSdl();
 			return false;
@@ -114,6 +145,211 @@ SoundSample *DuplicateSound(const SoundSample &sound)
 	return result;
 }
 
+#ifndef STREAM_ALL_AUDIO
+/** More overlapping sounds than this are rare, further plays fall back to duplicating the sample. */
+constexpr size_t MaxVoices = 32;
+
+/** Play overlapping sounds that are kept in memory, only touched from the main thread. */
+std::vector<std::unique_ptr<SoundVoice>> voices;
+
+SoundVoice *GetIdleVoice(const DecodedSound &sound)
+{
+	for (auto &voice : voices) {
+		if (!voice->IsPlaying() && voice->CanPlay(sound))
+			return voice.get();
+	}
+	if (voices.size() < MaxVoices) {
+		voices.push_back(std::make_unique<SoundVoice>());
+		return voices.back().get();
+	}
+	// Set up a voice that was used for a different sample rate again
+	for (auto &voice : voices) {
+		if (!voice->IsPlaying()) {
+			voice = std::make_unique<SoundVoice>();
+			return voice.get();
+		}
+	}
+	return nullptr;
+}
+
+struct SoundLoadRequest {
+	uint32_t id = 0;
+	std::string path;
+};
+
+struct SoundLoadResult {
+	uint32_t id = 0;
+	bool ok = false;
+	AudioFileData file;
+	std::shared_ptr<const DecodedSound> decoded;
+};
+
+/** A sound waiting for the loader thread, with the play that came in meanwhile if any. */
+struct PendingLoad {
+	TSnd *snd;
+	bool play = false;
+	uint32_t playRequestedAt = 0;
+	int volume = 0;
+	int pan = 0;
+};
+
+/** Enough for the sounds of every monster type on a level plus a few sound effects. */
+constexpr size_t MaxQueuedLoads = 256;
+/** A deferred play that would start later than this is dropped, it would be out of sync with the game. */
+constexpr uint32_t MaxPlayDelay = 100;
+
+SpscQueue<SoundLoadRequest, MaxQueuedLoads> LoadRequests;
+SpscQueue<SoundLoadResult, MaxQueuedLoads> LoadResults;
+std::atomic<bool> LoaderRunning;
+/** Set while the loader thread is about to sleep, so the main thread only takes the mutex when needed. */
+std::atomic<bool> LoaderWaiting;
+std::optional<SdlMutex> LoaderMutex;
+std::optional<SdlCond> LoadRequested;
+SdlThread LoaderThread;
+
+/** The following are only touched from the main thread. */
+std::unordered_map<uint32_t, PendingLoad> PendingLoads;
+uint32_t NextLoadId = 1;
+std::vector<TSnd *> ResidentSounds;
+
+void WakeSoundLoader()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!LoaderWaiting.load(std::memory_order_relaxed))
+		return;
+
+	std::lock_guard<SdlMutex> lock(*LoaderMutex);
+	LoadRequested->signal();
+}
+
+void SoundLoaderHandler()
+{
+	while (true) {
+		SoundLoadRequest request;
+		while (LoadRequests.try_pop(request)) {
+			SoundLoadResult result;
+			result.id = request.id;
+			result.ok = ReadAudioFile(request.path.c_str(), /*threadsafe=*/true, result.file) == nullptr;
+			if (result.ok)
+				result.decoded = DecodeSound(result.file.data.get(), result.file.size, result.file.isMp3);
+			while (!LoadResults.try_push(result)) {
+				// The main thread hasn't picked up the earlier results yet
+				if (!LoaderRunning)
+					return;
+				SDL_Delay(1);
+			}
+		}
+
+		std::lock_guard<SdlMutex> lock(*LoaderMutex);
+		if (!LoaderRunning)
+			return;
+		LoaderWaiting.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (LoadRequests.empty())
+			LoadRequested->wait(*LoaderMutex);
+		LoaderWaiting.store(false, std::memory_order_relaxed);
+	}
+}
+
+void StartSoundLoader()
+{
+	LoaderRunning = true;
+	LoaderWaiting = false;
+	LoaderMutex.emplace();
+	LoadRequested.emplace();
+	LoaderThread = SdlThread { SoundLoaderHandler };
+}
+
+void StopSoundLoader()
+{
+	if (!LoaderRunning)
+		return;
+
+	{
+		std::lock_guard<SdlMutex> lock(*LoaderMutex);
+		LoaderRunning = false;
+		LoadRequested->signal();
+	}
+	LoaderThread.join();
+
+	SoundLoadRequest request;
+	while (LoadRequests.try_pop(request)) {
+	}
+	SoundLoadResult result;
+	while (LoadResults.try_pop(result)) {
+	}
+
+	// The sounds stay around, they are queued again on their next play
+	for (auto &pending : PendingLoads)
+		pending.second.snd->loadId = 0;
+	PendingLoads.clear();
+	for (TSnd *snd : ResidentSounds)
+		snd->resident = false;
+	ResidentSounds.clear();
+}
+
+/**
+ * @brief Queues the sound for the loader thread unless it is already queued.
+ * @return The pending load, nullptr if the sound can't be loaded right now
+ */
+PendingLoad *QueueLoad(TSnd &snd)
+{
+	if (snd.loadId != 0)
+		return &PendingLoads.at(snd.loadId);
+	if (!LoaderRunning || snd.path.empty())
+		return nullptr;
+
+	SoundLoadRequest request { NextLoadId, snd.path };
+	if (!LoadRequests.try_push(request))
+		return nullptr; // Tried again on the next play
+	snd.loadId = NextLoadId;
+	NextLoadId = NextLoadId == UINT32_MAX ? 1 : NextLoadId + 1;
+	WakeSoundLoader();
+
+	PendingLoad &pending = PendingLoads[snd.loadId];
+	pending.snd = &snd;
+	return &pending;
+}
+
+void MakeResident(TSnd &snd)
+{
+	snd.lastUsed = SDL_GetTicks();
+	if (snd.resident || !LoaderRunning)
+		return;
+	snd.resident = true;
+	ResidentSounds.push_back(&snd);
+}
+
+void EvictSounds()
+{
+	const std::size_t budget = static_cast<std::size_t>(*sgOptions.Audio.sfxMemoryBudget) * 1024 * 1024;
+	if (budget == 0)
+		return;
+
+	std::size_t total = 0;
+	for (TSnd *snd : ResidentSounds)
+		total += snd->DSB.GetMemorySize();
+	if (total <= budget)
+		return;
+
+	std::sort(ResidentSounds.begin(), ResidentSounds.end(), [](const TSnd *a, const TSnd *b) {
+		return a->lastUsed < b->lastUsed;
+	});
+	auto kept = ResidentSounds.begin();
+	for (TSnd *snd : ResidentSounds) {
+		// Voices keep their own reference to the decoded samples, only the sample itself has to be idle
+		if (total <= budget || snd->DSB.IsPlaying()) {
+			*kept++ = snd;
+			continue;
+		}
+		total -= snd->DSB.GetMemorySize();
+		snd->DSB.Release();
+		snd->resident = false;
+	}
+	ResidentSounds.erase(kept, ResidentSounds.end());
+}
+#endif
+
 /** Maps from track ID to track name in spawn. */
 const char *const SpawnMusicTracks[NUM_MUSIC] = {
 	"Music\\sTowne.wav",
@@ -146,6 +382,12 @@ int CapVolume(int volume)
 
 void ClearDuplicateSounds()
 {
+#ifndef STREAM_ALL_AUDIO
+	for (auto &voice : voices) {
+		voice->Stop();
+	}
+	voices.clear();
+#endif
 	const std::lock_guard<SdlMutex> lock(*duplicateSoundsMutex);
 	duplicateSounds.clear();
 }
@@ -161,8 +403,33 @@ void snd_play_snd(TSnd *pSnd, int lVolume, int lPan)
 		return;
 	}
 
+#ifndef STREAM_ALL_AUDIO
+	if (!pSnd->DSB.IsLoaded()) {
+		// Still loading or evicted, play it as soon as the loader thread is done with it
+		PendingLoad *pending = QueueLoad(*pSnd);
+		if (pending != nullptr) {
+			pending->play = true;
+			pending->playRequestedAt = tc;
+			pending->volume = lVolume;
+			pending->pan = lPan;
+		}
+		return;
+	}
+	pSnd->lastUsed = tc;
+#endif
+
 	SoundSample *sound = &pSnd->DSB;
 	if (sound->IsPlaying()) {
+#ifndef STREAM_ALL_AUDIO
+		const std::shared_ptr<const DecodedSound> &decoded = sound->GetDecoded();
+		SoundVoice *voice = decoded != nullptr ? GetIdleVoice(*decoded) : nullptr;
+		if (voice != nullptr) {
+			if (voice->Play(decoded, lVolume, *sgOptions.Audio.soundVolume, lPan))
+				pSnd->start_tc = tc;
+			return;
+		}
+		// Every voice is busy, take the slow path rather than dropping the sound
+#endif
 		sound = DuplicateSound(*sound);
 		if (sound == nullptr)
 			return;
@@ -176,14 +443,70 @@ std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream)
 {
 	auto snd = std::make_unique<TSnd>();
 	snd->start_tc = SDL_GetTicks() - 80 - 1;
-#ifndef NOSOUND
-	LoadAudioFile(path, stream, /*errorDialog=*/true, snd->DSB);
+#ifdef STREAM_ALL_AUDIO
+	LoadAudioFile(path, stream, /*decode=*/false, /*errorDialog=*/true, snd->DSB);
+#else
+	if (LoadAudioFile(path, stream, /*decode=*/true, /*errorDialog=*/true, snd->DSB) && !stream) {
+		snd->path = path;
+		MakeResident(*snd);
+		EvictSounds();
+	}
 #endif
 	return snd;
 }
 
+std::unique_ptr<TSnd> sound_file_load_async(const char *path)
+{
+#ifdef STREAM_ALL_AUDIO
+	return sound_file_load(path);
+#else
+	auto snd = std::make_unique<TSnd>();
+	snd->start_tc = SDL_GetTicks() - 80 - 1;
+	snd->path = path;
+	QueueLoad(*snd);
+	return snd;
+#endif
+}
+
+void sound_process_loads()
+{
+#ifndef STREAM_ALL_AUDIO
+	bool loaded = false;
+	SoundLoadResult result;
+	while (LoadResults.try_pop(result)) {
+		auto it = PendingLoads.find(result.id);
+		if (it == PendingLoads.end())
+			continue; // The sound was freed in the meantime
+		const PendingLoad pending = it->second;
+		PendingLoads.erase(it);
+
+		TSnd &snd = *pending.snd;
+		snd.loadId = 0;
+		if (!result.ok || snd.DSB.SetChunk(std::move(result.file.data), result.file.size, result.file.isMp3, std::move(result.decoded)) != 0) {
+			LogError(LogCategory::Audio, "Failed to load sound {}", snd.path);
+			snd.path.clear(); // Don't try again on every play
+			continue;
+		}
+		MakeResident(snd);
+		loaded = true;
+
+		if (pending.play && SDL_GetTicks() - pending.playRequestedAt <= MaxPlayDelay)
+			snd_play_snd(&snd, pending.volume, pending.pan);
+	}
+
+	if (loaded)
+		EvictSounds();
+#endif
+}
+
 TSnd::~TSnd()
 {
+#ifndef STREAM_ALL_AUDIO
+	if (loadId != 0)
+		PendingLoads.erase(loadId);
+	if (resident)
+		ResidentSounds.erase(std::find(ResidentSounds.begin(), ResidentSounds.end(), this));
+#endif
 	if (DSB.IsLoaded())
 		DSB.Stop();
 	DSB.Release();
@@ -209,12 +532,19 @@ void snd_init()
 	    Aulib::sampleRate(), Aulib::channelCount(), Aulib::frameSize(), Aulib::sampleFormat());
 
 	duplicateSoundsMutex.emplace();
+#ifndef STREAM_ALL_AUDIO
+	StartSoundLoader();
+#endif
 	gbSndInited = true;
 }
 
 void snd_deinit()
 {
 	if (gbSndInited) {
+#ifndef STREAM_ALL_AUDIO
+		voices.clear();
+		StopSoundLoader();
+#endif
 		Aulib::quit();
 		duplicateSoundsMutex = std::nullopt;
 	}
@@ -246,7 +576,7 @@ void music_start(uint8_t nTrack)
 #else
 	const bool stream = true;
 #endif
-	if (!LoadAudioFile(trackPath, stream, /*errorDialog=*/false, music)) {
+	if (!LoadAudioFile(trackPath, stream, /*decode=*/false, /*errorDialog=*/false, music)) {
 		music_stop();
 		return;
 	}
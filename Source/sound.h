@@ -34,6 +34,16 @@ struct TSnd {
 
 #ifndef NOSOUND
 	SoundSample DSB;
+#ifndef STREAM_ALL_AUDIO
+	/** Asset path, kept so that an evicted sample can be loaded again. */
+	std::string path;
+	/** Non-zero while the loader thread is reading the sample. */
+	uint32_t loadId = 0;
+	/** Tick of the last play, the least recently used samples are evicted first. */
+	uint32_t lastUsed = 0;
+	/** Counted against the sound effect memory budget. */
+	bool resident = false;
+#endif
 
 	bool isPlaying()
 	{
@@ -56,6 +66,14 @@ void ClearDuplicateSounds();
 void snd_stop_snd(TSnd *pSnd);
 void snd_play_snd(TSnd *pSnd, int lVolume, int lPan);
 std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream = false);
+/**
+ * @brief Creates a sound whose data is read on the loader thread.
+ *
+ * Plays that come in before the data is ready are deferred until it is, or dropped if that takes too long.
+ */
+std::unique_ptr<TSnd> sound_file_load_async(const char *path);
+/** @brief Hands finished loads to their sounds and evicts the least recently used ones above the memory budget. */
+void sound_process_loads();
 void snd_init();
 void snd_deinit();
 void music_stop();
@@ -13,6 +13,8 @@ bool gbSoundOn;
 void ClearDuplicateSounds() { }
 void snd_play_snd(TSnd *pSnd, int lVolume, int lPan) { }
 std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream) { return nullptr; }
+std::unique_ptr<TSnd> sound_file_load_async(const char *path) { return nullptr; }
+void sound_process_loads() { }
 TSnd::~TSnd()
 {
 }
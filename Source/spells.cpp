@@ -290,6 +290,7 @@ void DoResurrect(int pnum, uint16_t rid)
 	target._pMana = 0;
 	target._pManaBase = target._pMana + (target._pMaxManaBase - target._pMaxMana);
 
+	target.MarkStatsDirty(PlayerStatsDirty::Level);
 	CalcPlrInv(target, true);
 
 	if (target.plrlevel == currlevel) {
@@ -1383,6 +1383,7 @@ void SmithBuyItem(Item &item)
 		}
 		smithitem[idx].Clear();
 	}
+	MyPlayer->MarkStatsDirty(PlayerStatsDirty::Inventory);
 	CalcPlrInv(*MyPlayer, true);
 }
 
@@ -1639,6 +1640,7 @@ void WitchBuyItem(Item &item)
 		}
 	}
 
+	MyPlayer->MarkStatsDirty(PlayerStatsDirty::Inventory);
 	CalcPlrInv(*MyPlayer, true);
 }
 
@@ -1711,6 +1713,7 @@ void WitchRechargeItem(int price)
 	else
 		myPlayer.InvList[i]._iCharges = myPlayer.InvList[i]._iMaxCharges;
 
+	myPlayer.MarkStatsDirty(PlayerStatsDirty::Equipment | PlayerStatsDirty::Inventory);
 	CalcPlrInv(myPlayer, true);
 }
 
@@ -1771,6 +1774,7 @@ void BoyBuyItem(Item &item)
 	StoreAutoPlace(item, true);
 	boyitem.Clear();
 	stextshold = STORE_BOY;
+	MyPlayer->MarkStatsDirty(PlayerStatsDirty::Inventory);
 	CalcPlrInv(*MyPlayer, true);
 	stextlhold = 12;
 }
@@ -1810,6 +1814,7 @@ void HealerBuyItem(Item &item)
 		}
 		healitem[idx].Clear();
 	}
+	MyPlayer->MarkStatsDirty(PlayerStatsDirty::Inventory);
 	CalcPlrInv(*MyPlayer, true);
 }
 
@@ -1869,6 +1874,7 @@ void StorytellerIdentifyItem(Item &item)
 	}
 	item._iIdentified = true;
 	TakePlrsMoney(item._iIvalue);
+	myPlayer.MarkStatsDirty(PlayerStatsDirty::Equipment | PlayerStatsDirty::Inventory);
 	CalcPlrInv(myPlayer, true);
 }
 
@@ -223,6 +223,14 @@ bool SNetGetTurnsInTransit(uint32_t *turns)
 	return dvlnet_inst->SNetGetTurnsInTransit(turns);
 }
 
+bool SNetGetLatency(uint32_t *latency, uint32_t *jitter)
+{
+#ifndef NONET
+	std::lock_guard<SdlMutex> lg(storm_net_mutex);
+#endif
+	return dvlnet_inst->SNetGetLatency(latency, jitter);
+}
+
 /**
  * @brief engine calls this only once with argument 1
  */
@@ -99,6 +99,15 @@ bool SNetGetGameInfo(game_info type, void *dst, unsigned int length);
  */
 bool SNetGetTurnsInTransit(uint32_t *turns);
 
+/**
+ * @brief Retrieves the round trip latency to the slowest connected player.
+ *
+ * @param latency Receives the smoothed round trip latency in milliseconds.
+ * @param jitter Receives the mean deviation of the round trip latency in milliseconds.
+ * @return false if the provider has no latency measurement available.
+ */
+bool SNetGetLatency(uint32_t *latency, uint32_t *jitter);
+
 bool SNetJoinGame(char *gameName, char *gamePassword, int *playerid);
 
 /*  SNetLeaveGame @ 119
@@ -24,6 +24,7 @@
 #endif
 
 #if _POSIX_C_SOURCE >= 200112L || defined(_BSD_SOURCE) || defined(__APPLE__)
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #endif
@@ -111,6 +112,36 @@ bool GetFileSize(const char *path, std::uintmax_t *size)
 #endif
 }
 
+bool GetFileModificationTime(const char *path, std::int64_t *time)
+{
+#if defined(_WIN64) || defined(_WIN32)
+	const auto pathUtf16 = ToWideChar(path);
+	if (pathUtf16 == nullptr) {
+		LogError("UTF-8 -> UTF-16 conversion error code {}", ::GetLastError());
+		return false;
+	}
+	WIN32_FILE_ATTRIBUTE_DATA attr;
+	if (!GetFileAttributesExW(&pathUtf16[0], GetFileExInfoStandard, &attr)) {
+		return false;
+	}
+	*time = static_cast<std::int64_t>(static_cast<std::uint64_t>(attr.ftLastWriteTime.dwHighDateTime) << 32 | attr.ftLastWriteTime.dwLowDateTime);
+	return true;
+#else
+	struct ::stat statResult;
+	if (::stat(path, &statResult) == -1)
+		return false;
+	// Whole seconds can't tell apart two saves of the same size written in quick succession
+#if defined(__APPLE__)
+	*time = static_cast<std::int64_t>(statResult.st_mtimespec.tv_sec) * 1000000000 + statResult.st_mtimespec.tv_nsec;
+#elif _POSIX_C_SOURCE >= 200809L
+	*time = static_cast<std::int64_t>(statResult.st_mtim.tv_sec) * 1000000000 + statResult.st_mtim.tv_nsec;
+#else
+	*time = static_cast<std::int64_t>(statResult.st_mtime) * 1000000000;
+#endif
+	return true;
+#endif
+}
+
 bool ResizeFile(const char *path, std::uintmax_t size)
 {
 #if defined(_WIN64) || defined(_WIN32)
@@ -164,6 +195,103 @@ void RemoveFile(string_view lpFileName)
 #endif
 }
 
+bool CopyFileOverwrite(const char *from, const char *to)
+{
+#if defined(_WIN64) || defined(_WIN32)
+	const auto fromUtf16 = ToWideChar(from);
+	const auto toUtf16 = ToWideChar(to);
+	if (fromUtf16 == nullptr || toUtf16 == nullptr) {
+		LogError("UTF-8 -> UTF-16 conversion error code {}", ::GetLastError());
+		return false;
+	}
+	return ::CopyFileW(&fromUtf16[0], &toUtf16[0], /*bFailIfExists=*/FALSE) != 0;
+#else
+	FILE *input = FOpen(from, "rb");
+	if (input == nullptr)
+		return false;
+	FILE *output = FOpen(to, "wb");
+	if (output == nullptr) {
+		std::fclose(input);
+		return false;
+	}
+
+	bool result = true;
+	char buffer[4096];
+	size_t read;
+	while ((read = std::fread(buffer, 1, sizeof(buffer), input)) != 0) {
+		if (std::fwrite(buffer, 1, read, output) != read) {
+			result = false;
+			break;
+		}
+	}
+	if (std::ferror(input) != 0)
+		result = false;
+	std::fclose(input);
+	if (std::fclose(output) != 0)
+		result = false;
+	return result;
+#endif
+}
+
+bool RenameFile(const char *from, const char *to)
+{
+#if defined(_WIN64) || defined(_WIN32)
+	const auto fromUtf16 = ToWideChar(from);
+	const auto toUtf16 = ToWideChar(to);
+	if (fromUtf16 == nullptr || toUtf16 == nullptr) {
+		LogError("UTF-8 -> UTF-16 conversion error code {}", ::GetLastError());
+		return false;
+	}
+	return ::MoveFileExW(&fromUtf16[0], &toUtf16[0], MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return std::rename(from, to) == 0;
+#endif
+}
+
+bool SyncFile(const char *path)
+{
+#if defined(_WIN64) || defined(_WIN32)
+	const auto pathUtf16 = ToWideChar(path);
+	if (pathUtf16 == nullptr) {
+		LogError("UTF-8 -> UTF-16 conversion error code {}", ::GetLastError());
+		return false;
+	}
+	HANDLE file = ::CreateFileW(&pathUtf16[0], GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	const bool result = ::FlushFileBuffers(file) != 0;
+	::CloseHandle(file);
+	return result;
+#elif _POSIX_C_SOURCE >= 200112L || defined(_BSD_SOURCE) || defined(__APPLE__)
+	const int file = ::open(path, O_WRONLY);
+	if (file == -1)
+		return false;
+	const bool result = ::fsync(file) == 0;
+	return ::close(file) == 0 && result;
+#else
+	return true;
+#endif
+}
+
+void SyncFileDirectory(const char *path)
+{
+#if !defined(_WIN64) && !defined(_WIN32) && (_POSIX_C_SOURCE >= 200112L || defined(_BSD_SOURCE) || defined(__APPLE__))
+	// MoveFileEx already writes the rename through on Windows
+	std::string directory = path;
+	const size_t separator = directory.find_last_of('/');
+	if (separator == std::string::npos)
+		directory = ".";
+	else
+		directory.resize(std::max<size_t>(separator, 1));
+	const int file = ::open(directory.c_str(), O_RDONLY);
+	if (file == -1)
+		return;
+	// Not every file system supports syncing directories, the rename has happened either way
+	::fsync(file);
+	::close(file);
+#endif
+}
+
 std::optional<std::fstream> CreateFileStream(const char *path, std::ios::openmode mode)
 {
 #if defined(_WIN64) || defined(_WIN32)
@@ -13,8 +13,20 @@ namespace devilution {
 bool FileExists(const char *path);
 bool FileExistsAndIsWriteable(const char *path);
 bool GetFileSize(const char *path, std::uintmax_t *size);
+/**
+ * @brief Last write time of the file, with sub-second precision where the platform provides it.
+ * Only meant to be compared to other values returned by this function.
+ */
+bool GetFileModificationTime(const char *path, std::int64_t *time);
 bool ResizeFile(const char *path, std::uintmax_t size);
 void RemoveFile(string_view lpFileName);
+bool CopyFileOverwrite(const char *from, const char *to);
+/** @brief Renames a file, atomically replacing the destination if it exists. */
+bool RenameFile(const char *from, const char *to);
+/** @brief Writes the contents of a closed file through to the storage device. */
+bool SyncFile(const char *path);
+/** @brief Writes the directory entry of a file through to the storage device, so that a rename survives a power loss. */
+void SyncFileDirectory(const char *path);
 std::optional<std::fstream> CreateFileStream(const char *path, std::ios::openmode mode);
 FILE *FOpen(const char *path, const char *mode);
 
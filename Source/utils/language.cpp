@@ -1,8 +1,10 @@
 #include "utils/language.h"
 
+#include <cstring>
+#include <deque>
 #include <functional>
-#include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "engine/assets.hpp"
@@ -10,6 +12,8 @@
 #include "utils/file_util.h"
 #include "utils/log.hpp"
 #include "utils/paths.h"
+#include "utils/perfect_hash.hpp"
+#include "utils/stdcompat/optional.hpp"
 #include "utils/stdcompat/string_view.hpp"
 
 using namespace devilution;
@@ -24,7 +28,44 @@ struct CStringCmp {
 	}
 };
 
-std::vector<std::map<std::string, std::string, std::less<>>> translation = { {}, {} };
+/** The whole translation file, the index and translationTexts point into it. */
+std::unique_ptr<char[]> translationData;
+/** Source strings of the translation, msgctxt "\004" msgid for strings with a context. */
+PerfectHashIndex translationIndex;
+/** The translations as stored in the file, plural forms separated by '\0'. */
+std::vector<string_view> translationTexts;
+/** The plural forms of each translation, split and copied on first use. */
+std::vector<std::vector<std::string>> translationForms;
+
+/** A string without a translation, handed out as is. */
+struct Untranslated {
+	std::string key;
+	std::string text;
+	/** 1 for the plural used in place of a missing plural form, 0 otherwise. */
+	int form;
+};
+
+/** Callers keep references to the strings, so they must never move. */
+std::deque<Untranslated> untranslated;
+std::unordered_multimap<uint64_t, const Untranslated *> untranslatedIndex;
+
+const std::string &GetUntranslated(std::initializer_list<string_view> key, string_view text, int form)
+{
+	const uint64_t hash = HashString(key);
+	auto range = untranslatedIndex.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Untranslated &entry = *it->second;
+		if (entry.form == form && EqualsConcatenation(entry.key, key))
+			return entry.text;
+	}
+
+	Untranslated entry { {}, std::string(text), form };
+	for (string_view part : key)
+		entry.key.append(part.data(), part.size());
+	untranslated.push_back(std::move(entry));
+	untranslatedIndex.emplace(hash, &untranslated.back());
+	return untranslated.back().text;
+}
 
 struct MoHead {
 	uint32_t magic;
@@ -243,56 +284,91 @@ void ParseMetadata(char *ptr)
 	}
 }
 
-bool ReadEntry(SDL_RWops *rw, MoEntry *e, std::vector<char> &result)
+/**
+ * @brief Returns the string of a MO entry, checking that it is within the file.
+ */
+std::optional<string_view> GetEntry(string_view file, uint32_t tableOffset, uint32_t index)
 {
-	if (SDL_RWseek(rw, e->offset, RW_SEEK_SET) == -1)
-		return false;
-	result.resize(e->length + 1);
-	result.back() = '\0';
-	return static_cast<uint32_t>(SDL_RWread(rw, result.data(), sizeof(char), e->length)) == e->length;
+	MoEntry entry;
+	memcpy(&entry, file.data() + tableOffset + static_cast<size_t>(index) * sizeof(MoEntry), sizeof(entry));
+	SwapLE(entry);
+	if (entry.offset > file.size() || entry.length > file.size() - entry.offset)
+		return std::nullopt;
+	return file.substr(entry.offset, entry.length);
 }
 
-} // namespace
+/** @brief The text up to the first '\0'. */
+string_view CString(string_view str)
+{
+	return str.substr(0, str.find('\0'));
+}
 
-const std::string &LanguageParticularTranslate(const char *context, const char *message)
+void SplitPluralForms(string_view text, std::vector<std::string> &forms)
 {
-	constexpr const char *glue = "\004";
+	const size_t firstLength = CString(text).size();
+	size_t offset = 0;
+	for (int j = 0; j < PluralForms; j++) {
+		const string_view form = CString(text.substr(std::min(offset, text.size())));
+		forms.emplace_back(form);
 
-	std::string key = context;
-	key += glue;
-	key += message;
+		if (text.size() <= offset + firstLength)
+			break;
 
-	auto it = translation[0].find(key);
-	if (it == translation[0].end()) {
-		it = translation[0].insert({ key, message }).first;
+		offset += form.size() + 1;
 	}
+}
 
-	return it->second;
+/** @return The translated plural form of the key, nullptr if there is none. */
+const std::string *FindTranslation(std::initializer_list<string_view> key, int form)
+{
+	const int index = translationIndex.Find(key);
+	if (index == -1)
+		return nullptr;
+	std::vector<std::string> &forms = translationForms[index];
+	if (forms.empty())
+		SplitPluralForms(translationTexts[index], forms);
+	if (static_cast<size_t>(form) >= forms.size())
+		return nullptr;
+	return &forms[form];
+}
+
+} // namespace
+
+const std::string &LanguageParticularTranslate(const char *context, const char *message)
+{
+	constexpr string_view glue = "\004";
+
+	const std::string *translated = FindTranslation({ context, glue, message }, 0);
+	if (translated != nullptr)
+		return *translated;
+
+	return GetUntranslated({ context, glue, message }, message, 0);
 }
 
 const std::string &LanguagePluralTranslate(const char *singular, const char *plural, int count)
 {
 	int n = GetLocalPluralId(count);
 
-	auto it = translation[n].find(singular);
-	if (it == translation[n].end()) {
-		if (count != 1)
-			it = translation[1].insert({ singular, plural }).first;
-		else
-			it = translation[0].insert({ singular, singular }).first;
-	}
+	const std::string *translated = FindTranslation({ singular }, n);
+	if (translated != nullptr)
+		return *translated;
 
-	return it->second;
+	// Fall back to the first or second form, like English
+	const int form = count != 1 ? 1 : 0;
+	translated = FindTranslation({ singular }, form);
+	if (translated != nullptr)
+		return *translated;
+
+	return GetUntranslated({ singular }, count != 1 ? plural : singular, form);
 }
 
 const std::string &LanguageTranslate(const char *key)
 {
-	auto it = translation[0].find(key);
-	if (it == translation[0].end()) {
-		it = translation[0].insert({ key, key }).first;
-	}
+	const std::string *translated = FindTranslation({ key }, 0);
+	if (translated != nullptr)
+		return *translated;
 
-	return it->second;
+	return GetUntranslated({ key }, key, 0);
 }
 
 bool HasTranslation(const std::string &locale)
@@ -322,7 +398,12 @@ bool IsSmallFontTall()
 
 void LanguageInitialize()
 {
-	translation = { {}, {} };
+	translationIndex.Build({});
+	translationTexts.clear();
+	translationForms.clear();
+	translationData = nullptr;
+	untranslated.clear();
+	untranslatedIndex.clear();
 
 	const std::string lang(*sgOptions.Language.code);
 	SDL_RWops *rw;
@@ -339,85 +420,60 @@ void LanguageInitialize()
 		return;
 	}
 
-	// Read header and do sanity checks
-	MoHead head;
-	if (SDL_RWread(rw, &head, sizeof(MoHead), 1) != 1) {
+	// Read the whole file at once, the strings are used from this buffer
+	const Sint64 fileSize = SDL_RWsize(rw);
+	if (fileSize < static_cast<Sint64>(sizeof(MoHead))) {
 		SDL_RWclose(rw);
 		return;
 	}
+	const size_t size = static_cast<size_t>(fileSize);
+	std::unique_ptr<char[]> data { new char[size] };
+	const bool read = SDL_RWread(rw, data.get(), size, 1) == 1;
+	SDL_RWclose(rw);
+	if (!read)
+		return;
+	const string_view file { data.get(), size };
+
+	// Sanity checks
+	MoHead head;
+	memcpy(&head, data.get(), sizeof(MoHead));
 	SwapLE(head);
 
-	if (head.magic != MO_MAGIC) {
-		SDL_RWclose(rw);
+	if (head.magic != MO_MAGIC)
 		return; // not a MO file
-	}
 
-	if (head.revision.major > 1 || head.revision.minor > 1) {
-		SDL_RWclose(rw);
+	if (head.revision.major > 1 || head.revision.minor > 1)
 		return; // unsupported revision
-	}
-
-	// Read entries of source strings
-	std::unique_ptr<MoEntry[]> src { new MoEntry[head.nbMappings] };
-	if (SDL_RWseek(rw, head.srcOffset, RW_SEEK_SET) == -1) {
-		SDL_RWclose(rw);
-		return;
-	}
-	// FIXME: Endianness.
-	if (static_cast<uint32_t>(SDL_RWread(rw, src.get(), sizeof(MoEntry), head.nbMappings)) != head.nbMappings) {
-		SDL_RWclose(rw);
-		return;
-	}
 
-	// Read entries of target strings
-	std::unique_ptr<MoEntry[]> dst { new MoEntry[head.nbMappings] };
-	if (SDL_RWseek(rw, head.dstOffset, RW_SEEK_SET) == -1) {
-		SDL_RWclose(rw);
+	const size_t tableSize = static_cast<size_t>(head.nbMappings) * sizeof(MoEntry);
+	if (head.nbMappings == 0 || head.srcOffset > size || tableSize > size - head.srcOffset || head.dstOffset > size || tableSize > size - head.dstOffset)
 		return;
-	}
-	if (static_cast<uint32_t>(SDL_RWread(rw, dst.get(), sizeof(MoEntry), head.nbMappings)) != head.nbMappings) {
-		SDL_RWclose(rw);
-		return;
-	}
-	for (size_t i = 0; i < head.nbMappings; ++i) {
-		SwapLE(dst[i]);
-	}
-
-	std::vector<char> key;
-	std::vector<char> value;
-
 	// MO header
-	if (!ReadEntry(rw, &src[0], key) || !ReadEntry(rw, &dst[0], value)) {
-		SDL_RWclose(rw);
+	const std::optional<string_view> metaKey = GetEntry(file, head.srcOffset, 0);
+	const std::optional<string_view> metaValue = GetEntry(file, head.dstOffset, 0);
+	if (!metaKey || !metaValue || !CString(*metaKey).empty())
 		return;
-	}
 
-	if (key[0] != '\0') {
-		SDL_RWclose(rw);
-		return;
-	}
+	// ParseMetadata cuts the text into pieces, give it a copy
+	std::string metadata(CString(*metaValue));
+	ParseMetadata(&metadata[0]);
 
-	ParseMetadata(value.data());
+	std::vector<string_view> keys;
+	keys.reserve(head.nbMappings - 1);
+	translationTexts.reserve(head.nbMappings - 1);
 
-	translation.resize(PluralForms);
-	for (int i = 0; i < PluralForms; i++)
-		translation[i] = {};
-
-	// Read strings described by entries
+	// Index the strings described by entries
 	for (uint32_t i = 1; i < head.nbMappings; i++) {
-		if (ReadEntry(rw, &src[i], key) && ReadEntry(rw, &dst[i], value)) {
-			size_t offset = 0;
-			for (int j = 0; j < PluralForms; j++) {
-				const char *text = value.data() + offset;
-				translation[j].emplace(key.data(), text);
-
-				if (dst[i].length <= offset + strlen(value.data()))
-					break;
-
-				offset += strlen(text) + 1;
-			}
+		const std::optional<string_view> key = GetEntry(file, head.srcOffset, i);
+		const std::optional<string_view> text = GetEntry(file, head.dstOffset, i);
+		if (key && text) {
+			// The key of a plural entry also holds the plural, only the singular is looked up
+			keys.push_back(CString(*key));
+			translationTexts.push_back(*text);
 		}
 	}
 
-	SDL_RWclose(rw);
+	translationIndex.Build(std::move(keys));
+	translationForms.resize(translationTexts.size());
+	translationData = std::move(data);
 }
@@ -0,0 +1,216 @@
+/**
+ * @file lz_codec.cpp
+ *
+ * Implementation of a fast LZ77 block compressor (LZ4 block format).
+ */
+#include "utils/lz_codec.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "utils/endian.hpp"
+
+namespace devilution {
+
+namespace {
+
+constexpr size_t MinMatch = 4;
+/** The last bytes of a block are always stored as literals. */
+constexpr size_t LastLiterals = 5;
+/** A match may not start within this many bytes of the end of a block. */
+constexpr size_t MatchFindLimit = 12;
+constexpr size_t MaxOffset = 65535;
+constexpr unsigned HashLog = 12;
+constexpr uint8_t RunMask = 15;
+
+uint32_t Read32(const uint8_t *p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32 - HashLog);
+}
+
+size_t ExtraLengthBytes(size_t length)
+{
+	return length >= RunMask ? (length - RunMask) / 255 + 1 : 0;
+}
+
+uint8_t *WriteLength(uint8_t *op, size_t length)
+{
+	length -= RunMask;
+	while (length >= 255) {
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = static_cast<uint8_t>(length);
+	return op;
+}
+
+/**
+ * @brief Emits a literal run followed by a match, or only literals if matchLength is 0.
+ * @return The new output position, or nullptr if the sequence does not fit.
+ */
+uint8_t *WriteSequence(uint8_t *op, const uint8_t *opEnd, const uint8_t *literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+	const size_t encodedMatch = matchLength != 0 ? matchLength - MinMatch : 0;
+	size_t needed = 1 + ExtraLengthBytes(literalLength) + literalLength;
+	if (matchLength != 0)
+		needed += 2 + ExtraLengthBytes(encodedMatch);
+	if (needed > static_cast<size_t>(opEnd - op))
+		return nullptr;
+
+	uint8_t *token = op++;
+	if (literalLength >= RunMask) {
+		*token = RunMask << 4;
+		op = WriteLength(op, literalLength);
+	} else {
+		*token = static_cast<uint8_t>(literalLength << 4);
+	}
+	memcpy(op, literals, literalLength);
+	op += literalLength;
+
+	if (matchLength == 0)
+		return op;
+
+	*op++ = static_cast<uint8_t>(offset);
+	*op++ = static_cast<uint8_t>(offset >> 8);
+	if (encodedMatch >= RunMask) {
+		*token |= RunMask;
+		op = WriteLength(op, encodedMatch);
+	} else {
+		*token |= static_cast<uint8_t>(encodedMatch);
+	}
+	return op;
+}
+
+/** @return false if the length runs past the end of the input. */
+bool ReadLength(const uint8_t *&ip, const uint8_t *ipEnd, size_t &length)
+{
+	uint8_t s;
+	do {
+		if (ip >= ipEnd)
+			return false;
+		s = *ip++;
+		length += s;
+	} while (s == 255);
+	return true;
+}
+
+} // namespace
+
+size_t LzCompress(const byte *src, size_t size, byte *dst, size_t capacity)
+{
+	const auto *base = reinterpret_cast<const uint8_t *>(src);
+	const uint8_t *const end = base + size;
+	auto *op = reinterpret_cast<uint8_t *>(dst);
+	const uint8_t *const opEnd = op + capacity;
+
+	const uint8_t *ip = base;
+	const uint8_t *anchor = base;
+
+	if (size > MatchFindLimit) {
+		const uint8_t *const matchLimit = end - LastLiterals;
+		const uint8_t *const findLimit = end - MatchFindLimit;
+		std::array<uint32_t, 1U << HashLog> table {};
+
+		table[HashSequence(Read32(ip))] = 0;
+		ip++;
+		unsigned misses = 0;
+		while (ip <= findLimit) {
+			const uint32_t hash = HashSequence(Read32(ip));
+			const uint8_t *match = base + table[hash];
+			table[hash] = static_cast<uint32_t>(ip - base);
+
+			if (match >= ip || static_cast<size_t>(ip - match) > MaxOffset || Read32(match) != Read32(ip)) {
+				// Skip ahead faster through data that does not compress
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+
+			while (ip > anchor && match > base && ip[-1] == match[-1]) {
+				ip--;
+				match--;
+			}
+
+			size_t matchLength = MinMatch;
+			while (ip + matchLength < matchLimit && ip[matchLength] == match[matchLength])
+				matchLength++;
+
+			op = WriteSequence(op, opEnd, anchor, ip - anchor, ip - match, matchLength);
+			if (op == nullptr)
+				return 0;
+
+			ip += matchLength;
+			anchor = ip;
+			if (ip <= findLimit)
+				table[HashSequence(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+		}
+	}
+
+	op = WriteSequence(op, opEnd, anchor, end - anchor, 0, 0);
+	if (op == nullptr)
+		return 0;
+
+	return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+std::optional<size_t> LzDecompress(const byte *src, size_t size, byte *dst, size_t capacity)
+{
+	const auto *ip = reinterpret_cast<const uint8_t *>(src);
+	const uint8_t *const ipEnd = ip + size;
+	auto *const out = reinterpret_cast<uint8_t *>(dst);
+	uint8_t *op = out;
+	const uint8_t *const opEnd = out + capacity;
+
+	while (ip < ipEnd) {
+		const uint8_t token = *ip++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == RunMask && !ReadLength(ip, ipEnd, literalLength))
+			return std::nullopt;
+		if (literalLength > static_cast<size_t>(ipEnd - ip) || literalLength > static_cast<size_t>(opEnd - op))
+			return std::nullopt;
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// The last sequence consists of literals only
+		if (ip == ipEnd)
+			break;
+
+		if (ipEnd - ip < 2)
+			return std::nullopt;
+		const size_t offset = LoadLE16(ip);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<size_t>(op - out))
+			return std::nullopt;
+
+		size_t matchLength = token & RunMask;
+		if (matchLength == RunMask && !ReadLength(ip, ipEnd, matchLength))
+			return std::nullopt;
+		matchLength += MinMatch;
+		if (matchLength > static_cast<size_t>(opEnd - op))
+			return std::nullopt;
+
+		const uint8_t *match = op - offset;
+		if (offset >= matchLength) {
+			memcpy(op, match, matchLength);
+		} else {
+			// Overlapping copy, repeats the last offset bytes
+			for (size_t i = 0; i < matchLength; i++)
+				op[i] = match[i];
+		}
+		op += matchLength;
+	}
+
+	return static_cast<size_t>(op - out);
+}
+
+} // namespace devilution
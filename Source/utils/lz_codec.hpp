@@ -0,0 +1,48 @@
+/**
+ * @file lz_codec.hpp
+ *
+ * Interface of a fast LZ77 block compressor (LZ4 block format).
+ */
+#pragma once
+
+#include <cstddef>
+
+#include "utils/stdcompat/cstddef.hpp"
+#include "utils/stdcompat/optional.hpp"
+
+namespace devilution {
+
+/**
+ * @brief Returns the worst case compressed size for an input of the given size.
+ */
+constexpr size_t LzCompressBound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+/**
+ * @brief Compresses a block of data.
+ *
+ * Trades ratio for speed compared to PKWARE implode, and needs no work buffer beyond a small
+ * hash table on the stack.
+ *
+ * @param src Uncompressed data.
+ * @param size Size of the uncompressed data.
+ * @param dst Destination buffer, must not overlap with src.
+ * @param capacity Size of the destination buffer.
+ * @return Size of the compressed data, or 0 if it does not fit in capacity bytes.
+ */
+size_t LzCompress(const byte *src, size_t size, byte *dst, size_t capacity);
+
+/**
+ * @brief Decompresses a block of data produced by LzCompress.
+ *
+ * @param src Compressed data.
+ * @param size Size of the compressed data.
+ * @param dst Destination buffer, must not overlap with src.
+ * @param capacity Size of the destination buffer.
+ * @return Size of the decompressed data, or an empty optional if the input is malformed or does not fit.
+ */
+std::optional<size_t> LzDecompress(const byte *src, size_t size, byte *dst, size_t capacity);
+
+} // namespace devilution
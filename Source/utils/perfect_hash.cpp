@@ -0,0 +1,122 @@
+/**
+ * @file perfect_hash.cpp
+ *
+ * Implementation of an immutable string index with a minimal perfect hash.
+ */
+#include "utils/perfect_hash.hpp"
+
+#include <algorithm>
+
+#include "utils/log.hpp"
+
+namespace devilution {
+
+namespace {
+
+/** Average number of keys sharing a displacement, more is smaller but slower to build. */
+constexpr size_t KeysPerBucket = 4;
+/** Only reached for keys with the same 64-bit hash, which can't be told apart by displacing them. */
+constexpr uint32_t MaxDisplacement = 1 << 20;
+
+uint64_t Mix(uint64_t hash, uint32_t displacement)
+{
+	hash += displacement * 0x9e3779b97f4a7c15;
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+	return hash ^ (hash >> 31);
+}
+
+} // namespace
+
+bool EqualsConcatenation(string_view str, std::initializer_list<string_view> parts)
+{
+	for (string_view part : parts) {
+		if (str.substr(0, part.size()) != part)
+			return false;
+		str.remove_prefix(part.size());
+	}
+	return str.empty();
+}
+
+void PerfectHashIndex::Build(std::vector<string_view> keys)
+{
+	struct Key {
+		uint64_t hash;
+		int index;
+	};
+
+	std::vector<std::vector<Key>> buckets((keys.size() + KeysPerBucket - 1) / KeysPerBucket);
+	for (size_t i = 0; i < keys.size(); i++) {
+		const uint64_t hash = HashString(keys[i]);
+		std::vector<Key> &bucket = buckets[hash % buckets.size()];
+		const bool duplicate = std::any_of(bucket.begin(), bucket.end(), [&](const Key &key) {
+			return key.hash == hash && keys[key.index] == keys[i];
+		});
+		if (!duplicate)
+			bucket.push_back({ hash, static_cast<int>(i) });
+	}
+
+	size_t keyCount = 0;
+	for (const std::vector<Key> &bucket : buckets)
+		keyCount += bucket.size();
+
+	displacements_.assign(buckets.size(), 0);
+	slots_.assign(keyCount, {});
+
+	// Place the crowded buckets first while there is still room
+	std::vector<size_t> order(buckets.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	std::vector<size_t> candidate;
+	for (size_t bucketIndex : order) {
+		std::vector<Key> &bucket = buckets[bucketIndex];
+		if (bucket.empty())
+			break;
+
+		uint32_t displacement = 0;
+		while (true) {
+			candidate.clear();
+			for (const Key &key : bucket) {
+				const size_t slot = Mix(key.hash, displacement) % slots_.size();
+				if (slots_[slot].index != -1 || std::find(candidate.begin(), candidate.end(), slot) != candidate.end())
+					break;
+				candidate.push_back(slot);
+			}
+			if (candidate.size() == bucket.size())
+				break;
+
+			if (++displacement == MaxDisplacement) {
+				// Give up on the last key and try again with the rest
+				LogError("Can't place '{}' in the perfect hash", keys[bucket.back().index]);
+				bucket.pop_back();
+				displacement = 0;
+			}
+		}
+
+		displacements_[bucketIndex] = displacement;
+		for (size_t i = 0; i < bucket.size(); i++)
+			slots_[candidate[i]] = { keys[bucket[i].index], bucket[i].index };
+	}
+}
+
+size_t PerfectHashIndex::SlotFor(uint64_t hash) const
+{
+	return Mix(hash, displacements_[hash % displacements_.size()]) % slots_.size();
+}
+
+int PerfectHashIndex::Find(std::initializer_list<string_view> parts) const
+{
+	if (slots_.empty())
+		return -1;
+
+	const Slot &slot = slots_[SlotFor(HashString(parts))];
+	if (slot.index == -1 || !EqualsConcatenation(slot.key, parts))
+		return -1;
+	return slot.index;
+}
+
+} // namespace devilution
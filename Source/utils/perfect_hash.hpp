@@ -0,0 +1,81 @@
+/**
+ * @file perfect_hash.hpp
+ *
+ * Interface of an immutable string index with a minimal perfect hash.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "utils/stdcompat/string_view.hpp"
+
+namespace devilution {
+
+/**
+ * @brief FNV-1a, can be continued with the next part of a string to hash a concatenation without building it.
+ */
+inline uint64_t HashString(string_view str, uint64_t hash = 0xcbf29ce484222325)
+{
+	for (char c : str) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+/** @brief Hashes the concatenation of the parts. */
+inline uint64_t HashString(std::initializer_list<string_view> parts)
+{
+	uint64_t hash = HashString(string_view {});
+	for (string_view part : parts)
+		hash = HashString(part, hash);
+	return hash;
+}
+
+/** @brief Compares a string with the concatenation of the parts. */
+bool EqualsConcatenation(string_view str, std::initializer_list<string_view> parts);
+
+/**
+ * @brief Maps a fixed set of strings to their position in the set, built once and then only read.
+ *
+ * Every key gets its own slot (hash and displace), so a lookup is one hash, one table read and one string compare,
+ * without allocating.
+ */
+class PerfectHashIndex {
+public:
+	/**
+	 * @brief Builds the index, replacing any previous one.
+	 * @param keys The keys, they have to outlive the index. Only the first of duplicate keys can be found.
+	 */
+	void Build(std::vector<string_view> keys);
+
+	/** @return The position of the key in the vector given to Build, or -1 if it isn't in the index. */
+	int Find(string_view key) const
+	{
+		return Find({ key });
+	}
+
+	/** @brief Looks up the concatenation of the parts without building it. */
+	int Find(std::initializer_list<string_view> parts) const;
+
+	[[nodiscard]] size_t size() const // NOLINT(readability-identifier-naming)
+	{
+		return slots_.size();
+	}
+
+private:
+	struct Slot {
+		string_view key;
+		int index = -1;
+	};
+
+	[[nodiscard]] size_t SlotFor(uint64_t hash) const;
+
+	std::vector<uint32_t> displacements_;
+	std::vector<Slot> slots_;
+};
+
+} // namespace devilution
@@ -35,6 +35,13 @@ public:
 			ErrSdl();
 	}
 
+	void broadcast()
+	{
+		int err = SDL_CondBroadcast(cond);
+		if (err < 0)
+			ErrSdl();
+	}
+
 	void wait(SdlMutex &mutex)
 	{
 		int err = SDL_CondWait(cond, mutex.get());
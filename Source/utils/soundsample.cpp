@@ -1,9 +1,11 @@
 #include "utils/soundsample.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <utility>
 
+#include <Aulib/Decoder.h>
 #include <Aulib/DecoderDrmp3.h>
 #include <Aulib/DecoderDrwav.h>
 #include <SDL.h>
@@ -18,6 +20,7 @@
 #include "utils/aulib.hpp"
 #include "utils/log.hpp"
 #include "utils/math.h"
+#include "utils/stdcompat/algorithm.hpp"
 #include "utils/stubs.h"
 
 namespace devilution {
@@ -84,6 +87,103 @@ float VolumeLogToLinear(int logVolume, int logMin, int logMax)
 
 } // namespace
 
+/** @brief Plays back a DecodedSound, there is nothing left to decode. */
+class PcmDecoder final : public Aulib::Decoder {
+public:
+	void SetSound(std::shared_ptr<const DecodedSound> sound)
+	{
+		sound_ = std::move(sound);
+		position_ = 0;
+	}
+
+	bool open([[maybe_unused]] SDL_RWops *rwops) override
+	{
+		setIsOpen(true);
+		return true;
+	}
+
+	int getChannels() const override
+	{
+		return sound_->channels;
+	}
+
+	int getRate() const override
+	{
+		return sound_->rate;
+	}
+
+	bool rewind() override
+	{
+		position_ = 0;
+		return true;
+	}
+
+	std::chrono::microseconds duration() const override
+	{
+		return std::chrono::microseconds { static_cast<int64_t>(sound_->samples.size()) * 1000000 / (sound_->rate * sound_->channels) };
+	}
+
+	bool seekToTime(std::chrono::microseconds pos) override
+	{
+		const size_t frame = static_cast<size_t>(pos.count() * sound_->rate / 1000000);
+		position_ = std::min(frame * sound_->channels, sound_->samples.size());
+		return true;
+	}
+
+protected:
+	int doDecoding(float buf[], int len, bool &callAgain) override
+	{
+		callAgain = false;
+		const size_t count = std::min(static_cast<size_t>(len), sound_->samples.size() - position_);
+		const std::int16_t *samples = sound_->samples.data() + position_;
+		for (size_t i = 0; i < count; i++) {
+			buf[i] = samples[i] / 32768.F;
+		}
+		position_ += count;
+		return static_cast<int>(count);
+	}
+
+private:
+	std::shared_ptr<const DecodedSound> sound_;
+	size_t position_ = 0;
+};
+
+#ifndef STREAM_ALL_AUDIO
+std::shared_ptr<const DecodedSound> DecodeSound(const std::uint8_t *fileData, std::size_t dwBytes, bool isMp3)
+{
+	SDL_RWops *buf = SDL_RWFromConstMem(fileData, dwBytes);
+	if (buf == nullptr)
+		return nullptr;
+	std::unique_ptr<Aulib::Decoder> decoder = CreateDecoder(isMp3);
+	if (!decoder->open(buf)) {
+		SDL_RWclose(buf);
+		LogError(LogCategory::Audio, "Aulib::Decoder::open (from DecodeSound): {}", SDL_GetError());
+		return nullptr;
+	}
+
+	auto decoded = std::make_shared<DecodedSound>();
+	decoded->channels = decoder->getChannels();
+	decoded->rate = decoder->getRate();
+	decoded->samples.reserve(static_cast<size_t>(decoder->duration().count() * decoded->rate / 1000000 + 1) * decoded->channels);
+	float samples[4096];
+	bool callAgain = false;
+	while (true) {
+		const int count = decoder->decode(samples, sizeof(samples) / sizeof(samples[0]), callAgain);
+		if (count <= 0)
+			break;
+		for (int i = 0; i < count; i++) {
+			decoded->samples.push_back(static_cast<std::int16_t>(clamp(samples[i], -1.F, 1.F) * 32767.F));
+		}
+	}
+	SDL_RWclose(buf);
+
+	if (decoded->samples.empty() || decoded->channels <= 0 || decoded->rate <= 0)
+		return nullptr;
+	decoded->samples.shrink_to_fit();
+	return decoded;
+}
+#endif
+
 ///// SoundSample /////
 
 void SoundSample::Release()
@@ -92,6 +192,7 @@ void SoundSample::Release()
 #ifndef STREAM_ALL_AUDIO
 	file_data_ = nullptr;
 	file_data_size_ = 0;
+	decoded_ = nullptr;
 #endif
 }
 
@@ -133,11 +234,12 @@ int SoundSample::SetChunkStream(std::string filePath, bool isMp3, bool logErrors
 }
 
 #ifndef STREAM_ALL_AUDIO
-int SoundSample::SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwBytes, bool isMp3)
+int SoundSample::SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwBytes, bool isMp3, std::shared_ptr<const DecodedSound> decoded)
 {
 	isMp3_ = isMp3;
 	file_data_ = std::move(fileData);
 	file_data_size_ = dwBytes;
+	decoded_ = std::move(decoded);
 	SDL_RWops *buf = SDL_RWFromConstMem(file_data_.get(), dwBytes);
 	if (buf == nullptr) {
 		return -1;
@@ -147,6 +249,7 @@ int SoundSample::SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwB
 	if (!stream_->open()) {
 		stream_ = nullptr;
 		file_data_ = nullptr;
+		decoded_ = nullptr;
 		LogError(LogCategory::Audio, "Aulib::Stream::open (from SoundSample::SetChunk): {}", SDL_GetError());
 		return -1;
 	}
@@ -155,6 +258,62 @@ int SoundSample::SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwB
 }
 #endif
 
+///// SoundVoice /////
+
+SoundVoice::SoundVoice() = default;
+
+SoundVoice::~SoundVoice() = default;
+
+bool SoundVoice::IsPlaying() const
+{
+	return stream_ != nullptr && stream_->isPlaying();
+}
+
+bool SoundVoice::CanPlay(const DecodedSound &sound) const
+{
+	return stream_ == nullptr || (sound.channels == channels_ && sound.rate == rate_);
+}
+
+bool SoundVoice::Play(std::shared_ptr<const DecodedSound> sound, int logSoundVolume, int logUserVolume, int logPan)
+{
+	if (stream_ == nullptr) {
+		// The stream wants something to read from, the decoder never looks at it
+		static const std::uint8_t Placeholder = 0;
+		SDL_RWops *handle = SDL_RWFromConstMem(&Placeholder, 1);
+		if (handle == nullptr)
+			return false;
+		auto decoder = std::make_unique<PcmDecoder>();
+		decoder->SetSound(sound);
+		decoder_ = decoder.get();
+		channels_ = sound->channels;
+		rate_ = sound->rate;
+		stream_ = std::make_unique<Aulib::Stream>(handle, std::move(decoder), CreateAulibResampler(), /*closeRw=*/true);
+		if (!stream_->open()) {
+			stream_ = nullptr;
+			decoder_ = nullptr;
+			LogError(LogCategory::Audio, "Aulib::Stream::open (from SoundVoice::Play): {}", SDL_GetError());
+			return false;
+		}
+	} else {
+		decoder_->SetSound(std::move(sound));
+		stream_->rewind();
+	}
+
+	stream_->setVolume(VolumeLogToLinear(logSoundVolume + logUserVolume * (ATTENUATION_MIN / VOLUME_MIN), ATTENUATION_MIN, 0));
+	stream_->setStereoPosition(PanLogToLinear(logPan));
+	if (!stream_->play()) {
+		LogError(LogCategory::Audio, "Aulib::Stream::play (from SoundVoice::Play): {}", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+void SoundVoice::Stop()
+{
+	if (stream_ != nullptr)
+		stream_->stop();
+}
+
 void SoundSample::SetVolume(int logVolume, int logMin, int logMax)
 {
 	stream_->setVolume(VolumeLogToLinear(logVolume, logMin, logMax));
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <Aulib/Stream.h>
 
@@ -11,6 +12,21 @@
 
 namespace devilution {
 
+/** @brief A sound decoded to interleaved 16-bit samples, shared by the voices playing it. */
+struct DecodedSound {
+	std::vector<std::int16_t> samples;
+	int channels;
+	int rate;
+};
+
+#ifndef STREAM_ALL_AUDIO
+/**
+ * @brief Decodes a whole WAV or MP3 file to PCM, safe to call from any thread.
+ * @return nullptr if the data can't be decoded
+ */
+std::shared_ptr<const DecodedSound> DecodeSound(const std::uint8_t *fileData, std::size_t dwBytes, bool isMp3);
+#endif
+
 class SoundSample final {
 public:
 	SoundSample() = default;
@@ -38,9 +54,10 @@ public:
 	 * @brief Sets the sample's WAV, FLAC, or Ogg/Vorbis data.
 	 * @param fileData Buffer containing the data
 	 * @param dwBytes Length of buffer
+	 * @param decoded The same data from DecodeSound, used for overlapping plays, may be nullptr
 	 * @return 0 on success, -1 otherwise
 	 */
-	int SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwBytes, bool isMp3);
+	int SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwBytes, bool isMp3, std::shared_ptr<const DecodedSound> decoded = nullptr);
 #endif
 
 #ifndef STREAM_ALL_AUDIO
@@ -48,6 +65,21 @@ public:
 	{
 		return file_data_ == nullptr;
 	}
+
+	/** @return The sample decoded to PCM, nullptr for streamed samples or if it wasn't decoded when it was set */
+	[[nodiscard]] const std::shared_ptr<const DecodedSound> &GetDecoded() const
+	{
+		return decoded_;
+	}
+
+	/** @brief Bytes held for the file data and the decoded samples, 0 for streamed samples. */
+	[[nodiscard]] std::size_t GetMemorySize() const
+	{
+		std::size_t size = file_data_size_;
+		if (decoded_ != nullptr)
+			size += decoded_->samples.size() * sizeof(std::int16_t);
+		return size;
+	}
 #endif
 
 	int DuplicateFrom(const SoundSample &other)
@@ -57,7 +89,7 @@ public:
 #else
 		if (other.IsStreaming())
 			return SetChunkStream(other.file_path_, other.isMp3_);
-		return SetChunk(other.file_data_, other.file_data_size_, other.isMp3_);
+		return SetChunk(other.file_data_, other.file_data_size_, other.isMp3_, other.decoded_);
 #endif
 	}
 
@@ -106,7 +138,8 @@ private:
 #ifndef STREAM_ALL_AUDIO
 	// Non-streaming audio fields:
 	ArraySharedPtr<std::uint8_t> file_data_;
-	std::size_t file_data_size_;
+	std::size_t file_data_size_ = 0;
+	std::shared_ptr<const DecodedSound> decoded_;
 #endif
 
 	// Set for streaming audio to allow for duplicating it:
@@ -117,4 +150,37 @@ private:
 	std::unique_ptr<Aulib::Stream> stream_;
 };
 
+class PcmDecoder;
+
+/**
+ * @brief A stream for playing decoded sounds that is reused from one sound to the next.
+ *
+ * Overlapping plays of the same sound go through voices instead of duplicating the sample, which
+ * would allocate a new stream and decode the file again every time.
+ */
+class SoundVoice final {
+public:
+	SoundVoice();
+	~SoundVoice();
+
+	[[nodiscard]] bool IsPlaying() const;
+
+	/** @brief Voices are set up for the rate and channel count of the first sound they play. */
+	[[nodiscard]] bool CanPlay(const DecodedSound &sound) const;
+
+	/**
+	 * @brief Start playing the sound with the given sound and user volume, and a stereo position.
+	 */
+	bool Play(std::shared_ptr<const DecodedSound> sound, int logSoundVolume, int logUserVolume, int logPan);
+
+	void Stop();
+
+private:
+	/** Owned by stream_ */
+	PcmDecoder *decoder_ = nullptr;
+	std::unique_ptr<Aulib::Stream> stream_;
+	int channels_ = 0;
+	int rate_ = 0;
+};
+
 } // namespace devilution
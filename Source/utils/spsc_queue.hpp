@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace devilution {
+
+/**
+ * @brief A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * @tparam T element type, must be default constructible and move assignable.
+ * @tparam N capacity.
+ */
+template <class T, size_t N>
+class SpscQueue {
+public:
+	/**
+	 * @brief Moves value into the queue. Must only be called from the producer thread.
+	 * @return false if the queue is full, value is left untouched in that case.
+	 */
+	bool try_push(T &value) // NOLINT(readability-identifier-naming)
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		const size_t next = Next(tail);
+		if (next == head_.load(std::memory_order_acquire))
+			return false;
+		items_[tail] = std::move(value);
+		tail_.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Moves the oldest element out of the queue. Must only be called from the consumer thread.
+	 * @return false if the queue is empty.
+	 */
+	bool try_pop(T &value) // NOLINT(readability-identifier-naming)
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+			return false;
+		value = std::move(items_[head]);
+		items_[head] = T {};
+		head_.store(Next(head), std::memory_order_release);
+		return true;
+	}
+
+	/** @brief Number of queued elements, may be stale by the time it is used. */
+	size_t size() const // NOLINT(readability-identifier-naming)
+	{
+		const size_t head = head_.load(std::memory_order_acquire);
+		const size_t tail = tail_.load(std::memory_order_acquire);
+		return tail >= head ? tail - head : tail + Slots - head;
+	}
+
+	bool empty() const // NOLINT(readability-identifier-naming)
+	{
+		return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+	}
+
+	static constexpr size_t capacity() // NOLINT(readability-identifier-naming)
+	{
+		return N;
+	}
+
+private:
+	/** One slot is kept free to tell a full queue from an empty one. */
+	static constexpr size_t Slots = N + 1;
+
+	static constexpr size_t Next(size_t index)
+	{
+		return index + 1 == Slots ? 0 : index + 1;
+	}
+
+	std::array<T, Slots> items_ {};
+	alignas(64) std::atomic<size_t> head_ { 0 };
+	alignas(64) std::atomic<size_t> tail_ { 0 };
+};
+
+} // namespace devilution
@@ -0,0 +1,115 @@
+/**
+ * @file delta_benchmark.cpp
+ *
+ * Measures the level delta exchange of a player joining a game where all 25 dungeon levels
+ * have been visited, for every codec a delta chunk can be encoded with.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include <fmt/core.h>
+
+#include "diablo.h"
+#include "gendung.h"
+#include "items.h"
+#include "monster.h"
+#include "msg.h"
+#include "multi.h"
+
+using namespace devilution;
+
+namespace {
+
+constexpr int Iterations = 200;
+constexpr int ItemsPerLevel = 60;
+constexpr int KilledMonstersPerLevel = 150;
+constexpr size_t ChunkCapacity = sizeof(DLevel) + 1;
+
+uint32_t Seed = 1;
+
+uint32_t NextRandom()
+{
+	Seed = Seed * 1103515245 + 12345;
+	return Seed >> 8;
+}
+
+/** @return Average run time of fn in microseconds. */
+template <typename F>
+double Measure(F &&fn)
+{
+	fn(); // Warm up the caches and the allocator
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+		fn();
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / Iterations;
+}
+
+/** @brief Fills the deltas of every level the way a long multiplayer game leaves them. */
+void PopulateLevels()
+{
+	delta_init();
+	Item &item = Items[0];
+	for (int level = 0; level < NUMLEVELS; level++) {
+		currlevel = level;
+		for (int i = 0; i < ItemsPerLevel; i++) {
+			item.IDidx = static_cast<_item_indexes>(NextRandom() % IDI_LAST);
+			item._iCreateInfo = static_cast<uint16_t>(NextRandom());
+			item._iSeed = static_cast<int32_t>(NextRandom());
+			item.position = { static_cast<int>(NextRandom() % MAXDUNX), static_cast<int>(NextRandom() % MAXDUNY) };
+			item._iIdentified = (NextRandom() & 1) != 0;
+			item._iMaxDur = NextRandom() % 60 + 1;
+			item._iDurability = NextRandom() % item._iMaxDur + 1;
+			item._ivalue = NextRandom() % 5000;
+			DeltaAddItem(0);
+		}
+		for (int mi = 0; mi < KilledMonstersPerLevel; mi++)
+			delta_kill_monster(mi, { static_cast<int>(NextRandom() % MAXDUNX), static_cast<int>(NextRandom() % MAXDUNY) }, level);
+	}
+}
+
+} // namespace
+
+int main()
+{
+	gbQuietMode = true;
+	gbIsMultiplayer = true;
+	PopulateLevels();
+
+	std::unique_ptr<byte[]> chunks { new byte[ChunkCapacity * NUMLEVELS] };
+	std::unique_ptr<byte[]> reexported { new byte[ChunkCapacity] };
+	uint32_t sizes[NUMLEVELS];
+
+	fmt::print("{:<8} {:>12} {:>12} {:>12}\n", "Codec", "Export", "Import", "Bytes");
+	const std::pair<DeltaCompression, const char *> codecs[] = {
+		{ DeltaCompression::None, "None" },
+		{ DeltaCompression::Pkware, "PKWARE" },
+		{ DeltaCompression::Lz, "LZ" },
+	};
+	for (const auto &codec : codecs) {
+		const double exportMicros = Measure([&]() {
+			for (int level = 0; level < NUMLEVELS; level++)
+				sizes[level] = DeltaExportLevel(level, codec.first, &chunks[ChunkCapacity * level]);
+		});
+		const double importMicros = Measure([&]() {
+			for (int level = 0; level < NUMLEVELS; level++)
+				DeltaImportLevel(level, &chunks[ChunkCapacity * level], sizes[level]);
+		});
+
+		size_t totalBytes = 0;
+		for (int level = 0; level < NUMLEVELS; level++) {
+			// Importing a level has to restore exactly what was exported
+			const uint32_t size = DeltaExportLevel(level, codec.first, reexported.get());
+			if (size != sizes[level] || memcmp(reexported.get(), &chunks[ChunkCapacity * level], size) != 0) {
+				fmt::print("{}: level {} does not survive a round trip\n", codec.second, level);
+				return 1;
+			}
+			totalBytes += size;
+		}
+
+		fmt::print("{:<8} {:>9.1f} us {:>9.1f} us {:>12}\n", codec.second, exportMicros, importMicros, totalBytes);
+	}
+	return 0;
+}
@@ -0,0 +1,366 @@
+/**
+ * @file save_benchmark.cpp
+ *
+ * Measures saving and loading a level that is filled up to the limits of the save format,
+ * and reports the time and size of every stage a save goes through.
+ *
+ * The save files are written to the current directory. Pass --corpus <dir> to also write
+ * seed inputs for the fuzz targets in test/fuzz, the files are prefixed with the target name.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "automap.h"
+#include "codec.h"
+#include "diablo.h"
+#include "gendung.h"
+#include "init.h"
+#include "items.h"
+#include "lighting.h"
+#include "loadsave.h"
+#include "menu.h"
+#include "missiles.h"
+#include "monster.h"
+#include "mpq/mpq_reader.hpp"
+#include "objects.h"
+#include "options.h"
+#include "pack.h"
+#include "pfile.h"
+#include "qol/stash.h"
+#include "utils/file_util.h"
+#include "utils/lz_codec.hpp"
+#include "utils/paths.h"
+
+using namespace devilution;
+
+namespace {
+
+constexpr int Iterations = 20;
+/** Number of missiles vanilla saves can hold, the rest go to a separate file. */
+constexpr size_t SavedMissiles = 125;
+constexpr unsigned StashPages = 50;
+
+uint32_t Seed = 1;
+
+uint32_t NextRandom()
+{
+	Seed = Seed * 1103515245 + 12345;
+	return Seed >> 8;
+}
+
+/** @return Average run time of fn in microseconds. */
+template <typename F>
+double Measure(F &&fn)
+{
+	fn(); // Warm up the caches and the allocator
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+		fn();
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / Iterations;
+}
+
+void Report(const char *phase, double micros, size_t processedBytes, size_t outputBytes)
+{
+	fmt::print("{:<24} {:>10.1f} us {:>8.1f} MB/s {:>10} bytes\n", phase, micros, processedBytes / micros, outputBytes);
+}
+
+template <typename T, size_t Width, size_t Height, typename F>
+void FillGrid(T (&grid)[Width][Height], F &&value)
+{
+	for (auto &column : grid) {
+		for (T &cell : column)
+			cell = static_cast<T>(value());
+	}
+}
+
+Point DenseTile(int i)
+{
+	return { 16 + i % 80, 16 + i / 80 };
+}
+
+/** @brief Fills the current level with as many monsters, objects, items and missiles as a save can hold. */
+void CreateDenseLevel()
+{
+	setlevel = false;
+	currlevel = 1;
+	leveltype = DTYPE_CATHEDRAL;
+
+	FillGrid(dCorpse, [] { return NextRandom() % 32; });
+	FillGrid(dFlags, [] { return static_cast<DungeonFlag>(NextRandom()) & DungeonFlag::SavedFlags; });
+	FillGrid(dLight, [] { return NextRandom() % 16; });
+	FillGrid(dPreLight, [] { return NextRandom() % 16; });
+	FillGrid(AutomapView, [] { return NextRandom() % 2 == 0 ? MAP_EXP_NONE : MAP_EXP_SELF; });
+	FillGrid(dPlayer, [] { return 0; });
+	FillGrid(dMonster, [] { return 0; });
+	FillGrid(dObject, [] { return 0; });
+	FillGrid(dItem, [] { return 0; });
+
+	ActiveMonsterCount = MAXMONSTERS;
+	for (int i = 0; i < MAXMONSTERS; i++) {
+		Monster &monster = Monsters[i];
+		monster = {};
+		monster._mMTidx = i % 16;
+		monster._mmode = MonsterMode::Stand;
+		monster.position.tile = DenseTile(i);
+		monster._mhitpoints = static_cast<int>(NextRandom() % 4096);
+		monster.mlid = NO_LIGHT;
+		ActiveMonsters[i] = i;
+		dMonster[monster.position.tile.x][monster.position.tile.y] = i + 1;
+	}
+
+	ActiveObjectCount = MAXOBJECTS;
+	for (int i = 0; i < MAXOBJECTS; i++) {
+		Object &object = Objects[i];
+		object = {};
+		object._otype = i % 2 == 0 ? OBJ_BARREL : OBJ_CHEST1;
+		object.position = DenseTile(i);
+		ActiveObjects[i] = i;
+		AvailableObjects[i] = i;
+		dObject[object.position.x][object.position.y] = i + 1;
+	}
+
+	ActiveItemCount = MAXITEMS;
+	for (int i = 0; i < MAXITEMS; i++) {
+		Item &item = Items[i];
+		item = {};
+		item._itype = ItemType::Misc;
+		item.IDidx = IDI_HEAL;
+		item._iSeed = static_cast<int32_t>(NextRandom());
+		item.position = DenseTile(i);
+		ActiveItems[i] = i;
+		dItem[item.position.x][item.position.y] = i + 1;
+	}
+
+	Missiles.clear();
+	for (size_t i = 0; i < SavedMissiles; i++) {
+		Missile missile {};
+		missile._mitype = MIS_ARROW;
+		missile.position.tile = DenseTile(static_cast<int>(i));
+		Missiles.push_back(missile);
+	}
+}
+
+void CreateDenseStash()
+{
+	Stash = {};
+	for (unsigned page = 0; page < StashPages; page++) {
+		for (int x = 0; x < 10; x += 2) {
+			for (int y = 0; y < 10; y += 2) {
+				Item item {};
+				item._itype = ItemType::Misc;
+				item.IDidx = IDI_HEAL;
+				item._iSeed = static_cast<int32_t>(NextRandom());
+				Stash.stashList.push_back(item);
+				Stash.stashGrids[page][x][y] = static_cast<uint16_t>(Stash.stashList.size());
+			}
+		}
+		Stash.MarkPageDirty(page);
+	}
+}
+
+std::vector<SaveSnapshot::File> SaveCurrentLevel()
+{
+	SaveSnapshot snapshot;
+	SaveLevel(snapshot);
+	return snapshot.TakeFiles();
+}
+
+size_t TotalSize(const std::vector<SaveSnapshot::File> &files)
+{
+	size_t size = 0;
+	for (const SaveSnapshot::File &file : files)
+		size += file.size;
+	return size;
+}
+
+std::uintmax_t FileSize(const std::string &path)
+{
+	std::uintmax_t size = 0;
+	GetFileSize(path.c_str(), &size);
+	return size;
+}
+
+/** @param flags First byte of the input, all fuzz targets use it to pick the game mode. */
+void WriteCorpusFile(const char *corpusDir, const char *name, uint8_t flags, const byte *data, size_t size)
+{
+	if (corpusDir == nullptr)
+		return;
+
+	std::ofstream file(std::string(corpusDir) + "/" + name, std::ios::binary);
+	file.put(static_cast<char>(flags));
+	file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+}
+
+bool BenchmarkLevel(const char *corpusDir)
+{
+	CreateDenseLevel();
+
+	std::vector<SaveSnapshot::File> files;
+	const double saveTime = Measure([&]() { files = SaveCurrentLevel(); });
+	const SaveSnapshot::File &level = files[0];
+	Report("SaveLevel", saveTime, level.size, level.size);
+
+	bool loaded = true;
+	const double loadTime = Measure([&]() {
+		std::unique_ptr<byte[]> copy { new byte[level.size] };
+		memcpy(copy.get(), level.data.get(), level.size);
+		loaded = LoadLevelFromMemory(std::move(copy), level.size) && loaded;
+	});
+	Report("LoadLevel", loadTime, level.size, level.size);
+
+	const std::vector<SaveSnapshot::File> roundTrip = SaveCurrentLevel();
+	if (!loaded || roundTrip[0].size != level.size || memcmp(roundTrip[0].data.get(), level.data.get(), level.size) != 0) {
+		fmt::print(stderr, "The level did not survive a save/load round trip\n");
+		return false;
+	}
+
+	std::vector<byte> compressed(LzCompressBound(level.size));
+	size_t compressedSize = 0;
+	Report("Level cache compress", Measure([&]() {
+		compressedSize = LzCompress(level.data.get(), level.size, compressed.data(), compressed.size());
+	}),
+	    level.size, compressedSize);
+	std::unique_ptr<byte[]> decompressed { new byte[level.size] };
+	Report("Level cache decompress", Measure([&]() {
+		LzDecompress(compressed.data(), compressedSize, decompressed.get(), level.size);
+	}),
+	    compressedSize, level.size);
+
+	const size_t encodedSize = codec_get_encoded_len(level.size);
+	std::unique_ptr<byte[]> encoded { new byte[encodedSize] };
+	Report("Codec encode", Measure([&]() {
+		memcpy(encoded.get(), level.data.get(), level.size);
+		codec_encode(encoded.get(), level.size, encodedSize, pfile_get_password());
+	}),
+	    level.size, encodedSize);
+	std::unique_ptr<byte[]> decoded { new byte[encodedSize] };
+	Report("Codec decode", Measure([&]() {
+		memcpy(decoded.get(), encoded.get(), encodedSize);
+		codec_decode(decoded.get(), encodedSize, pfile_get_password());
+	}),
+	    encodedSize, level.size);
+
+	WriteCorpusFile(corpusDir, "level_fuzzer_dense", 0, level.data.get(), level.size);
+	WriteCorpusFile(corpusDir, "codec_fuzzer_level", 0, encoded.get(), encodedSize);
+	return true;
+}
+
+bool BenchmarkGame(const char *corpusDir)
+{
+	_uiheroinfo info {};
+	strcpy(info.name, "Benchmark");
+	info.heroclass = HeroClass::Warrior;
+	if (!pfile_ui_save_create(&info)) {
+		fmt::print(stderr, "Failed to create the save file\n");
+		return false;
+	}
+	MyPlayerId = 0;
+	MyPlayer = &Players[MyPlayerId];
+	MyPlayer->plrlevel = 1;
+
+	PlayerPack pack;
+	PackPlayer(&pack, *MyPlayer, true, false);
+	WriteCorpusFile(corpusDir, "unpack_player_fuzzer_warrior", 0, reinterpret_cast<const byte *>(&pack), sizeof(pack));
+
+	CreateDenseLevel();
+	CreateDenseStash();
+
+	const std::string savePath = paths::PrefPath() + "single_0.sv";
+	const std::string stashPath = paths::PrefPath() + "stash.sv";
+	for (bool zlib : { false, true }) {
+		sgOptions.Gameplay.fastSaveCompression.SetValue(zlib);
+		const double saveTime = Measure([]() {
+			SaveLevel();
+			for (unsigned page = 0; page < StashPages; page++)
+				Stash.MarkPageDirty(page);
+			SaveGame();
+		});
+		const std::uintmax_t saveSize = FileSize(savePath);
+		const std::uintmax_t stashSize = FileSize(stashPath);
+		const auto totalSize = static_cast<size_t>(saveSize + stashSize);
+		Report(zlib ? "SaveGame (zlib)" : "SaveGame (implode)", saveTime, totalSize, totalSize);
+	}
+
+	size_t gameSize = 0;
+	const double readTime = Measure([&]() {
+		std::optional<MpqArchive> archive = OpenSaveArchive(gSaveNumber);
+		SaveFileReader reader(std::move(*archive), "game");
+		gameSize = 0;
+		// Same granularity as the fields LoadGame reads
+		while (reader.Peek(4) != nullptr) {
+			reader.Skip(4);
+			gameSize += 4;
+		}
+		while (reader.Peek(1) != nullptr) {
+			reader.Skip(1);
+			gameSize++;
+		}
+		reader.Finish();
+	});
+	Report("Read game file", readTime, gameSize, gameSize);
+
+	char szName[MAX_PATH];
+	GetPermLevelNames(szName);
+	size_t levelSize = 0;
+	bool loaded = true;
+	const double levelTime = Measure([&]() {
+		std::optional<MpqArchive> archive = OpenSaveArchive(gSaveNumber);
+		std::unique_ptr<byte[]> level = ReadArchive(*archive, szName, &levelSize);
+		loaded = LoadLevelFromMemory(std::move(level), levelSize) && loaded;
+	});
+	Report("LoadLevel from archive", levelTime, levelSize, levelSize);
+
+	Stash.dirtyPages.clear();
+	for (unsigned page = 0; page < StashPages; page++)
+		Stash.MarkPageDirty(page);
+	size_t stashBytes = 0;
+	Report("SaveStash (all pages)", Measure([&]() {
+		SaveSnapshot snapshot;
+		SaveStash(snapshot);
+		stashBytes = TotalSize(snapshot.TakeFiles());
+	}),
+	    stashBytes, stashBytes);
+	Stash.dirtyPages.clear();
+	Stash.MarkPageDirty(0);
+	Report("SaveStash (one page)", Measure([&]() {
+		SaveSnapshot snapshot;
+		SaveStash(snapshot);
+		stashBytes = TotalSize(snapshot.TakeFiles());
+	}),
+	    stashBytes, stashBytes);
+
+	std::remove(savePath.c_str());
+	std::remove(stashPath.c_str());
+	return loaded;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	const char *corpusDir = nullptr;
+	if (argc == 3 && strcmp(argv[1], "--corpus") == 0)
+		corpusDir = argv[2];
+
+	gbQuietMode = true;
+	paths::SetPrefPath(".");
+	gbVanilla = false;
+	gbIsHellfire = false;
+	gbIsMultiplayer = false;
+	gbIsSpawn = false;
+	gbIsHellfireSaveGame = false;
+	giNumberOfLevels = 17;
+
+	fmt::print("{:<24} {:>13} {:>13} {:>16}\n", "Phase", "Time", "Throughput", "Output");
+	if (!BenchmarkLevel(corpusDir) || !BenchmarkGame(corpusDir))
+		return 1;
+	return 0;
+}
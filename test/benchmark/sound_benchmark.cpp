@@ -0,0 +1,114 @@
+/**
+ * @file sound_benchmark.cpp
+ *
+ * Measures how many overlapping sound effects can be started per second, by duplicating the
+ * sample like before and through the shared voices.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <Aulib/Stream.h>
+#include <SDL.h>
+#include <fmt/core.h>
+
+#include "utils/soundsample.h"
+#include "utils/stdcompat/shared_ptr_array.hpp"
+
+using namespace devilution;
+
+namespace {
+
+constexpr int Iterations = 2000;
+constexpr int SampleRate = 22050;
+constexpr size_t VoiceCount = 32;
+
+void WriteLE16(std::vector<uint8_t> &out, uint16_t value)
+{
+	out.push_back(value & 0xFF);
+	out.push_back(value >> 8);
+}
+
+void WriteLE32(std::vector<uint8_t> &out, uint32_t value)
+{
+	WriteLE16(out, value & 0xFFFF);
+	WriteLE16(out, value >> 16);
+}
+
+/** @brief Builds a mono 16-bit WAV like the game's sound effects, one second of a sine tone. */
+std::vector<uint8_t> CreateWav()
+{
+	const uint32_t dataSize = SampleRate * sizeof(int16_t);
+	std::vector<uint8_t> wav;
+	wav.insert(wav.end(), { 'R', 'I', 'F', 'F' });
+	WriteLE32(wav, 36 + dataSize);
+	wav.insert(wav.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+	WriteLE32(wav, 16);
+	WriteLE16(wav, 1); // PCM
+	WriteLE16(wav, 1); // Mono
+	WriteLE32(wav, SampleRate);
+	WriteLE32(wav, SampleRate * sizeof(int16_t));
+	WriteLE16(wav, sizeof(int16_t));
+	WriteLE16(wav, 16);
+	wav.insert(wav.end(), { 'd', 'a', 't', 'a' });
+	WriteLE32(wav, dataSize);
+	for (int i = 0; i < SampleRate; i++)
+		WriteLE16(wav, static_cast<uint16_t>(static_cast<int16_t>(std::sin(i * 0.05) * 8000)));
+	return wav;
+}
+
+template <typename F>
+void Measure(const char *name, F &&play)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+		play(i);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	fmt::print("{:<12} {:>12.0f} plays/s\n", name, Iterations / seconds);
+}
+
+} // namespace
+
+int main()
+{
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+	if (SDL_Init(SDL_INIT_AUDIO) != 0 || !Aulib::init(SampleRate, AUDIO_S16, 2, 2048)) {
+		fmt::print(stderr, "Failed to initialize audio: {}\n", SDL_GetError());
+		return 1;
+	}
+
+	const std::vector<uint8_t> wav = CreateWav();
+	auto fileData = MakeArraySharedPtr<std::uint8_t>(wav.size());
+	std::memcpy(fileData.get(), wav.data(), wav.size());
+
+	SoundSample sample;
+	if (sample.SetChunk(fileData, wav.size(), /*isMp3=*/false, DecodeSound(fileData.get(), wav.size(), /*isMp3=*/false)) != 0) {
+		fmt::print(stderr, "Failed to load the sample: {}\n", SDL_GetError());
+		return 1;
+	}
+
+	{
+		std::vector<SoundSample> duplicates(VoiceCount);
+		Measure("Duplicate", [&](int i) {
+			SoundSample &duplicate = duplicates[i % VoiceCount];
+			duplicate.Release();
+			duplicate.DuplicateFrom(sample);
+			duplicate.PlayWithVolumeAndPan(0, 0, 0);
+		});
+	}
+
+	{
+		std::vector<SoundVoice> voices(VoiceCount);
+		Measure("Voice", [&](int i) {
+			SoundVoice &voice = voices[i % VoiceCount];
+			voice.Stop();
+			voice.Play(sample.GetDecoded(), 0, 0, 0);
+		});
+	}
+
+	Aulib::quit();
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file store_benchmark.cpp
+ *
+ * Measures how long restocking the town stores takes, for every dungeon level.
+ */
+#include <chrono>
+#include <cstdint>
+
+#include <fmt/core.h>
+
+#include "diablo.h"
+#include "engine/random.hpp"
+#include "items.h"
+#include "player.h"
+#include "stores.h"
+
+using namespace devilution;
+
+namespace {
+
+constexpr int Iterations = 200;
+
+/** @brief Restocks every store the way entering town does, with a fresh premium list. */
+void RestockStores(int lvl)
+{
+	SpawnSmith(lvl);
+	SpawnWitch(lvl);
+	SpawnHealer(lvl);
+	SpawnBoy(MyPlayer->_pLevel);
+
+	numpremium = 0;
+	premiumlevel = 1;
+	for (Item &item : premiumitems)
+		item.Clear();
+	SpawnPremium(MyPlayerId);
+}
+
+/** @return Sum of the item seeds, changes whenever the stores roll different items. */
+uint32_t StockChecksum()
+{
+	uint32_t checksum = 0;
+	const auto add = [&checksum](const Item *items, int count) {
+		for (int i = 0; i < count; i++)
+			checksum = checksum * 31 + static_cast<uint32_t>(items[i]._iSeed) + items[i].IDidx;
+	};
+	add(smithitem, SMITH_ITEMS);
+	add(witchitem, WITCH_ITEMS);
+	add(healitem, 20);
+	add(&boyitem, 1);
+	add(premiumitems, SMITH_PREMIUM_ITEMS);
+	return checksum;
+}
+
+} // namespace
+
+int main()
+{
+	gbQuietMode = true;
+	gbIsHellfire = false;
+	gbIsMultiplayer = false;
+	gbIsSpawn = false;
+
+	MyPlayerId = 0;
+	MyPlayer = &Players[MyPlayerId];
+	CreatePlayer(MyPlayerId, HeroClass::Warrior);
+	MyPlayer->_pLevel = 30;
+
+	fmt::print("{:<8} {:>12} {:>12}\n", "Level", "Restock", "Checksum");
+	double total = 0;
+	for (int lvl = 1; lvl <= 16; lvl++) {
+		SetRndSeed(lvl);
+		RestockStores(lvl); // Warm up
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < Iterations; i++) {
+			SetRndSeed(lvl * Iterations + i);
+			RestockStores(lvl);
+		}
+		const double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / Iterations;
+		total += micros;
+
+		// The same seed has to give the same stock before and after optimising the vendors
+		SetRndSeed(lvl);
+		RestockStores(lvl);
+		fmt::print("{:<8} {:>9.1f} us {:>12x}\n", lvl, micros, StockChecksum());
+	}
+	fmt::print("{:<8} {:>9.1f} us\n", "Average", total / 16);
+	return 0;
+}
@@ -13,3 +13,10 @@ TEST(Codec, codec_get_encoded_len_eq)
 {
 	EXPECT_EQ(codec_get_encoded_len(128), 136);
 }
+
+TEST(Codec, codec_decode_partial_block)
+{
+	// Only whole 64 byte blocks can be decoded, anything else must be rejected without reading past the end
+	byte data[16 + 8] = {};
+	EXPECT_EQ(codec_decode(data, sizeof(data), "xrgyrkj1"), 0);
+}
@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 #include "utils/file_util.h"
 
@@ -41,6 +43,33 @@ TEST(FileUtil, GetFileSize)
 	EXPECT_EQ(result, 42);
 }
 
+TEST(FileUtil, GetFileModificationTime)
+{
+	EXPECT_FALSE(GetFileModificationTime("this-file-should-not-exist", nullptr));
+	const std::string path = GetTmpPathName();
+	WriteDummyFile(path.c_str(), 42);
+	std::int64_t first;
+	ASSERT_TRUE(GetFileModificationTime(path.c_str(), &first));
+	std::int64_t second;
+	ASSERT_TRUE(GetFileModificationTime(path.c_str(), &second));
+	EXPECT_EQ(first, second);
+}
+
+#ifdef __linux__
+TEST(FileUtil, GetFileModificationTimeIsFinerThanSeconds)
+{
+	const std::string path = GetTmpPathName();
+	WriteDummyFile(path.c_str(), 42);
+	std::int64_t first;
+	ASSERT_TRUE(GetFileModificationTime(path.c_str(), &first));
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	WriteDummyFile(path.c_str(), 42);
+	std::int64_t second;
+	ASSERT_TRUE(GetFileModificationTime(path.c_str(), &second));
+	EXPECT_NE(first, second);
+}
+#endif
+
 TEST(FileUtil, FileExists)
 {
 	EXPECT_FALSE(FileExists("this-file-should-not-exist"));
@@ -63,4 +92,16 @@ TEST(FileUtil, ResizeFile)
 	EXPECT_EQ(size, 30);
 }
 
+TEST(FileUtil, SyncFile)
+{
+	EXPECT_FALSE(SyncFile("this-file-should-not-exist"));
+	const std::string path = GetTmpPathName();
+	WriteDummyFile(path.c_str(), 42);
+	EXPECT_TRUE(SyncFile(path.c_str()));
+	SyncFileDirectory(path.c_str());
+	std::uintmax_t size;
+	ASSERT_TRUE(GetFileSize(path.c_str(), &size));
+	EXPECT_EQ(size, 42);
+}
+
 } // namespace
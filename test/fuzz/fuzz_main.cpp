@@ -0,0 +1,44 @@
+/**
+ * @file fuzz_main.cpp
+ *
+ * Runs a fuzz target without libFuzzer, for compilers that don't support it.
+ *
+ * Every file passed on the command line is fed to the target once, which makes it possible
+ * to replay a corpus or a crash. Without arguments a fixed set of pseudo-random inputs is used
+ * so the targets are exercised by ctest.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int main(int argc, char **argv)
+{
+	std::vector<uint8_t> input;
+
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++) {
+			std::ifstream file(argv[i], std::ios::binary);
+			input.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			LLVMFuzzerTestOneInput(input.data(), input.size());
+		}
+		return 0;
+	}
+
+	uint32_t seed = 1;
+	const auto nextRandom = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	};
+	for (int run = 0; run < 1000; run++) {
+		// Mostly short inputs, with the occasional one big enough to cover a whole level
+		input.resize(run % 10 == 0 ? nextRandom() % 70000 : nextRandom() % 512);
+		for (uint8_t &value : input)
+			value = static_cast<uint8_t>(nextRandom());
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+	}
+	return 0;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file game_fuzzer.cpp
+ *
+ * Loads arbitrary data as the game file of a save, which covers the checks LoadGame does on the
+ * counts and ids it reads before using them as indexes.
+ */
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "diablo.h"
+#include "loadsave.h"
+#include "missiles.h"
+#include "player.h"
+
+using namespace devilution;
+
+namespace {
+
+/** Magic number, set level flag, set level, current level, level type, view, panels and the four counts. */
+constexpr size_t HeaderSize = 4 + 1 + 4 + 4 + 4 + 8 + 1 + 1 + 4 * 4;
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size < 1 + HeaderSize - 4)
+		return 0;
+
+	// The first byte picks the game and the level, random bytes would almost never get past the header
+	gbIsHellfire = (data[0] & 1) != 0;
+	const uint8_t level = (data[0] >> 1) % 17;
+
+	const size_t gameSize = size - 1 + 4;
+	std::unique_ptr<byte[]> game { new byte[gameSize] };
+	memcpy(game.get(), gbIsHellfire ? "HELF" : "RETL", 4);
+	memcpy(&game[4], data + 1, size - 1);
+	game[4] = byte { 0 }; // Not on a quest level
+	memset(&game[9], 0, 3);
+	game[12] = static_cast<byte>(level);
+	// Only the lowest byte of the monster, item, missile and object counts is kept
+	for (size_t count = 27; count < HeaderSize; count += 4)
+		memset(&game[count], 0, 3);
+
+	MyPlayerId = 0;
+	MyPlayer = &Players[MyPlayerId];
+	*MyPlayer = {};
+	Missiles.clear();
+	LoadGameFromMemory(std::move(game), gameSize);
+
+	return 0;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file level_fuzzer.cpp
+ *
+ * Loads arbitrary data as a level file, which covers LoadHelper and the monster, object and item loaders.
+ */
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "gendung.h"
+#include "loadsave.h"
+#include "monster.h"
+
+using namespace devilution;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size < 1)
+		return 0;
+
+	// The first byte picks town or dungeon, their levels are laid out differently
+	leveltype = (data[0] & 1) != 0 ? DTYPE_TOWN : DTYPE_CATHEDRAL;
+	currlevel = leveltype == DTYPE_TOWN ? 0 : 1;
+	// The monsters of the previous input are looked at before the level is read
+	ActiveMonsterCount = 0;
+
+	std::unique_ptr<byte[]> level { new byte[size - 1] };
+	memcpy(level.get(), data + 1, size - 1);
+	LoadLevelFromMemory(std::move(level), size - 1);
+
+	return 0;
+}
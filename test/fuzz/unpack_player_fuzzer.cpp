@@ -0,0 +1,34 @@
+/**
+ * @file unpack_player_fuzzer.cpp
+ *
+ * Unpacks arbitrary data as a hero, the same way heroes from save files and other players are read.
+ */
+#include <cstdint>
+#include <cstring>
+
+#include "diablo.h"
+#include "pack.h"
+#include "player.h"
+
+using namespace devilution;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size < 1 + sizeof(PlayerPack))
+		return 0;
+
+	// The first byte picks the game mode and whether the hero comes from the network
+	gbIsHellfire = (data[0] & 1) != 0;
+	gbIsMultiplayer = (data[0] & 2) != 0;
+	const bool netSync = (data[0] & 4) != 0;
+
+	PlayerPack pack;
+	memcpy(&pack, data + 1, sizeof(pack));
+
+	MyPlayerId = 0;
+	MyPlayer = &Players[MyPlayerId];
+	*MyPlayer = {};
+	UnPackPlayer(&pack, *MyPlayer, netSync);
+
+	return 0;
+}
@@ -246,3 +246,75 @@ TEST(Inv, ItemSize)
 	InitializeItem(testItem, IDI_GOLD);
 	EXPECT_EQ(GetInventorySize(testItem), Size(1, 1));
 }
+
+namespace {
+
+/* The cell by cell check AutoPlaceItemInInventorySlot used before it worked on an occupancy mask. */
+bool ReferenceItemFitsInSlot(const Player &player, int slotIndex, Size itemSize)
+{
+	int yy = (slotIndex > 0) ? (10 * (slotIndex / 10)) : 0;
+	for (int j = 0; j < itemSize.height; j++) {
+		if (yy >= NUM_INV_GRID_ELEM)
+			return false;
+		int xx = (slotIndex > 0) ? (slotIndex % 10) : 0;
+		for (int i = 0; i < itemSize.width; i++) {
+			if (xx >= 10 || player.InvGrid[xx + yy] != 0)
+				return false;
+			xx++;
+		}
+		yy += 10;
+	}
+	return true;
+}
+
+} // namespace
+
+TEST(Inv, AutoPlaceItemInInventorySlot_matches_cell_check)
+{
+	Player &player = Players[MyPlayerId];
+	uint32_t seed = 1;
+	for (int run = 0; run < 100; run++) {
+		clear_inventory();
+		for (int8_t &cell : player.InvGrid) {
+			seed = seed * 1103515245 + 12345;
+			if ((seed >> 16) % 4 == 0)
+				cell = -1;
+		}
+
+		for (item_cursor_graphic cursor : { ICURS_POTION_OF_HEALING, ICURS_SHORT_SWORD, ICURS_CAP, ICURS_SMALL_SHIELD, ICURS_QUILTED_ARMOR }) {
+			Item item {};
+			item._iCurs = cursor;
+			const Size itemSize = GetInventorySize(item);
+			for (int slot = 0; slot < NUM_INV_GRID_ELEM; slot++) {
+				ASSERT_EQ(AutoPlaceItemInInventorySlot(player, slot, item, false), ReferenceItemFitsInSlot(player, slot, itemSize))
+				    << "run " << run << " cursor " << cursor << " slot " << slot;
+			}
+		}
+	}
+	clear_inventory();
+}
+
+TEST(Inv, AutoPlaceItemInInventory_order)
+{
+	Player &player = Players[MyPlayerId];
+	clear_inventory();
+
+	// Small items fill the bottom row first
+	Item potion {};
+	InitializeItem(potion, IDI_FULLMANA);
+	EXPECT_TRUE(AutoPlaceItemInInventory(player, potion, true));
+	EXPECT_EQ(player.InvGrid[30], 1);
+
+	// Two wide items start at the right edge
+	Item suit {};
+	InitializeItem(suit, IDI_GREYSUIT);
+	EXPECT_TRUE(AutoPlaceItemInInventory(player, suit, true));
+	EXPECT_EQ(player.InvGrid[8], -2);
+	EXPECT_EQ(player.InvGrid[18], 2);
+
+	// A full inventory takes nothing
+	for (int8_t &cell : player.InvGrid)
+		cell = -1;
+	EXPECT_FALSE(AutoPlaceItemInInventory(player, potion, false));
+	clear_inventory();
+}
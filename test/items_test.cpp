@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "engine/random.hpp"
+#include "items.h"
+#include "multi.h"
+#include "player.h"
+#include "stores.h"
+
+using namespace devilution;
+
+namespace {
+
+/** @return Hash of the items a store offers, changes whenever a different item is rolled. */
+uint32_t StockHash(const Item *items, int count)
+{
+	uint32_t hash = 0;
+	for (int i = 0; i < count; i++) {
+		hash = hash * 31 + static_cast<uint32_t>(items[i]._iSeed);
+		hash = hash * 31 + static_cast<uint32_t>(items[i].IDidx);
+		hash = hash * 31 + static_cast<uint32_t>(items[i]._iIvalue);
+	}
+	return hash;
+}
+
+void SetUpGame(bool hellfire, bool multiplayer)
+{
+	gbIsHellfire = hellfire;
+	gbIsMultiplayer = multiplayer;
+	gbIsSpawn = false;
+	MyPlayerId = 0;
+	MyPlayer = &Players[MyPlayerId];
+	CreatePlayer(MyPlayerId, HeroClass::Warrior);
+	MyPlayer->_pLevel = 30;
+}
+
+struct StockHashes {
+	uint32_t smith;
+	uint32_t witch;
+	uint32_t healer;
+	uint32_t premium;
+};
+
+/** @brief Restocks the stores for every level with fixed seeds, the way entering town does. */
+StockHashes RestockStores()
+{
+	StockHashes hashes {};
+	for (int lvl = 1; lvl <= 16; lvl++) {
+		SetRndSeed(lvl * 7919);
+		SpawnSmith(lvl);
+		hashes.smith = hashes.smith * 31 + StockHash(smithitem, SMITH_ITEMS);
+		// The spell table of this game lacks the Hellfire staff spells, the witch can't stock Hellfire staves
+		if (!gbIsHellfire) {
+			SetRndSeed(lvl * 7919);
+			SpawnWitch(lvl);
+			hashes.witch = hashes.witch * 31 + StockHash(witchitem, WITCH_ITEMS);
+		}
+		SetRndSeed(lvl * 7919);
+		SpawnHealer(lvl);
+		hashes.healer = hashes.healer * 31 + StockHash(healitem, 20);
+	}
+	for (int plvl = 1; plvl <= 50; plvl += 7) {
+		MyPlayer->_pLevel = plvl;
+		numpremium = 0;
+		premiumlevel = 1;
+		for (Item &item : premiumitems)
+			item.Clear();
+		SetRndSeed(plvl * 7919);
+		SpawnPremium(MyPlayerId);
+		hashes.premium = hashes.premium * 31 + StockHash(premiumitems, SMITH_PREMIUM_ITEMS);
+	}
+	return hashes;
+}
+
+// The expected hashes were taken from the stores before they kept candidate lists, which
+// scanned all of AllItemsList for every roll. The game modes run one after another, so the
+// lists of one mode have to be dropped for the next.
+TEST(Items, VendorStockMatchesFullScan)
+{
+	const struct {
+		bool hellfire;
+		bool multiplayer;
+		StockHashes expected;
+	} modes[] = {
+		{ false, false, { 0xa53c82b1, 0xe61a41dd, 0xafd2c901, 0xe83ce828 } },
+		{ true, false, { 0x5acf7d79, 0x00000000, 0x46419c80, 0x10ab22a0 } },
+		{ false, true, { 0xcf8706b1, 0xc758a142, 0xa97a6877, 0x7712005f } },
+		{ true, true, { 0x846f6eb9, 0x00000000, 0x7243f5b6, 0xe1543ea6 } },
+	};
+	for (const auto &mode : modes) {
+		SetUpGame(mode.hellfire, mode.multiplayer);
+		const StockHashes hashes = RestockStores();
+		EXPECT_EQ(hashes.smith, mode.expected.smith) << "Hellfire " << mode.hellfire << " multiplayer " << mode.multiplayer;
+		EXPECT_EQ(hashes.witch, mode.expected.witch) << "Hellfire " << mode.hellfire << " multiplayer " << mode.multiplayer;
+		EXPECT_EQ(hashes.healer, mode.expected.healer) << "Hellfire " << mode.hellfire << " multiplayer " << mode.multiplayer;
+		EXPECT_EQ(hashes.premium, mode.expected.premium) << "Hellfire " << mode.hellfire << " multiplayer " << mode.multiplayer;
+	}
+}
+
+// The single player Hellfire healer only stocks elixirs for attributes the hero can still raise
+TEST(Items, HealerStockFollowsElixirCaps)
+{
+	SetUpGame(true, false);
+	const CharacterAttribute attributes[] = {
+		CharacterAttribute::Strength,
+		CharacterAttribute::Magic,
+		CharacterAttribute::Dexterity,
+		CharacterAttribute::Vitality,
+	};
+	int *const baseValues[] = { &MyPlayer->_pBaseStr, &MyPlayer->_pBaseMag, &MyPlayer->_pBaseDex, &MyPlayer->_pBaseVit };
+
+	uint32_t hash = 0;
+	// Gray code order, so that every step caps or uncaps one attribute of the previous one
+	for (unsigned step = 0; step < 16; step++) {
+		const unsigned capped = step ^ (step >> 1);
+		for (int i = 0; i < 4; i++)
+			*baseValues[i] = (capped & (1U << i)) != 0 ? MyPlayer->GetMaximumAttributeValue(attributes[i]) : 10;
+		for (int lvl = 1; lvl <= 16; lvl += 3) {
+			SetRndSeed(lvl * 7919 + step);
+			SpawnHealer(lvl);
+			hash = hash * 31 + StockHash(healitem, 20);
+		}
+	}
+	EXPECT_EQ(hash, 0x8f1a023c);
+}
+
+/** @brief Rolls every base item at every level the way a drop on the dungeon floor does. */
+uint32_t RollAffixes(bool hellfire)
+{
+	const uint16_t upers[] = { 0, CF_UPER15, CF_UPER1, CF_ONLYGOOD, CF_UPER15 | CF_ONLYGOOD, CF_UPER1 | CF_ONLYGOOD };
+	uint32_t hash = 0;
+	for (int idx = 0; idx < IDI_LAST; idx++) {
+		const ItemData &baseItem = AllItemsList[idx];
+		if (baseItem.iRnd == IDROP_NEVER)
+			continue;
+		// Only equipment gets affixes
+		if (!IsAnyOf(baseItem.iClass, ICLASS_WEAPON, ICLASS_ARMOR) && !IsAnyOf(baseItem.iLoc, ILOC_RING, ILOC_AMULET))
+			continue;
+		// The spell table of this game lacks the Hellfire staff spells
+		if (hellfire && baseItem.itype == ItemType::Staff)
+			continue;
+		for (int lvl = 1; lvl <= CF_LEVEL; lvl += 2) {
+			for (uint16_t uper : upers) {
+				Item item;
+				RecreateItem(item, idx, lvl | uper, idx * 7919 + lvl, 0, hellfire);
+				hash = hash * 31 + static_cast<uint32_t>(item._iPrePower);
+				hash = hash * 31 + static_cast<uint32_t>(item._iSufPower);
+				hash = hash * 31 + static_cast<uint32_t>(item._iIvalue);
+				hash = hash * 31 + GetLCGEngineState();
+			}
+		}
+	}
+	return hash;
+}
+
+// The expected hashes were taken from GetItemPower and GetStaffPower before they kept candidate
+// lists, an affix picked from a list in a different order or with a different weight changes them.
+TEST(Items, AffixRollsMatchFullScan)
+{
+	SetUpGame(false, false);
+	EXPECT_EQ(RollAffixes(false), 0xb58dea85);
+	SetUpGame(true, false);
+	EXPECT_EQ(RollAffixes(true), 0x615cf35c);
+}
+
+// The spell table of this game lacks the Hellfire spells, so only Diablo books are checked. Single
+// player skips the multiplayer only spells, which shifts the picks.
+TEST(Items, RollSpellBookMatchesSetupAllItems)
+{
+	for (bool multiplayer : { false, true }) {
+		SetUpGame(false, multiplayer);
+		for (int idx = 0; idx < IDI_LAST; idx++) {
+			if (AllItemsList[idx].iMiscId != IMISC_BOOK)
+				continue;
+			for (int lvl = 2; lvl <= CF_LEVEL; lvl += 2) {
+				for (int iseed = 1; iseed <= 200; iseed++) {
+					const spell_id spell = RollSpellBook(idx, iseed, lvl, 1, true);
+					const uint32_t rollState = GetLCGEngineState();
+					Item item;
+					RecreateItem(item, idx, lvl | CF_UPER1 | CF_ONLYGOOD, iseed, 0, false);
+					if (spell == SPL_INVALID)
+						continue; // The book could become a unique, CreateSpellBook generates it in full
+					EXPECT_EQ(spell, item._iSpell) << "Multiplayer " << multiplayer << " seed " << iseed << " level " << lvl;
+					EXPECT_EQ(rollState, GetLCGEngineState()) << "Multiplayer " << multiplayer << " seed " << iseed << " level " << lvl;
+				}
+			}
+		}
+	}
+}
+
+TEST(Items, RollSpellBookOnlyReplaysOnlyGoodBooks)
+{
+	SetUpGame(false, false);
+	int idx = 0;
+	while (AllItemsList[idx].iMiscId != IMISC_BOOK)
+		idx++;
+	EXPECT_NE(RollSpellBook(idx, 1, 2, 1, true), SPL_INVALID);
+	EXPECT_EQ(RollSpellBook(idx, 1, 2, 1, false), SPL_INVALID);
+	EXPECT_EQ(RollSpellBook(idx, 1, 2, 15, true), SPL_INVALID);
+	EXPECT_EQ(RollSpellBook(idx, 1, 2, 0, true), SPL_INVALID);
+}
+
+} // namespace
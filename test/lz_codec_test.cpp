@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "utils/lz_codec.hpp"
+
+using namespace devilution;
+
+namespace {
+
+std::vector<byte> RoundTrip(const std::vector<byte> &data, size_t *compressedSize = nullptr)
+{
+	std::vector<byte> compressed(LzCompressBound(data.size()));
+	const size_t size = LzCompress(data.data(), data.size(), compressed.data(), compressed.size());
+	EXPECT_NE(size, 0);
+	if (compressedSize != nullptr)
+		*compressedSize = size;
+
+	std::vector<byte> result(data.size());
+	std::optional<size_t> resultSize = LzDecompress(compressed.data(), size, result.data(), result.size());
+	EXPECT_TRUE(resultSize);
+	if (resultSize)
+		result.resize(*resultSize);
+	return result;
+}
+
+} // namespace
+
+TEST(LzCodec, RoundTripSmall)
+{
+	std::vector<byte> data { byte { 1 }, byte { 2 }, byte { 3 } };
+	EXPECT_EQ(RoundTrip(data), data);
+}
+
+TEST(LzCodec, RoundTripSparseDelta)
+{
+	// Mostly empty records marked with 0xFF, as produced by DeltaExportData
+	std::vector<byte> data(6000, byte { 0xFF });
+	for (size_t i = 0; i < data.size(); i += 97)
+		data[i] = static_cast<byte>(i);
+
+	size_t compressedSize;
+	EXPECT_EQ(RoundTrip(data, &compressedSize), data);
+	EXPECT_LT(compressedSize, data.size() / 10);
+}
+
+TEST(LzCodec, RoundTripIncompressible)
+{
+	std::vector<byte> data(4096);
+	uint32_t seed = 1;
+	for (byte &value : data) {
+		seed = seed * 22695477 + 1;
+		value = static_cast<byte>(seed >> 16);
+	}
+	EXPECT_EQ(RoundTrip(data), data);
+}
+
+TEST(LzCodec, CompressFailsWhenCapacityTooSmall)
+{
+	std::vector<byte> data(256);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<byte>(i);
+
+	std::vector<byte> compressed(data.size() / 2);
+	EXPECT_EQ(LzCompress(data.data(), data.size(), compressed.data(), compressed.size()), 0);
+}
+
+TEST(LzCodec, DecompressRejectsInvalidOffset)
+{
+	// Token with one literal and a match, followed by an offset pointing before the start of the output
+	const byte compressed[] { byte { 0x10 }, byte { 'a' }, byte { 0x05 }, byte { 0x00 } };
+	byte result[32];
+	EXPECT_FALSE(LzDecompress(compressed, sizeof(compressed), result, sizeof(result)));
+}
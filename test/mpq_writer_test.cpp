@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "mpq/mpq_reader.hpp"
+#include "mpq/mpq_writer.hpp"
+
+using namespace devilution;
+
+namespace {
+
+std::vector<byte> MakeSaveLikeData(size_t size)
+{
+	// Runs of repeated values broken up by noise, so some sectors compress well and some do not
+	std::vector<byte> data(size);
+	uint32_t seed = 1;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 22695477 + 1;
+		data[i] = (i / 4096) % 3 == 0 ? static_cast<byte>(seed >> 16) : static_cast<byte>(i / 64);
+	}
+	return data;
+}
+
+std::vector<byte> WriteAndReadBack(const char *path, const std::vector<byte> &data, MpqCompression compression = MpqCompression::PkwareImplode)
+{
+	std::remove(path);
+	{
+		MpqWriter writer;
+		writer.SetCompression(compression);
+		EXPECT_TRUE(writer.Open(path));
+		EXPECT_TRUE(writer.WriteFile("hero", data.data(), data.size()));
+	}
+
+	int32_t error = 0;
+	std::optional<MpqArchive> archive = MpqArchive::Open(path, error);
+	EXPECT_TRUE(archive) << MpqArchive::ErrorMessage(error);
+	if (!archive)
+		return {};
+
+	size_t size;
+	std::unique_ptr<byte[]> contents = archive->ReadFile("hero", size, error);
+	EXPECT_NE(contents, nullptr) << MpqArchive::ErrorMessage(error);
+	if (contents == nullptr)
+		return {};
+	return { contents.get(), contents.get() + size };
+}
+
+} // namespace
+
+TEST(MpqWriter, RoundTripSingleSector)
+{
+	std::vector<byte> data = MakeSaveLikeData(1000);
+	EXPECT_EQ(WriteAndReadBack("Test_MpqWriter_RoundTripSingleSector.sv", data), data);
+	std::remove("Test_MpqWriter_RoundTripSingleSector.sv");
+}
+
+TEST(MpqWriter, RoundTripManySectors)
+{
+	// Large enough for the sectors to be spread over several threads, and not a multiple of the sector size
+	std::vector<byte> data = MakeSaveLikeData(200 * 4096 + 123);
+	EXPECT_EQ(WriteAndReadBack("Test_MpqWriter_RoundTripManySectors.sv", data), data);
+	std::remove("Test_MpqWriter_RoundTripManySectors.sv");
+}
+
+TEST(MpqWriter, RoundTripZlib)
+{
+	// Covers both compressed sectors and the noisy ones that end up stored as is
+	std::vector<byte> data = MakeSaveLikeData(20 * 4096 + 123);
+	EXPECT_EQ(WriteAndReadBack("Test_MpqWriter_RoundTripZlib.sv", data, MpqCompression::Zlib), data);
+	std::remove("Test_MpqWriter_RoundTripZlib.sv");
+}
+
+TEST(MpqWriter, RoundTripSeveralLargeFiles)
+{
+	// The second file is compressed by the worker threads the first one started
+	const char *path = "Test_MpqWriter_RoundTripSeveralLargeFiles.sv";
+	std::remove(path);
+	const std::vector<byte> first = MakeSaveLikeData(100 * 4096 + 1);
+	const std::vector<byte> second = MakeSaveLikeData(150 * 4096 + 2);
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path));
+		ASSERT_TRUE(writer.WriteFile("first", first.data(), first.size()));
+		ASSERT_TRUE(writer.WriteFile("second", second.data(), second.size()));
+	}
+
+	int32_t error = 0;
+	std::optional<MpqArchive> archive = MpqArchive::Open(path, error);
+	ASSERT_TRUE(archive) << MpqArchive::ErrorMessage(error);
+	for (const auto &file : { std::make_pair("first", &first), std::make_pair("second", &second) }) {
+		size_t size;
+		std::unique_ptr<byte[]> contents = archive->ReadFile(file.first, size, error);
+		ASSERT_NE(contents, nullptr) << MpqArchive::ErrorMessage(error);
+		EXPECT_EQ(std::vector<byte>(contents.get(), contents.get() + size), *file.second);
+	}
+	archive = std::nullopt;
+	std::remove(path);
+}
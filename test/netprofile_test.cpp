@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "netprofile.h"
+#include "nthread.h"
+#include "player.h"
+#include "storm/storm_net.hpp"
+#include "utils/paths.h"
+
+using namespace devilution;
+
+TEST(NetProfile, CountsCommandsAndPackets)
+{
+	MyPlayerId = 0;
+	Players[1].plractive = true;
+	Players[2].plractive = false;
+	Players[3].plractive = true;
+	gdwNormalMsgSize = 100;
+
+	netprofile::EnableProfiling();
+	netprofile::Start();
+
+	const byte walk[] { static_cast<byte>(CMD_WALKXY), byte { 1 }, byte { 2 } };
+	netprofile::RecordSentCommand(walk, sizeof(walk));
+	netprofile::RecordSentCommand(walk, sizeof(walk));
+	netprofile::RecordReceivedCommand(walk, sizeof(walk));
+
+	byte packet[55] {};
+	netprofile::RecordSentPacket(SNPLAYER_OTHERS, packet, sizeof(packet));
+	netprofile::RecordSentPacket(1, packet, 5);
+	netprofile::RecordReceivedPacket(3, packet, 20);
+
+	const netprofile::TrafficStats &stats = netprofile::GetStats();
+	EXPECT_EQ(stats.sentCommands[CMD_WALKXY].count, 2);
+	EXPECT_EQ(stats.sentCommands[CMD_WALKXY].bytes, 6);
+	EXPECT_EQ(stats.receivedCommands[CMD_WALKXY].count, 1);
+
+	EXPECT_EQ(stats.sentPackets[0].count, 0) << "Packets sent to oneself are not network traffic";
+	EXPECT_EQ(stats.sentPackets[1].count, 2);
+	EXPECT_EQ(stats.sentPackets[1].bytes, 60);
+	EXPECT_EQ(stats.sentPackets[2].count, 0) << "Inactive players do not receive broadcasts";
+	EXPECT_EQ(stats.sentPackets[3].bytes, 55);
+	EXPECT_EQ(stats.receivedPackets[3].bytes, 20);
+
+	EXPECT_EQ(stats.packetFill[5], 1);
+	EXPECT_EQ(stats.packetFill[0], 1);
+	EXPECT_EQ(stats.peakSentBytesPerSecond, 115);
+	EXPECT_EQ(stats.peakReceivedBytesPerSecond, 20);
+
+	netprofile::Stop();
+}
+
+TEST(NetProfile, ReplaysCapturedPackets)
+{
+	paths::SetPrefPath(".");
+	MyPlayerId = 1;
+	netprofile::InitCapture(9);
+	netprofile::Start();
+
+	const byte fromHost[] { byte { 1 }, byte { 2 }, byte { 3 } };
+	const byte fromThird[] { byte { 4 }, byte { 5 } };
+	netprofile::RecordReceivedPacket(0, fromHost, sizeof(fromHost));
+	netprofile::RecordSentPacket(0, fromThird, sizeof(fromThird));
+	netprofile::RecordReceivedPacket(2, fromThird, sizeof(fromThird));
+	netprofile::Stop();
+
+	// The local player of a loopback game is always the first player
+	MyPlayerId = 0;
+	netprofile::InitReplay(9);
+
+	std::vector<std::pair<int, std::vector<byte>>> replayed;
+	const uint32_t start = SDL_GetTicks();
+	while (replayed.size() < 2 && SDL_GetTicks() - start < 1000) {
+		int sender;
+		void *data;
+		uint32_t size;
+		if (!netprofile::FetchReplayPacket(&sender, &data, &size)) {
+			SDL_Delay(1);
+			continue;
+		}
+		const auto *bytes = static_cast<const byte *>(data);
+		replayed.emplace_back(sender, std::vector<byte>(bytes, bytes + size));
+	}
+	std::remove((paths::PrefPath() + "netcapture_9.ncp").c_str());
+
+	ASSERT_EQ(replayed.size(), 2) << "Only received packets are replayed";
+	EXPECT_EQ(replayed[0].first, 1) << "Packets of the player in our slot move to the recording player's slot";
+	EXPECT_EQ(replayed[0].second, std::vector<byte>(std::begin(fromHost), std::end(fromHost)));
+	EXPECT_EQ(replayed[1].first, 2);
+	EXPECT_EQ(replayed[1].second, std::vector<byte>(std::begin(fromThird), std::end(fromThird)));
+
+	int sender;
+	void *data;
+	uint32_t size;
+	EXPECT_FALSE(netprofile::FetchReplayPacket(&sender, &data, &size));
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "dvlnet/packet.h"
+
+using namespace devilution;
+using namespace devilution::net;
+
+namespace {
+
+std::atomic<bool> CountAllocations;
+std::atomic<size_t> Allocations;
+std::atomic<size_t> Deallocations;
+
+buffer_t MakePayload(size_t size)
+{
+	buffer_t payload(size);
+	for (size_t i = 0; i < size; i++)
+		payload[i] = static_cast<unsigned char>(i * 7);
+	return payload;
+}
+
+/** @brief Sends a message through a packet and parses it again, like one player sending it to another. */
+bool RoundTrip(packet_factory &factory, const buffer_t &payload)
+{
+	buffer_t message = AcquireBuffer();
+	message.assign(payload.begin(), payload.end());
+	auto sent = factory.make_packet<PT_MESSAGE>(plr_t { 0 }, plr_t { 1 }, std::move(message));
+
+	buffer_t received = AcquireBuffer();
+	received.assign(sent->Data().begin(), sent->Data().end());
+	auto pkt = factory.make_packet(std::move(received));
+
+	return pkt->Type() == PT_MESSAGE && pkt->Source() == 0 && pkt->Destination() == 1 && pkt->Message() == payload;
+}
+
+} // namespace
+
+void *operator new(size_t size)
+{
+	if (CountAllocations)
+		Allocations++;
+	void *ptr = std::malloc(size != 0 ? size : 1);
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	if (CountAllocations && ptr != nullptr)
+		Deallocations++;
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	if (CountAllocations && ptr != nullptr)
+		Deallocations++;
+	std::free(ptr);
+}
+
+TEST(Packet, MessageRoundTrip)
+{
+	packet_factory factory;
+	const buffer_t payload = MakePayload(300);
+	EXPECT_TRUE(RoundTrip(factory, payload));
+}
+
+TEST(Packet, TurnRoundTrip)
+{
+	packet_factory factory;
+	auto sent = factory.make_packet<PT_TURN>(plr_t { 2 }, PLR_BROADCAST, turn_t { 5, 12345 });
+	auto pkt = factory.make_packet(sent->Data());
+	EXPECT_EQ(pkt->Type(), PT_TURN);
+	EXPECT_EQ(pkt->Source(), 2);
+	EXPECT_EQ(pkt->Destination(), PLR_BROADCAST);
+	EXPECT_EQ(pkt->Turn().SequenceNumber, 5);
+	EXPECT_EQ(pkt->Turn().Value, 12345);
+}
+
+TEST(Packet, RejectsTruncatedPacket)
+{
+	packet_factory factory;
+	auto sent = factory.make_packet<PT_TURN>(plr_t { 2 }, PLR_BROADCAST, turn_t { 5, 12345 });
+	buffer_t truncated = sent->Data();
+	truncated.pop_back();
+	EXPECT_THROW(factory.make_packet(std::move(truncated)), packet_exception);
+}
+
+TEST(Packet, SteadyStateDoesNotAllocate)
+{
+	packet_factory factory;
+	const buffer_t payload = MakePayload(300);
+
+	// Fill the buffer and packet pools
+	for (int i = 0; i < 10; i++)
+		ASSERT_TRUE(RoundTrip(factory, payload));
+
+	bool ok = true;
+	Allocations = 0;
+	CountAllocations = true;
+	for (int i = 0; i < 100; i++)
+		ok = RoundTrip(factory, payload) && ok;
+	CountAllocations = false;
+
+	EXPECT_TRUE(ok);
+	EXPECT_EQ(Allocations, 0);
+}
+
+TEST(Packet, PoolIsFreedWhenThreadExits)
+{
+	const buffer_t payload = MakePayload(300);
+	bool ok = false;
+
+	Allocations = 0;
+	Deallocations = 0;
+	CountAllocations = true;
+	std::thread thread([&]() {
+		packet_factory factory;
+		ok = true;
+		for (int i = 0; i < 10; i++)
+			ok = RoundTrip(factory, payload) && ok;
+	});
+	thread.join();
+	CountAllocations = false;
+
+	EXPECT_TRUE(ok);
+	EXPECT_GT(Allocations, 0);
+	EXPECT_EQ(Allocations, Deallocations);
+}
+
+#ifdef PACKET_ENCRYPTION
+TEST(Packet, EncryptedRoundTrip)
+{
+	packet_factory factory("password");
+	const buffer_t payload = MakePayload(300);
+	EXPECT_TRUE(RoundTrip(factory, payload));
+
+	auto sent = factory.make_packet<PT_MESSAGE>(plr_t { 0 }, plr_t { 1 }, payload);
+	const buffer_t &data = sent->Data();
+	EXPECT_EQ(std::search(data.begin(), data.end(), payload.begin(), payload.begin() + 16), data.end());
+
+	packet_factory wrongPassword("wrong password");
+	EXPECT_THROW(wrongPassword.make_packet(data), packet_exception);
+}
+
+TEST(Packet, EncryptedSteadyStateDoesNotAllocate)
+{
+	packet_factory factory("password");
+	const buffer_t payload = MakePayload(300);
+
+	// Fill the buffer and packet pools
+	for (int i = 0; i < 10; i++)
+		ASSERT_TRUE(RoundTrip(factory, payload));
+
+	bool ok = true;
+	Allocations = 0;
+	CountAllocations = true;
+	for (int i = 0; i < 100; i++)
+		ok = RoundTrip(factory, payload) && ok;
+	CountAllocations = false;
+
+	EXPECT_TRUE(ok);
+	EXPECT_EQ(Allocations, 0);
+}
+#endif
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "utils/perfect_hash.hpp"
+
+using namespace devilution;
+
+TEST(PerfectHash, FindsEveryKey)
+{
+	std::vector<std::string> strings;
+	for (int i = 0; i < 5000; i++)
+		strings.push_back("key " + std::to_string(i));
+	strings.emplace_back("");
+
+	PerfectHashIndex index;
+	index.Build({ strings.begin(), strings.end() });
+	EXPECT_EQ(index.size(), strings.size());
+
+	for (size_t i = 0; i < strings.size(); i++)
+		ASSERT_EQ(index.Find(strings[i]), static_cast<int>(i)) << strings[i];
+
+	EXPECT_EQ(index.Find("key 5000"), -1);
+	EXPECT_EQ(index.Find("key"), -1);
+	EXPECT_EQ(index.Find("key 12 "), -1);
+}
+
+TEST(PerfectHash, FindsConcatenation)
+{
+	const std::vector<string_view> keys { "Hello", "menu\004Hello", "menu\004Quit" };
+	PerfectHashIndex index;
+	index.Build(keys);
+
+	EXPECT_EQ(index.Find({ "menu", "\004", "Hello" }), 1);
+	EXPECT_EQ(index.Find({ "menu", "\004", "Quit" }), 2);
+	EXPECT_EQ(index.Find({ "men", "u\004Hel", "lo" }), 1);
+	EXPECT_EQ(index.Find({ "menu", "\004", "Hello!" }), -1);
+	EXPECT_EQ(index.Find({ "", "Hello" }), 0);
+}
+
+TEST(PerfectHash, KeepsFirstOfDuplicates)
+{
+	const std::vector<string_view> keys { "a", "b", "a" };
+	PerfectHashIndex index;
+	index.Build(keys);
+
+	EXPECT_EQ(index.size(), 2);
+	EXPECT_EQ(index.Find("a"), 0);
+	EXPECT_EQ(index.Find("b"), 1);
+}
+
+TEST(PerfectHash, Empty)
+{
+	PerfectHashIndex index;
+	EXPECT_EQ(index.Find("a"), -1);
+	index.Build({});
+	EXPECT_EQ(index.Find(""), -1);
+}
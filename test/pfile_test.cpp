@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "codec.h"
+#include "pfile.h"
+#include "utils/file_util.h"
+#include "utils/paths.h"
+
+using namespace devilution;
+
+namespace {
+
+std::vector<byte> MakeLevel(int seed)
+{
+	std::vector<byte> level(20000, byte { 0 });
+	for (size_t i = 0; i < level.size(); i += 7)
+		level[i] = static_cast<byte>(i + seed);
+	return level;
+}
+
+void CacheLevel(const char *name, const std::vector<byte> &level)
+{
+	std::unique_ptr<byte[]> data { new byte[codec_get_encoded_len(level.size())] };
+	memcpy(data.get(), level.data(), level.size());
+	SaveSnapshot snapshot;
+	snapshot.AddFile(name, std::move(data), level.size());
+	pfile_cache_levels(snapshot);
+}
+
+std::vector<byte> ReadCachedLevel(const char *name)
+{
+	size_t size;
+	std::unique_ptr<byte[]> data = pfile_read_cached_level(name, &size);
+	if (data == nullptr)
+		return {};
+	return { data.get(), data.get() + size };
+}
+
+std::vector<_uiheroinfo> ListedHeroes;
+
+bool AddHeroInfo(_uiheroinfo *heroInfo)
+{
+	ListedHeroes.push_back(*heroInfo);
+	return true;
+}
+
+class LevelCacheTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		paths::SetPrefPath(".");
+		std::remove("single_0.sv");
+		gbIsHellfire = false;
+		gbIsMultiplayer = false;
+		gbIsSpawn = false;
+		pfile_remove_temp_files();
+	}
+
+	void TearDown() override
+	{
+		pfile_remove_temp_files();
+		std::remove("single_0.sv");
+	}
+};
+
+} // namespace
+
+TEST_F(LevelCacheTest, RoundTrip)
+{
+	const std::vector<byte> level = MakeLevel(1);
+	CacheLevel("templ01", level);
+	EXPECT_EQ(ReadCachedLevel("templ01"), level);
+	EXPECT_EQ(pfile_read_cached_level("templ02", nullptr), nullptr);
+}
+
+TEST_F(LevelCacheTest, KeepsLatestVersion)
+{
+	CacheLevel("templ01", MakeLevel(1));
+	const std::vector<byte> level = MakeLevel(2);
+	CacheLevel("templ01", level);
+	EXPECT_EQ(ReadCachedLevel("templ01"), level);
+}
+
+TEST_F(LevelCacheTest, RemovingTempFilesClearsCache)
+{
+	CacheLevel("templ01", MakeLevel(1));
+	pfile_remove_temp_files();
+	EXPECT_EQ(pfile_read_cached_level("templ01", nullptr), nullptr);
+}
+
+TEST_F(LevelCacheTest, WritesEvictedLevelsToArchive)
+{
+	const std::vector<byte> first = MakeLevel(1);
+	CacheLevel("templ01", first);
+	for (int i = 2; i <= 16; i++) {
+		char name[8];
+		sprintf(name, "templ%02d", i);
+		CacheLevel(name, MakeLevel(i));
+	}
+	EXPECT_EQ(pfile_read_cached_level("templ01", nullptr), nullptr);
+	EXPECT_EQ(ReadCachedLevel("templ16"), MakeLevel(16));
+
+	std::optional<MpqArchive> archive = OpenSaveArchive(0);
+	ASSERT_TRUE(archive);
+	size_t size;
+	std::unique_ptr<byte[]> data = ReadArchive(*archive, "templ01", &size);
+	ASSERT_NE(data, nullptr);
+	EXPECT_EQ(std::vector<byte>(data.get(), data.get() + size), first);
+}
+
+TEST(HeroIndex, ListsHeroesFromIndex)
+{
+	paths::SetPrefPath(".");
+	std::remove("multi_0.sv");
+	std::remove("multi_heroes.idx");
+
+	gbVanilla = true;
+	gbIsHellfire = false;
+	gbIsMultiplayer = true;
+	gbIsSpawn = false;
+	MyPlayerId = 0;
+	MyPlayer = &Players[MyPlayerId];
+
+	_uiheroinfo created {};
+	created.saveNumber = 0;
+	strcpy(created.name, "IndexedHero");
+	created.heroclass = HeroClass::Sorcerer;
+	ASSERT_TRUE(pfile_ui_save_create(&created));
+	EXPECT_TRUE(FileExists("multi_heroes.idx"));
+
+	ListedHeroes.clear();
+	pfile_ui_set_hero_infos(AddHeroInfo);
+	ASSERT_EQ(ListedHeroes.size(), 1);
+	const _uiheroinfo &listed = ListedHeroes[0];
+	EXPECT_EQ(listed.saveNumber, 0);
+	EXPECT_STREQ(listed.name, "IndexedHero");
+	EXPECT_EQ(listed.heroclass, HeroClass::Sorcerer);
+	EXPECT_EQ(listed.level, created.level);
+	EXPECT_EQ(listed.strength, created.strength);
+	EXPECT_EQ(listed.magic, created.magic);
+	EXPECT_EQ(listed.dexterity, created.dexterity);
+	EXPECT_EQ(listed.vitality, created.vitality);
+	EXPECT_FALSE(listed.hassaved);
+
+	pfile_delete_save(&created);
+	ListedHeroes.clear();
+	pfile_ui_set_hero_infos(AddHeroInfo);
+	EXPECT_TRUE(ListedHeroes.empty());
+
+	std::remove("multi_heroes.idx");
+}
+
+namespace {
+
+void WriteEncodedFile(const char *path, const std::vector<byte> &contents, const char *password)
+{
+	std::remove(path);
+	std::unique_ptr<byte[]> data { new byte[codec_get_encoded_len(contents.size())] };
+	memcpy(data.get(), contents.data(), contents.size());
+	SaveSnapshot snapshot;
+	snapshot.AddFile("levels", std::move(data), contents.size());
+
+	MpqWriter writer;
+	ASSERT_TRUE(writer.Open(path));
+	ASSERT_TRUE(snapshot.WriteTo(writer, password));
+}
+
+MpqArchive OpenTestArchive(const char *path)
+{
+	int32_t error;
+	std::optional<MpqArchive> archive = MpqArchive::Open(path, error);
+	EXPECT_TRUE(archive);
+	return std::move(*archive);
+}
+
+} // namespace
+
+TEST(SaveFileReader, MatchesWholeFileRead)
+{
+	gbIsMultiplayer = false;
+	gbIsSpawn = false;
+
+	// Spans several sectors and ends in a partial chunk
+	const std::vector<byte> contents = MakeLevel(3);
+	WriteEncodedFile("Test_SaveFileReader.sv", contents, pfile_get_password());
+
+	SaveFileReader reader(OpenTestArchive("Test_SaveFileReader.sv"), "levels");
+	std::vector<byte> streamed;
+	while (const byte *data = reader.Peek(7)) {
+		streamed.insert(streamed.end(), data, data + 7);
+		reader.Skip(7);
+	}
+	while (const byte *data = reader.Peek(1)) {
+		streamed.push_back(*data);
+		reader.Skip(1);
+	}
+	EXPECT_TRUE(reader.Finish());
+	EXPECT_EQ(streamed, contents);
+
+	std::remove("Test_SaveFileReader.sv");
+}
+
+TEST(SaveFileReader, DetectsWrongPassword)
+{
+	gbIsMultiplayer = false;
+	gbIsSpawn = false;
+
+	WriteEncodedFile("Test_SaveFileReader.sv", MakeLevel(4), "not the save password");
+
+	SaveFileReader reader(OpenTestArchive("Test_SaveFileReader.sv"), "levels");
+	// The first sector decodes to garbage, the signature in the last one does not match
+	EXPECT_NE(reader.Peek(16), nullptr);
+	EXPECT_FALSE(reader.Finish());
+	EXPECT_EQ(reader.Peek(1), nullptr);
+
+	std::remove("Test_SaveFileReader.sv");
+}
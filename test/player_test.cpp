@@ -184,3 +184,26 @@ TEST(Player, CreatePlayer)
 	CreatePlayer(0, HeroClass::Rogue);
 	AssertPlayer(Players[0]);
 }
+
+TEST(Player, DerivedStatsFollowDirtyFlags)
+{
+	CreatePlayer(0, HeroClass::Warrior);
+	Player &player = Players[0];
+	CalcPlrInv(player, false);
+	EXPECT_EQ(player.statsDirty, PlayerStatsDirty::None);
+	const int strength = player._pStrength;
+
+	player._pBaseStr += 10;
+	CalcPlrInv(player, false);
+	EXPECT_EQ(player._pStrength, strength);
+
+	// Backpack items don't add to the attributes
+	player.MarkStatsDirty(PlayerStatsDirty::Inventory);
+	CalcPlrInv(player, false);
+	EXPECT_EQ(player._pStrength, strength);
+
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
+	CalcPlrInv(player, false);
+	EXPECT_EQ(player._pStrength, strength + 10);
+	EXPECT_EQ(player.statsDirty, PlayerStatsDirty::None);
+}
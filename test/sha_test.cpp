@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "sha.h"
+
+using namespace devilution;
+
+namespace {
+
+/** @brief The straightforward implementation the optimised one has to match bit for bit. */
+void ReferenceProcessBlock(uint32_t state[SHA1HashSize], const uint32_t data[BlockSize])
+{
+	const auto shift = [](uint32_t word, size_t bits) -> uint32_t {
+		if ((word & (1U << 31)) != 0)
+			return (0xFFFFFFFF << bits) | (word >> (32 - bits));
+		return (word << bits) | (word >> (32 - bits));
+	};
+
+	uint32_t w[80];
+	memcpy(w, data, BlockSize * sizeof(uint32_t));
+	for (int i = 16; i < 80; i++) {
+		w[i] = w[i - 16] ^ w[i - 14] ^ w[i - 8] ^ w[i - 3];
+	}
+
+	uint32_t a = state[0];
+	uint32_t b = state[1];
+	uint32_t c = state[2];
+	uint32_t d = state[3];
+	uint32_t e = state[4];
+
+	for (int i = 0; i < 80; i++) {
+		uint32_t f;
+		uint32_t k;
+		if (i < 20) {
+			f = (b & c) | ((~b) & d);
+			k = 0x5A827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		const uint32_t temp = shift(a, 5) + f + e + w[i] + k;
+		e = d;
+		d = c;
+		c = shift(b, 30);
+		b = a;
+		a = temp;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+uint32_t NextRandom(uint32_t &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) | (seed << 16);
+}
+
+} // namespace
+
+TEST(Sha, MatchesKnownDigest)
+{
+	uint32_t data[BlockSize] = {};
+	SHA1Context context;
+	SHA1Calculate(context, data);
+
+	uint32_t digest[SHA1HashSize];
+	SHA1Result(context, digest);
+	uint32_t expected[SHA1HashSize] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+	ReferenceProcessBlock(expected, data);
+	for (size_t i = 0; i < SHA1HashSize; i++)
+		EXPECT_EQ(digest[i], expected[i]);
+}
+
+TEST(Sha, FuzzMatchesReference)
+{
+	uint32_t seed = 1;
+	for (int run = 0; run < 200; run++) {
+		SHA1Context context;
+		uint32_t expected[SHA1HashSize];
+		memcpy(expected, context.state, sizeof(expected));
+
+		// Chain a few blocks like the codec does, mixing in words with the sign bit set and clear
+		for (int block = 0; block < 16; block++) {
+			uint32_t data[BlockSize];
+			for (uint32_t &word : data) {
+				word = NextRandom(seed);
+				if ((run & 3) == 1)
+					word |= 0x80000000;
+				else if ((run & 3) == 2)
+					word &= 0x7FFFFFFF;
+			}
+
+			SHA1Calculate(context, data);
+			ReferenceProcessBlock(expected, data);
+
+			uint32_t digest[SHA1HashSize];
+			SHA1Result(context, digest);
+			for (size_t i = 0; i < SHA1HashSize; i++)
+				ASSERT_EQ(digest[i], expected[i]) << "run " << run << " block " << block << " word " << i;
+		}
+	}
+}
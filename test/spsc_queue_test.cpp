@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+#include "utils/spsc_queue.hpp"
+
+using namespace devilution;
+
+TEST(SpscQueue, PushPopInOrder)
+{
+	SpscQueue<int, 4> queue;
+	EXPECT_TRUE(queue.empty());
+
+	for (int i = 1; i <= 4; i++) {
+		int value = i;
+		EXPECT_TRUE(queue.try_push(value));
+	}
+	EXPECT_EQ(queue.size(), 4);
+
+	int value = 5;
+	EXPECT_FALSE(queue.try_push(value)) << "Queue should be full";
+	EXPECT_EQ(value, 5);
+
+	for (int i = 1; i <= 4; i++) {
+		EXPECT_TRUE(queue.try_pop(value));
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_FALSE(queue.try_pop(value));
+	EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueue, ReleasesPoppedElements)
+{
+	auto shared = std::make_shared<int>(1);
+	std::weak_ptr<int> weak = shared;
+
+	SpscQueue<std::shared_ptr<int>, 2> sharedQueue;
+	EXPECT_TRUE(sharedQueue.try_push(shared));
+	EXPECT_EQ(shared, nullptr);
+
+	std::shared_ptr<int> popped;
+	EXPECT_TRUE(sharedQueue.try_pop(popped));
+	popped = nullptr;
+	EXPECT_TRUE(weak.expired()) << "The queue should not keep a reference to popped elements";
+}
+
+TEST(SpscQueue, TransfersAcrossThreads)
+{
+	constexpr int Count = 100000;
+	SpscQueue<int, 16> queue;
+
+	std::thread producer([&]() {
+		for (int i = 0; i < Count; i++) {
+			int value = i;
+			while (!queue.try_push(value))
+				std::this_thread::yield();
+		}
+	});
+
+	int expected = 0;
+	while (expected < Count) {
+		int value;
+		if (!queue.try_pop(value)) {
+			std::this_thread::yield();
+			continue;
+		}
+		ASSERT_EQ(value, expected);
+		expected++;
+	}
+	producer.join();
+	EXPECT_TRUE(queue.empty());
+}
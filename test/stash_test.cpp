@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "loadsave.h"
+#include "pfile.h"
+#include "player.h"
+#include "qol/stash.h"
+#include "utils/paths.h"
+
+using namespace devilution;
+
+namespace {
+
+void PlaceItem(unsigned page, Point position, int seed)
+{
+	Item item {};
+	item._itype = ItemType::Misc;
+	item._iSeed = seed;
+	Stash.stashList.push_back(item);
+	Stash.stashGrids[page][position.x][position.y] = static_cast<uint16_t>(Stash.stashList.size());
+	Stash.MarkPageDirty(page);
+}
+
+int SeedAt(unsigned page, Point position)
+{
+	const uint16_t cell = Stash.stashGrids[page][position.x][position.y];
+	if (cell == 0)
+		return -1;
+	return Stash.stashList[cell - 1]._iSeed;
+}
+
+std::vector<std::string> SavedFileNames()
+{
+	SaveSnapshot snapshot;
+	SaveStash(snapshot);
+	std::vector<std::string> names;
+	for (const SaveSnapshot::File &file : snapshot.TakeFiles())
+		names.push_back(file.name);
+	return names;
+}
+
+class StashTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		paths::SetPrefPath(".");
+		std::remove("stash.sv");
+		gbIsHellfire = false;
+		gbIsMultiplayer = false;
+		gbIsSpawn = false;
+		Stash = {};
+	}
+
+	void TearDown() override
+	{
+		Stash = {};
+		std::remove("stash.sv");
+	}
+};
+
+} // namespace
+
+TEST_F(StashTest, SavesOnlyDirtyPages)
+{
+	PlaceItem(0, { 0, 0 }, 1);
+	PlaceItem(3, { 2, 5 }, 2);
+	PlaceItem(7, { 9, 9 }, 3);
+
+	std::vector<std::string> expected { "spstashpage00", "spstashpage03", "spstashpage07", "spstashitems" };
+	EXPECT_EQ(SavedFileNames(), expected);
+
+	Stash.dirtyPages.clear();
+	Stash.MarkPageDirty(3);
+	expected = { "spstashpage03", "spstashitems" };
+	EXPECT_EQ(SavedFileNames(), expected);
+
+	// An emptied page is removed from the archive instead of being written
+	Stash.dirtyPages.clear();
+	Stash.stashGrids[7][9][9] = 0;
+	Stash.MarkPageDirty(7);
+	expected = { "spstashitems" };
+	EXPECT_EQ(SavedFileNames(), expected);
+}
+
+TEST_F(StashTest, RoundTripAfterPartialSave)
+{
+	PlaceItem(0, { 0, 0 }, 1);
+	PlaceItem(3, { 2, 5 }, 2);
+	PlaceItem(3, { 4, 5 }, 3);
+	PlaceItem(7, { 9, 9 }, 4);
+	Stash.gold = 1234;
+	Stash.SetPage(3);
+	sfile_write_stash();
+	EXPECT_FALSE(Stash.dirty);
+	EXPECT_TRUE(Stash.dirtyPages.empty());
+
+	// Only page 7 is rewritten, the other pages have to survive from the first save
+	LoadStash();
+	Stash.stashGrids[7][9][9] = 0;
+	PlaceItem(7, { 1, 1 }, 5);
+	sfile_write_stash();
+
+	LoadStash();
+	EXPECT_EQ(Stash.gold, 1234);
+	EXPECT_EQ(Stash.GetPage(), 3U);
+	EXPECT_EQ(SeedAt(0, { 0, 0 }), 1);
+	EXPECT_EQ(SeedAt(3, { 2, 5 }), 2);
+	EXPECT_EQ(SeedAt(3, { 4, 5 }), 3);
+	EXPECT_EQ(SeedAt(7, { 9, 9 }), -1);
+	EXPECT_EQ(SeedAt(7, { 1, 1 }), 5);
+	EXPECT_TRUE(Stash.dirtyPages.empty());
+}
+
+TEST_F(StashTest, AutoPlaceWrapsAroundPages)
+{
+	Item potion {};
+	InitializeItem(potion, IDI_FULLMANA);
+
+	// Fill the last page except for its bottom right cell
+	Stash.SetPage(99);
+	for (int x = 0; x < 10; x++) {
+		for (int y = 0; y < 10; y++) {
+			if (x != 9 || y != 9)
+				PlaceItem(99, { x, y }, 0);
+		}
+	}
+
+	EXPECT_TRUE(AutoPlaceItemInStash(Players[MyPlayerId], potion, true));
+	EXPECT_EQ(Stash.stashGrids[99][9][9], Stash.stashList.size());
+
+	// The page is full now, the next item has to go to the first page
+	Item suit {};
+	InitializeItem(suit, IDI_GREYSUIT);
+	EXPECT_TRUE(AutoPlaceItemInStash(Players[MyPlayerId], suit, true));
+	EXPECT_EQ(Stash.stashGrids[0][0][0], Stash.stashList.size());
+	EXPECT_EQ(Stash.stashGrids[0][1][1], Stash.stashList.size());
+	EXPECT_EQ(Stash.stashGrids[0][2][0], 0);
+	EXPECT_TRUE(Stash.dirtyPages.count(0) != 0);
+}
+
+TEST_F(StashTest, ItemFlagsFollowPlayerStats)
+{
+	MyPlayer = &Players[MyPlayerId];
+	CreatePlayer(MyPlayerId, HeroClass::Warrior);
+	Player &player = *MyPlayer;
+
+	PlaceItem(0, { 0, 0 }, 1);
+	Stash.stashList.back()._iMinStr = player._pStrength + 1;
+	CalcPlrInv(player, false);
+	EXPECT_FALSE(Stash.stashList.back()._iStatFlag);
+
+	CalcPlrInv(player, false);
+	EXPECT_FALSE(Stash.stashList.back()._iStatFlag);
+
+	player._pBaseStr++;
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
+	CalcPlrInv(player, false);
+	EXPECT_TRUE(Stash.stashList.back()._iStatFlag);
+}
+
+TEST_F(StashTest, BookRequirementsFollowSpellLevels)
+{
+	MyPlayer = &Players[MyPlayerId];
+	CreatePlayer(MyPlayerId, HeroClass::Sorcerer);
+	Player &player = *MyPlayer;
+
+	PlaceItem(0, { 0, 0 }, 1);
+	Stash.stashList.back()._iMiscId = IMISC_BOOK;
+	Stash.stashList.back()._iSpell = SPL_FIREBOLT;
+	CalcPlrInv(player, false);
+	const int minMagic = Stash.stashList.back()._iMinMag;
+
+	player._pSplLvl[SPL_FIREBOLT]++;
+	player.MarkStatsDirty(PlayerStatsDirty::Level);
+	CalcPlrInv(player, false);
+	EXPECT_GT(Stash.stashList.back()._iMinMag, minMagic);
+}